@@ -1,11 +1,13 @@
 #version 330 core
 in vec2 texCoord;
+flat in float textureLayer;
 
 out vec4 FragColor;
 
 uniform float uTime;
-uniform sampler2D uTexture;
-uniform sampler2D uTexture2;
+// Textures are arrays, the second of a single layer
+uniform sampler2DArray uTexture;
+uniform sampler2DArray uTexture2;
 uniform float uMix;
 
 const float PI = 3.1415926535897932384626433832795;
@@ -23,8 +25,8 @@ void main() {
   float radius = (oscillation.y * sqrt(2.0f)) / 2.0f;
   float alpha = ceil(radius - dist);
 
-  vec4 texColor = texture(uTexture, texCoord);
-  vec4 texColor2 = texture(uTexture2, texCoord);
+  vec4 texColor = texture(uTexture, vec3(texCoord, textureLayer));
+  vec4 texColor2 = texture(uTexture2, vec3(texCoord, 0.0f));
   texColor2 = vec4(texColor2.rgb, texColor2.a * alpha * uMix);
   FragColor = vec4(mix(texColor.rgb, texColor2.rgb, texColor2.a), 1.0f);
 }
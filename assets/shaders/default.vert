@@ -1,14 +1,19 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+// Per-instance model matrix, occupying locations 2-5
+layout (location = 2) in mat4 aModel;
+// Per-instance layer of the texture array bound to uTexture
+layout (location = 6) in float aTextureLayer;
 
 out vec2 texCoord;
+flat out float textureLayer;
 
-uniform mat4 uModel;
 uniform mat4 uView;
 uniform mat4 uProjection;
 
 void main() {
-  gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0f);
+  gl_Position = uProjection * uView * aModel * vec4(aPos, 1.0f);
   texCoord = aTexCoord;
+  textureLayer = aTextureLayer;
 }
@@ -0,0 +1,154 @@
+// Microbenchmark for the BVH: build (serial and parallel), refit and the
+// three query types over N random boxes.
+//
+// Usage: lizual_bvh_bench [object count] [query count]
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BVH.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "Simd.h"
+
+namespace {
+constexpr size_t kDefaultObjectCount = 1'000'000;
+constexpr size_t kDefaultQueryCount = 1'000;
+// Objects are scattered in a cube of this half size
+constexpr float kWorldExtent = 500.0f;
+
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+    .count();
+}
+
+std::vector<AABB> MakeBoxes(size_t count, std::mt19937& rng) {
+  std::uniform_real_distribution<float> position(-kWorldExtent, kWorldExtent);
+  std::uniform_real_distribution<float> halfSize(0.1f, 2.0f);
+  std::vector<AABB> boxes(count);
+  for (AABB& box : boxes) {
+    const glm::vec3 center(position(rng), position(rng), position(rng));
+    const glm::vec3 extent(halfSize(rng));
+    box = {center - extent, center + extent};
+  }
+  return boxes;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t objectCount =
+    argc > 1 ? std::strtoull(argv[1], nullptr, 10) : kDefaultObjectCount;
+  const size_t queryCount =
+    argc > 2 ? std::strtoull(argv[2], nullptr, 10) : kDefaultQueryCount;
+
+  std::mt19937 rng(1234);
+  std::vector<AABB> boxes = MakeBoxes(objectCount, rng);
+  JobSystem jobs;
+  std::printf(
+    "%zu objects, %zu queries, %u threads, %s kernels\n",
+    objectCount,
+    queryCount,
+    static_cast<unsigned>(jobs.GetThreadCount()),
+    GetSimdLevelName(GetSupportedSimdLevel())
+  );
+
+  BVH bvh;
+  Clock::time_point start = Clock::now();
+  bvh.Build(boxes);
+  std::printf("build (serial):   %9.2f ms\n", MillisecondsSince(start));
+
+  start = Clock::now();
+  bvh.Build(boxes, &jobs);
+  std::printf("build (parallel): %9.2f ms\n", MillisecondsSince(start));
+  std::printf("nodes:            %9zu\n", bvh.GetNodeCount());
+
+  // Move every object a little, as an animation step would
+  std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+  for (AABB& box : boxes) {
+    const glm::vec3 offset(jitter(rng), jitter(rng), jitter(rng));
+    box = {box.min + offset, box.max + offset};
+  }
+  start = Clock::now();
+  bvh.Refit(boxes);
+  std::printf("refit:            %9.2f ms\n", MillisecondsSince(start));
+
+  // Frustum queries from random viewpoints, compared to culling every box
+  std::uniform_real_distribution<float> position(-kWorldExtent, kWorldExtent);
+  std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+  const glm::mat4 projection =
+    glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+  BoundingBoxes flatBoxes;
+  flatBoxes.Resize(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    flatBoxes.Set(i, boxes[i].min, boxes[i].max);
+  }
+  std::vector<uint32_t> results;
+  std::vector<uint32_t> flatResults(boxes.size());
+  size_t visibleTotal = 0;
+  double bvhFrustumMs = 0.0;
+  double flatFrustumMs = 0.0;
+  const size_t frustumQueryCount = std::max<size_t>(queryCount / 10, 1);
+  for (size_t i = 0; i < frustumQueryCount; ++i) {
+    const glm::vec3 eye(position(rng), position(rng), position(rng));
+    const glm::vec3 forward(direction(rng), direction(rng), direction(rng));
+    const Frustum frustum = Frustum::FromMatrix(
+      projection * glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f))
+    );
+    results.clear();
+    start = Clock::now();
+    bvh.QueryFrustum(frustum, results);
+    bvhFrustumMs += MillisecondsSince(start);
+    visibleTotal += results.size();
+
+    start = Clock::now();
+    CullAABBs(frustum, flatBoxes, 0, boxes.size(), flatResults.data());
+    flatFrustumMs += MillisecondsSince(start);
+  }
+  std::printf(
+    "frustum query:    %9.4f ms (flat SIMD cull %.4f ms, %zu visible)\n",
+    bvhFrustumMs / frustumQueryCount,
+    flatFrustumMs / frustumQueryCount,
+    visibleTotal / frustumQueryCount
+  );
+
+  size_t hitCount = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < queryCount; ++i) {
+    const glm::vec3 origin(position(rng), position(rng), position(rng));
+    const glm::vec3 rayDirection(
+      direction(rng), direction(rng), direction(rng)
+    );
+    if (glm::dot(rayDirection, rayDirection) == 0.0f) { continue; }
+    hitCount += bvh.Raycast(origin, rayDirection).has_value();
+  }
+  std::printf(
+    "raycast:          %9.4f ms (%zu / %zu hit)\n",
+    MillisecondsSince(start) / queryCount,
+    hitCount,
+    queryCount
+  );
+
+  size_t radiusTotal = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < queryCount; ++i) {
+    const glm::vec3 center(position(rng), position(rng), position(rng));
+    results.clear();
+    bvh.QueryRadius(center, 25.0f, results);
+    radiusTotal += results.size();
+  }
+  std::printf(
+    "radius query:     %9.4f ms (%zu found)\n",
+    MillisecondsSince(start) / queryCount,
+    radiusTotal / queryCount
+  );
+  return 0;
+}
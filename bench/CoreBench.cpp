@@ -0,0 +1,547 @@
+// Microbenchmarks for the engine's hot paths: camera math, uniform setters,
+// config loading, model matrix building, mesh/texture loading and texture
+// cooking.
+//
+// Benchmarks that need OpenGL run in a hidden window's context, falling back
+// to SDL's offscreen driver on machines without a display, and are skipped if
+// no context can be created.
+//
+// Usage: lizual_bench [--filter substring] [--repetitions N]
+//                     [--min-sample-ms ms] [--warmup-ms ms] [--output path]
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <SDL3/SDL.h>
+#include <stb_image.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "BlockCompression.h"
+#include "Camera.h"
+#include "config.h"
+#include "Mesh.h"
+#include "MicroBenchmark.h"
+#include "MipGenerator.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "Simd.h"
+#include "TextureFile.h"
+#include "TransformBatch.h"
+
+namespace {
+const std::filesystem::path kAssetsDir = LIZUAL_ASSETS_DIR;
+const std::filesystem::path kConfigPath = kAssetsDir / "config.txt";
+const std::filesystem::path kVertexShaderPath =
+  kAssetsDir / "shaders/default.vert";
+const std::filesystem::path kFragmentShaderPath =
+  kAssetsDir / "shaders/default.frag";
+const std::filesystem::path kContainerTexturePath =
+  kAssetsDir / "textures/container.jpg";
+// Cooked from the container texture by the texture benchmarks
+const std::filesystem::path kCookedContainerPath =
+  std::filesystem::temp_directory_path() / "lizual_bench_container.ltex";
+// Packed from the assets directory by the archive benchmarks
+const std::filesystem::path kAssetArchivePath =
+  std::filesystem::temp_directory_path() / "lizual_bench_assets.lpak";
+
+// Objects per model matrix batch, about a frame's worth of visible objects
+constexpr uint32_t kMatrixBatchSize = 10'000;
+
+struct Arguments {
+  MicroBenchmark::Options options;
+  std::filesystem::path output = "lizual_bench.json";
+};
+
+bool ParseArguments(int argc, char** argv, Arguments& arguments) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view name = argv[i];
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+      return false;
+    }
+    const char* value = argv[++i];
+    if (name == "--filter") {
+      arguments.options.filter = value;
+    } else if (name == "--repetitions") {
+      arguments.options.repetitions =
+        static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if (name == "--min-sample-ms") {
+      arguments.options.minSampleMs = std::strtod(value, nullptr);
+    } else if (name == "--warmup-ms") {
+      arguments.options.warmupMs = std::strtod(value, nullptr);
+    } else if (name == "--output") {
+      arguments.output = value;
+    } else {
+      std::fprintf(stderr, "Unknown argument: %s\n", argv[i - 1]);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Hidden window with a current GL context, or a null window if none could be
+// created
+struct GLContext {
+  SDL_Window* window = nullptr;
+  SDL_GLContext context = nullptr;
+
+  ~GLContext() {
+    if (context != nullptr) { SDL_GL_DestroyContext(context); }
+    if (window != nullptr) { SDL_DestroyWindow(window); }
+    SDL_Quit();
+  }
+};
+
+bool TryCreateGLContext(GLContext& gl, const char* videoDriver) {
+  if (videoDriver != nullptr) {
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, videoDriver);
+  }
+  if (!SDL_Init(SDL_INIT_VIDEO)) { return false; }
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+  gl.window = SDL_CreateWindow(
+    "lizual_bench", 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+  );
+  if (gl.window != nullptr) {
+    gl.context = SDL_GL_CreateContext(gl.window);
+  }
+  if (gl.context != nullptr &&
+      gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress) != 0) {
+    return true;
+  }
+
+  if (gl.context != nullptr) { SDL_GL_DestroyContext(gl.context); }
+  if (gl.window != nullptr) { SDL_DestroyWindow(gl.window); }
+  gl.context = nullptr;
+  gl.window = nullptr;
+  SDL_Quit();
+  return false;
+}
+
+void RunCameraBenchmarks(MicroBenchmark& bench) {
+  Camera camera(glm::vec3(1.0f, 2.0f, 3.0f), 10.0f, 20.0f);
+  bench.Run("Camera::GetViewMatrix", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(camera.GetViewMatrix());
+      // Keep the camera opaque so the loop is not folded
+      DoNotOptimize(camera);
+    }
+  });
+  bench.Run("Camera::GetFrustum", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(camera.GetFrustum(16.0f / 9.0f));
+      DoNotOptimize(camera);
+    }
+  });
+  bench.Run("Camera::Move", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      camera.Move(glm::vec3(0.01f, 0.0f, -0.01f));
+      DoNotOptimize(camera);
+    }
+  });
+  bench.Run("Camera::Rotate", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      camera.Rotate(glm::vec2(0.0f, 0.01f));
+      DoNotOptimize(camera);
+    }
+  });
+}
+
+void RunConfigBenchmarks(MicroBenchmark& bench) {
+  bench.Run("load_config_from_file", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      load_config_from_file(kConfigPath);
+    }
+  });
+}
+
+uint64_t SumBytes(std::span<const uint8_t> data) {
+  return std::accumulate(data.begin(), data.end(), uint64_t{0});
+}
+
+void RunAssetArchiveBenchmarks(MicroBenchmark& bench) {
+  // Every asset, read as loose files and from an archive of the same files.
+  // Both are in the page cache after the first sample, so the difference is
+  // the cost of opening and reading file by file.
+  std::vector<std::filesystem::path> paths;
+  for (const std::filesystem::directory_entry& entry :
+       std::filesystem::recursive_directory_iterator(kAssetsDir)) {
+    if (entry.is_regular_file()) { paths.push_back(entry.path()); }
+  }
+  auto readFile = [](const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+  };
+  std::vector<std::vector<uint8_t>> contents;
+  std::vector<AssetArchiveInput> inputs;
+  for (const std::filesystem::path& path : paths) {
+    contents.push_back(readFile(path));
+  }
+  for (size_t i = 0; i < paths.size(); ++i) {
+    inputs.push_back(
+      {std::filesystem::relative(paths[i], kAssetsDir).generic_string(),
+       contents[i]}
+    );
+  }
+  std::string error;
+  if (!AssetArchive::Write(kAssetArchivePath, inputs, true, error)) {
+    std::fprintf(stderr, "Skipping asset archive: %s\n", error.c_str());
+    return;
+  }
+
+  bench.Run("Read loose files/assets", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      uint64_t sum = 0;
+      for (const std::filesystem::path& path : paths) {
+        sum += SumBytes(readFile(path));
+      }
+      DoNotOptimize(sum);
+    }
+  });
+  bench.Run("AssetArchive::Open+Read/assets", [&](uint64_t iterations) {
+    std::vector<uint8_t> buffer;
+    for (uint64_t i = 0; i < iterations; ++i) {
+      const std::optional<AssetArchive> archive =
+        AssetArchive::Open(kAssetArchivePath, error);
+      uint64_t sum = 0;
+      for (const AssetArchiveInput& input : inputs) {
+        sum += SumBytes(*archive->Read(input.name, buffer));
+      }
+      DoNotOptimize(sum);
+    }
+  });
+}
+
+void RunMatrixBenchmarks(MicroBenchmark& bench) {
+  const Scene scene = Scene::Generate(
+    {SceneDistribution::kUniform, kMatrixBatchSize, 0.0f, 1, 1, 1}
+  );
+  const TransformBatch& batch = scene.GetTransforms();
+  std::vector<glm::mat4> matrices(batch.Size());
+
+  bench.Run(
+    "BuildModelMatricesReference",
+    [&](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; ++i) {
+        BuildModelMatricesReference(batch, 0, batch.Size(), matrices.data());
+        DoNotOptimize(matrices.data());
+      }
+    },
+    batch.Size()
+  );
+  for (const SimdLevel level :
+       {SimdLevel::kScalar, SimdLevel::kSSE2, SimdLevel::kAVX2}) {
+    if (level > GetSupportedSimdLevel()) { continue; }
+    bench.Run(
+      std::string("BuildModelMatrices/") + GetSimdLevelName(level),
+      [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+          BuildModelMatrices(batch, 0, batch.Size(), matrices.data(), level);
+          DoNotOptimize(matrices.data());
+        }
+      },
+      batch.Size()
+    );
+  }
+
+  // The gather that selects visible objects before the kernels run
+  std::vector<uint32_t> everyOther(batch.Size() / 2);
+  std::iota(everyOther.begin(), everyOther.end(), 0u);
+  for (uint32_t& index : everyOther) { index *= 2; }
+  TransformBatch gathered;
+  bench.Run(
+    "TransformBatch::Gather",
+    [&](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; ++i) {
+        gathered.Gather(batch, everyOther);
+        DoNotOptimize(gathered.positionX.data());
+      }
+    },
+    everyOther.size()
+  );
+}
+
+void RunMeshBenchmarks(MicroBenchmark& bench) {
+  const std::vector<Vertex> sphere = BuildSphereTriangles(64, 32);
+  bench.Run(
+    "BuildIndexedMesh/sphere64",
+    [&](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; ++i) {
+        DoNotOptimize(BuildIndexedMesh(sphere));
+      }
+    },
+    sphere.size() / 3
+  );
+}
+
+void RunTextureDecodeBenchmarks(MicroBenchmark& bench) {
+  const std::string path = kContainerTexturePath.string();
+  bench.Run("stbi_load/container.jpg", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      int width, height, channels;
+      unsigned char* data =
+        stbi_load(path.c_str(), &width, &height, &channels, 0);
+      DoNotOptimize(data);
+      stbi_image_free(data);
+    }
+  });
+
+  int width, height, channels;
+  unsigned char* pixels =
+    stbi_load(path.c_str(), &width, &height, &channels, 4);
+  if (pixels == nullptr) {
+    std::fprintf(stderr, "Skipping mip benchmarks: failed to load texture\n");
+    return;
+  }
+  const std::span<const uint8_t> image(
+    pixels, static_cast<size_t>(width) * height * 4
+  );
+  for (const SimdLevel level :
+       {SimdLevel::kScalar, SimdLevel::kSSE2, SimdLevel::kAVX2}) {
+    if (level > GetSupportedSimdLevel()) { continue; }
+    bench.Run(
+      std::string("GenerateMipChain/") + GetSimdLevelName(level),
+      [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+          DoNotOptimize(GenerateMipChain(image, width, height, {}, level));
+        }
+      },
+      image.size() / 4
+    );
+  }
+  // Single threaded, so the numbers compare across machines
+  for (const TextureFormat format :
+       {TextureFormat::kBC1, TextureFormat::kBC3, TextureFormat::kBC7}) {
+    for (const SimdLevel level :
+         {SimdLevel::kScalar, SimdLevel::kSSE2, SimdLevel::kAVX2}) {
+      if (level > GetSupportedSimdLevel()) { continue; }
+      const BlockSettings settings{BlockQuality::kNormal, level};
+      bench.Run(
+        std::string("CompressImage/") + GetTextureFormatName(format) + "/" +
+          GetSimdLevelName(level),
+        [&](uint64_t iterations) {
+          for (uint64_t i = 0; i < iterations; ++i) {
+            DoNotOptimize(
+              CompressImage(image, width, height, format, settings)
+            );
+          }
+        },
+        image.size() / 4
+      );
+    }
+  }
+
+  // What the app does instead of decoding: map the cooked file and read it.
+  // The file is in the page cache after the first sample, so this is the
+  // warm case.
+  const std::vector<MipLevel> mips = GenerateMipChain(image, width, height);
+  stbi_image_free(pixels);
+  std::vector<TextureLevel> levels;
+  for (const MipLevel& mip : mips) {
+    levels.push_back({mip.width, mip.height, mip.pixels});
+  }
+  std::string error;
+  if (!TextureFile::Write(
+        kCookedContainerPath, TextureFormat::kRGBA8, levels, error
+      )) {
+    std::fprintf(stderr, "Skipping cooked texture: %s\n", error.c_str());
+    return;
+  }
+  bench.Run("TextureFile::Open+read/container.ltex", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      const std::optional<TextureFile> file =
+        TextureFile::Open(kCookedContainerPath, error);
+      uint8_t sum = 0;
+      for (const uint8_t byte : file->GetLevelData()) { sum += byte; }
+      DoNotOptimize(sum);
+    }
+  });
+}
+
+void RunGLBenchmarks(MicroBenchmark& bench) {
+  std::unique_ptr<Shader> shader;
+  try {
+    shader = std::make_unique<Shader>(kVertexShaderPath, kFragmentShaderPath);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "Skipping GL benchmarks: %s\n", e.what());
+    return;
+  }
+  shader->Use();
+
+  const UniformHandle<glm::mat4> view =
+    shader->GetUniform<glm::mat4>("uView");
+  const UniformHandle<float> time = shader->GetUniform<float>("uTime");
+  // Setters skip values a uniform already has, so alternate between two to
+  // measure the GL call, and repeat one to measure the skip
+  const glm::mat4 matrices[2] = {glm::mat4(1.0f), glm::mat4(2.0f)};
+  bench.Run("Shader::Set/mat4", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      shader->Set(view, matrices[i % 2]);
+    }
+  });
+  bench.Run("Shader::Set/mat4 unchanged", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      shader->Set(view, matrices[0]);
+    }
+  });
+  bench.Run("Shader::Set/float", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      shader->Set(time, static_cast<float>(i));
+    }
+  });
+  bench.Run("Shader::SetFloat/by name", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      shader->SetFloat("uMix", static_cast<float>(i));
+    }
+  });
+  bench.Run("Shader::SetUniformMatrix4fv/by name", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      shader->SetUniformMatrix4fv("uProjection", matrices[i % 2]);
+    }
+  });
+
+  // Uploads include a glFinish per sample so the driver's deferred work is
+  // counted
+  const MeshData sphere = BuildIndexedMesh(BuildSphereTriangles(64, 32));
+  bench.Run("Mesh upload/sphere64", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) { Mesh mesh(sphere); }
+    glFinish();
+  });
+
+  int width, height, channels;
+  unsigned char* pixels = stbi_load(
+    kContainerTexturePath.string().c_str(), &width, &height, &channels, 3
+  );
+  if (pixels == nullptr) {
+    std::fprintf(stderr, "Skipping texture upload: failed to load texture\n");
+    return;
+  }
+  bench.Run(
+    "Texture upload+mipmaps/container.jpg",
+    [&](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; ++i) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+          GL_TEXTURE_2D,
+          0,
+          GL_RGB,
+          width,
+          height,
+          0,
+          GL_RGB,
+          GL_UNSIGNED_BYTE,
+          pixels
+        );
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glDeleteTextures(1, &texture);
+      }
+      glFinish();
+    },
+    static_cast<uint64_t>(width) * height * 3
+  );
+  stbi_image_free(pixels);
+
+  // Cooked by RunTextureDecodeBenchmarks
+  std::string error;
+  const std::optional<TextureFile> cooked =
+    TextureFile::Open(kCookedContainerPath, error);
+  if (!cooked) {
+    std::fprintf(stderr, "Skipping cooked texture upload: %s\n", error.c_str());
+    return;
+  }
+  if (!GLAD_GL_VERSION_4_2) {
+    std::fprintf(stderr, "Skipping cooked texture upload: needs GL 4.2\n");
+    return;
+  }
+  bench.Run(
+    "Texture upload/container.ltex",
+    [&](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; ++i) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(
+          GL_TEXTURE_2D,
+          static_cast<GLsizei>(cooked->GetLevelCount()),
+          GL_RGBA8,
+          cooked->GetWidth(),
+          cooked->GetHeight()
+        );
+        for (size_t level = 0; level < cooked->GetLevelCount(); ++level) {
+          const TextureLevel& data = cooked->GetLevel(level);
+          glTexSubImage2D(
+            GL_TEXTURE_2D,
+            static_cast<GLint>(level),
+            0,
+            0,
+            data.width,
+            data.height,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            data.data.data()
+          );
+        }
+        glDeleteTextures(1, &texture);
+      }
+      glFinish();
+    },
+    cooked->GetLevelData().size()
+  );
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Arguments arguments;
+  if (!ParseArguments(argc, argv, arguments)) { return 2; }
+
+  std::vector<std::pair<std::string, std::string>> context{
+    {"simd_level", GetSimdLevelName(GetSupportedSimdLevel())},
+  };
+  MicroBenchmark bench(arguments.options);
+  RunCameraBenchmarks(bench);
+  RunConfigBenchmarks(bench);
+  RunAssetArchiveBenchmarks(bench);
+  RunMatrixBenchmarks(bench);
+  RunMeshBenchmarks(bench);
+  RunTextureDecodeBenchmarks(bench);
+
+  {
+    GLContext gl;
+    if (TryCreateGLContext(gl, nullptr) ||
+        TryCreateGLContext(gl, "offscreen")) {
+      const GLubyte* renderer = glGetString(GL_RENDERER);
+      const char* videoDriver = SDL_GetCurrentVideoDriver();
+      context.emplace_back(
+        "renderer",
+        renderer != nullptr ? reinterpret_cast<const char*>(renderer) : ""
+      );
+      context.emplace_back(
+        "video_driver", videoDriver != nullptr ? videoDriver : ""
+      );
+      RunGLBenchmarks(bench);
+    } else {
+      std::fprintf(
+        stderr, "Skipping GL benchmarks: no context (%s)\n", SDL_GetError()
+      );
+    }
+  }
+
+  if (!bench.WriteJson(arguments.output, context)) { return 1; }
+  std::printf("Wrote %s\n", arguments.output.string().c_str());
+  return 0;
+}
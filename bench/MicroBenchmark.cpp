@@ -0,0 +1,142 @@
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+#include "JsonWriter.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Nanoseconds one call of body takes for the given iteration count
+double TimeIterations(const MicroBenchmark::Body& body, uint64_t iterations) {
+  const Clock::time_point start = Clock::now();
+  body(iterations);
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+    .count();
+}
+}  // namespace
+
+MicroBenchmark::MicroBenchmark(const Options& options) : options_(options) {
+  options_.repetitions = std::max(options_.repetitions, 1u);
+}
+
+void MicroBenchmark::Run(
+  std::string_view name, const Body& body, uint64_t itemsPerIteration
+) {
+  if (name.find(options_.filter) == std::string_view::npos) { return; }
+
+  // Calibrate: double the iteration count until a sample is long enough. The
+  // calibration runs count towards the warmup.
+  const double minSampleNs = options_.minSampleMs * 1e6;
+  const double warmupNs = options_.warmupMs * 1e6;
+  uint64_t iterations = 1;
+  double warmedUpNs = 0.0;
+  while (true) {
+    const double elapsedNs = TimeIterations(body, iterations);
+    warmedUpNs += elapsedNs;
+    if (elapsedNs >= minSampleNs) { break; }
+    // Jump close to the target once the timer resolution stops dominating
+    const double scale = elapsedNs > minSampleNs / 100.0
+                           ? 1.2 * minSampleNs / elapsedNs
+                           : 10.0;
+    iterations = std::max(
+      iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 10.0))
+    );
+  }
+  while (warmedUpNs < warmupNs) {
+    warmedUpNs += TimeIterations(body, iterations);
+  }
+
+  Result result{std::string(name), iterations, itemsPerIteration, {}};
+  result.samplesNs.reserve(options_.repetitions);
+  for (uint32_t i = 0; i < options_.repetitions; ++i) {
+    result.samplesNs.push_back(
+      TimeIterations(body, iterations) / static_cast<double>(iterations)
+    );
+  }
+
+  std::vector<double> sorted = result.samplesNs;
+  std::sort(sorted.begin(), sorted.end());
+  const size_t count = sorted.size();
+  result.minNs = sorted.front();
+  result.maxNs = sorted.back();
+  result.medianNs = count % 2 == 1
+                      ? sorted[count / 2]
+                      : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+  result.meanNs = std::accumulate(sorted.begin(), sorted.end(), 0.0) / count;
+  double squaredDeviations = 0.0;
+  for (const double sample : sorted) {
+    squaredDeviations += (sample - result.meanNs) * (sample - result.meanNs);
+  }
+  result.stddevNs =
+    count > 1 ? std::sqrt(squaredDeviations / (count - 1)) : 0.0;
+
+  std::printf(
+    "%-44s %12.2f ns  +-%5.1f%%  min %12.2f ns",
+    result.name.c_str(),
+    result.medianNs,
+    result.meanNs > 0.0 ? 100.0 * result.stddevNs / result.meanNs : 0.0,
+    result.minNs
+  );
+  if (itemsPerIteration > 1) {
+    std::printf("  %9.3f ns/item", result.medianNs / itemsPerIteration);
+  }
+  std::printf("\n");
+  std::fflush(stdout);
+  results_.push_back(std::move(result));
+}
+
+bool MicroBenchmark::WriteJson(
+  const std::filesystem::path& path,
+  const std::vector<std::pair<std::string, std::string>>& context
+) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    std::fprintf(
+      stderr, "Failed to open %s for writing\n", path.string().c_str()
+    );
+    return false;
+  }
+
+  JsonWriter writer(out);
+  writer.BeginObject();
+  writer.Key("context");
+  writer.BeginObject();
+  for (const auto& [key, value] : context) { writer.Field(key, value); }
+  writer.Field("repetitions", options_.repetitions);
+  writer.Field("min_sample_ms", options_.minSampleMs);
+  writer.Field("warmup_ms", options_.warmupMs);
+  writer.EndObject();
+
+  writer.Key("benchmarks");
+  writer.BeginArray();
+  for (const Result& result : results_) {
+    writer.BeginObject();
+    writer.Field("name", std::string_view(result.name));
+    writer.Field("iterations_per_sample", result.iterationsPerSample);
+    writer.Field("items_per_iteration", result.itemsPerIteration);
+    writer.Field("min_ns", result.minNs);
+    writer.Field("median_ns", result.medianNs);
+    writer.Field("mean_ns", result.meanNs);
+    writer.Field("stddev_ns", result.stddevNs);
+    writer.Field("max_ns", result.maxNs);
+    writer.Key("samples_ns");
+    writer.BeginArray();
+    for (const double sample : result.samplesNs) { writer.Value(sample); }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  if (!out) {
+    std::fprintf(stderr, "Failed to write %s\n", path.string().c_str());
+    return false;
+  }
+  return true;
+}
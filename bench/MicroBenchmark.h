@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Keeps the compiler from optimizing away a value a benchmark computes, or
+// from hoisting the computation out of the loop
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static const void* volatile sink;
+  sink = &value;
+#endif
+}
+
+// Minimal microbenchmark runner. Each benchmark is calibrated to an iteration
+// count that makes one sample last at least Options::minSampleMs, warmed up,
+// and then sampled Options::repetitions times. Results are reported per
+// iteration, with the raw samples kept so runs can be compared statistically.
+class MicroBenchmark {
+ public:
+  struct Options {
+    uint32_t repetitions = 20;
+    double minSampleMs = 5.0;
+    // Unmeasured run time before sampling, to warm caches, clocks and drivers
+    double warmupMs = 50.0;
+    // Only benchmarks whose name contains this run
+    std::string filter;
+  };
+
+  struct Result {
+    std::string name;
+    uint64_t iterationsPerSample;
+    // Items (objects, vertices, bytes...) processed per iteration, for
+    // throughput
+    uint64_t itemsPerIteration;
+    // Nanoseconds per iteration, one per sample in the order they ran
+    std::vector<double> samplesNs;
+    double minNs = 0.0;
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double stddevNs = 0.0;
+    double maxNs = 0.0;
+  };
+
+  // Runs the body `iterations` times per call
+  using Body = std::function<void(uint64_t iterations)>;
+
+  explicit MicroBenchmark(const Options& options);
+
+  // Measures body right away unless it is filtered out, and prints a line
+  // with the result
+  void Run(
+    std::string_view name, const Body& body, uint64_t itemsPerIteration = 1
+  );
+
+  const std::vector<Result>& GetResults() const { return results_; }
+
+  // Writes the results and context strings (e.g. the CPU kernel level or GL
+  // renderer) as JSON. Returns false if the file could not be written.
+  bool WriteJson(
+    const std::filesystem::path& path,
+    const std::vector<std::pair<std::string, std::string>>& context
+  ) const;
+
+ private:
+  Options options_;
+  std::vector<Result> results_;
+};
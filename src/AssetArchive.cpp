@@ -0,0 +1,252 @@
+#include "AssetArchive.h"
+
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "Hash.h"
+#include "Lz4.h"
+
+namespace {
+constexpr uint32_t kMagic = 0x4b41'504c;  // "LPAK"
+constexpr uint32_t kVersion = 1;
+// File data starts on page boundaries
+constexpr uint64_t kDataAlignment = 4096;
+
+enum class Compression : uint32_t {
+  kNone = 0,
+  kLz4 = 1,
+};
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+};
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+}  // namespace
+
+// An index entry as stored in the file
+struct AssetArchive::Entry {
+  uint64_t nameHash;
+  uint64_t offset;
+  uint64_t storedSize;
+  uint64_t size;
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  Compression compression;
+  uint32_t reserved;
+};
+
+std::optional<AssetArchive> AssetArchive::Open(
+  const std::filesystem::path& path, std::string& error
+) {
+  std::optional<MappedFile> file = MappedFile::Open(path, error);
+  if (!file) { return std::nullopt; }
+  const std::span<const uint8_t> bytes = file->GetData();
+  auto fail = [&](const std::string& problem) {
+    error = path.string() + ": " + problem;
+    return std::nullopt;
+  };
+
+  FileHeader header;
+  if (bytes.size() < sizeof(header)) { return fail("truncated header"); }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) { return fail("not an asset archive"); }
+  if (header.version != kVersion) {
+    return fail("unsupported version " + std::to_string(header.version));
+  }
+  if (bytes.size() <
+      sizeof(FileHeader) + uint64_t{header.entryCount} * sizeof(Entry)) {
+    return fail("truncated index");
+  }
+
+  // Check every entry once here, so lookups can trust the index
+  AssetArchive archive(std::move(*file), header.entryCount);
+  for (size_t i = 0; i < archive.entryCount_; ++i) {
+    const Entry entry = archive.GetEntry(i);
+    // LZ4 expands by 255 times at most, which also bounds what a corrupt
+    // size can make Read allocate
+    const bool validCompression =
+      (entry.compression == Compression::kLz4 &&
+       entry.size / 255 <= entry.storedSize) ||
+      (entry.compression == Compression::kNone &&
+       entry.storedSize == entry.size);
+    if (!validCompression ||
+        uint64_t{entry.nameOffset} + entry.nameLength > bytes.size() ||
+        entry.offset > bytes.size() ||
+        entry.storedSize > bytes.size() - entry.offset) {
+      return fail("invalid entry " + std::to_string(i));
+    }
+    if (i > 0 && archive.GetEntry(i - 1).nameHash > entry.nameHash) {
+      return fail("index not sorted");
+    }
+  }
+  return archive;
+}
+
+bool AssetArchive::Write(
+  const std::filesystem::path& path,
+  std::span<const AssetArchiveInput> inputs,
+  bool compress,
+  std::string& error
+) {
+  // Index order, by hash and then name so duplicates are adjacent
+  std::vector<const AssetArchiveInput*> sorted;
+  for (const AssetArchiveInput& input : inputs) { sorted.push_back(&input); }
+  std::sort(
+    sorted.begin(),
+    sorted.end(),
+    [](const AssetArchiveInput* a, const AssetArchiveInput* b) {
+      const uint64_t hashA = HashFnv1a64(a->name);
+      const uint64_t hashB = HashFnv1a64(b->name);
+      return hashA != hashB ? hashA < hashB : a->name < b->name;
+    }
+  );
+  for (size_t i = 1; i < sorted.size(); ++i) {
+    if (sorted[i]->name == sorted[i - 1]->name) {
+      error = "duplicate entry " + sorted[i]->name;
+      return false;
+    }
+  }
+
+  std::vector<Entry> index;
+  std::vector<std::vector<uint8_t>> compressed(sorted.size());
+  uint64_t nameOffset = sizeof(FileHeader) + sorted.size() * sizeof(Entry);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    const AssetArchiveInput& input = *sorted[i];
+    Compression compression = Compression::kNone;
+    uint64_t storedSize = input.data.size();
+    if (compress) {
+      compressed[i] = CompressLz4(input.data);
+      if (compressed[i].size() <= input.data.size() / 8 * 7) {
+        compression = Compression::kLz4;
+        storedSize = compressed[i].size();
+      } else {
+        compressed[i].clear();
+      }
+    }
+    index.push_back(
+      {HashFnv1a64(input.name),
+       0,
+       storedSize,
+       input.data.size(),
+       static_cast<uint32_t>(nameOffset),
+       static_cast<uint32_t>(input.name.size()),
+       compression,
+       0}
+    );
+    nameOffset += input.name.size();
+  }
+  uint64_t offset = AlignUp(nameOffset);
+  for (Entry& entry : index) {
+    entry.offset = offset;
+    offset = AlignUp(offset + entry.storedSize);
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    error = "failed to open " + path.string() + " for writing";
+    return false;
+  }
+  const FileHeader header{
+    kMagic, kVersion, static_cast<uint32_t>(index.size()), 0
+  };
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(
+    reinterpret_cast<const char*>(index.data()),
+    static_cast<std::streamsize>(index.size() * sizeof(Entry))
+  );
+  for (const AssetArchiveInput* input : sorted) {
+    file.write(
+      input->name.data(), static_cast<std::streamsize>(input->name.size())
+    );
+  }
+  uint64_t position = nameOffset;
+  const char zeros[kDataAlignment] = {};
+  for (size_t i = 0; i < index.size(); ++i) {
+    file.write(zeros, static_cast<std::streamsize>(index[i].offset - position));
+    const std::span<const uint8_t> stored =
+      index[i].compression == Compression::kLz4 ? std::span(compressed[i])
+                                                 : sorted[i]->data;
+    file.write(
+      reinterpret_cast<const char*>(stored.data()),
+      static_cast<std::streamsize>(stored.size())
+    );
+    position = index[i].offset + stored.size();
+  }
+  if (!file) {
+    error = "failed to write " + path.string();
+    return false;
+  }
+  return true;
+}
+
+AssetArchive::Entry AssetArchive::GetEntry(size_t index) const {
+  Entry entry;
+  std::memcpy(
+    &entry,
+    file_.GetData().data() + sizeof(FileHeader) + index * sizeof(Entry),
+    sizeof(entry)
+  );
+  return entry;
+}
+
+size_t AssetArchive::Find(std::string_view name) const {
+  const uint64_t hash = HashFnv1a64(name);
+  // Binary search straight on the mapped index for the first entry with the
+  // hash, then compare names in case of collisions
+  size_t first = 0;
+  size_t count = entryCount_;
+  while (count > 0) {
+    const size_t half = count / 2;
+    if (GetEntry(first + half).nameHash < hash) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  const uint8_t* data = file_.GetData().data();
+  for (size_t i = first; i < entryCount_; ++i) {
+    const Entry entry = GetEntry(i);
+    if (entry.nameHash != hash) { break; }
+    const std::string_view entryName(
+      reinterpret_cast<const char*>(data + entry.nameOffset), entry.nameLength
+    );
+    if (entryName == name) { return i; }
+  }
+  return entryCount_;
+}
+
+bool AssetArchive::Contains(std::string_view name) const {
+  return Find(name) != entryCount_;
+}
+
+std::optional<std::span<const uint8_t>> AssetArchive::Read(
+  std::string_view name, std::vector<uint8_t>& buffer
+) const {
+  const size_t index = Find(name);
+  if (index == entryCount_) { return std::nullopt; }
+  const Entry entry = GetEntry(index);
+  const std::span<const uint8_t> stored = file_.GetData().subspan(
+    static_cast<size_t>(entry.offset), static_cast<size_t>(entry.storedSize)
+  );
+  if (entry.compression == Compression::kNone) { return stored; }
+
+  buffer.resize(static_cast<size_t>(entry.size));
+  if (!DecompressLz4(stored, buffer)) {
+    SDL_Log(
+      "AssetArchive: Failed to decompress %s",
+      std::string(name).c_str()
+    );
+    return std::nullopt;
+  }
+  return std::span<const uint8_t>(buffer);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+// A file to pack into an archive, named by its path relative to the assets
+// directory with '/' separators, e.g. "shaders/default.vert"
+struct AssetArchiveInput {
+  std::string name;
+  std::span<const uint8_t> data;
+};
+
+// A packed archive of asset files (.lpak), made by lizual_pack. Opening it is
+// one mapping instead of an open per file, and entries stored uncompressed
+// are read as views straight into it. Entries are immutable, so reads are
+// safe from any thread.
+//
+// Layout, little endian: a header, an index with an entry per file sorted by
+// the 64-bit FNV-1a hash of its name, the names, then the file data. Each
+// file starts on a 4 KB boundary so it covers whole pages of the mapping.
+// Files are stored as they are or LZ4 compressed, whichever the packer chose.
+class AssetArchive {
+ public:
+  static constexpr const char* kExtension = ".lpak";
+
+  // Maps the archive and validates its index. On failure returns std::nullopt
+  // and describes the problem in error.
+  static std::optional<AssetArchive> Open(
+    const std::filesystem::path& path, std::string& error
+  );
+  // Writes the inputs, LZ4 compressing those that shrink by at least an
+  // eighth if compress is set. Names must be unique. Returns false and
+  // describes the problem in error on failure.
+  static bool Write(
+    const std::filesystem::path& path,
+    std::span<const AssetArchiveInput> inputs,
+    bool compress,
+    std::string& error
+  );
+
+  size_t GetEntryCount() const { return entryCount_; }
+  bool Contains(std::string_view name) const;
+  // The contents of a file: a view into the mapping if it is stored as it
+  // is, or its decompressed data, written to buffer. std::nullopt if the
+  // archive has no such file or it fails to decompress.
+  std::optional<std::span<const uint8_t>> Read(
+    std::string_view name, std::vector<uint8_t>& buffer
+  ) const;
+
+ private:
+  struct Entry;
+
+  AssetArchive(MappedFile file, size_t entryCount)
+      : file_(std::move(file)), entryCount_(entryCount) {}
+
+  // Index of the entry with the name, or entryCount_ if there is none
+  size_t Find(std::string_view name) const;
+  Entry GetEntry(size_t index) const;
+
+  MappedFile file_;
+  size_t entryCount_;
+};
@@ -0,0 +1,405 @@
+#include "BVH.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace {
+// Number of bins per axis for the binned SAH
+constexpr int kBinCount = 16;
+// Subtrees smaller than this are not worth a job
+constexpr uint32_t kParallelBuildThreshold = 16 * 1024;
+// Relative costs of visiting a node and of testing an object, for the SAH
+constexpr float kTraversalCost = 1.0f;
+constexpr float kIntersectionCost = 1.0f;
+
+// Entry distance of a ray into a box, or a negative value if it misses
+float IntersectRay(
+  const AABB& box,
+  const glm::vec3& origin,
+  const glm::vec3& inverseDirection,
+  float maxDistance
+) {
+  const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+  const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+  const glm::vec3 tNear = glm::min(t0, t1);
+  const glm::vec3 tFar = glm::max(t0, t1);
+  const float enter = std::max({tNear.x, tNear.y, tNear.z, 0.0f});
+  const float exit = std::min({tFar.x, tFar.y, tFar.z, maxDistance});
+  return enter <= exit ? enter : -1.0f;
+}
+
+bool IntersectsSphere(const AABB& box, const glm::vec3& center, float radius) {
+  const glm::vec3 closest = glm::clamp(center, box.min, box.max);
+  const glm::vec3 offset = closest - center;
+  return glm::dot(offset, offset) <= radius * radius;
+}
+}  // namespace
+
+void AABB::Grow(const glm::vec3& point) {
+  min = glm::min(min, point);
+  max = glm::max(max, point);
+}
+
+void AABB::Grow(const AABB& other) {
+  min = glm::min(min, other.min);
+  max = glm::max(max, other.max);
+}
+
+float AABB::GetHalfArea() const {
+  const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+struct BVH::BuildContext {
+  std::span<const AABB> bounds;
+  std::vector<glm::vec3> centroids;
+  // Shared permutation. Concurrent subtree builds only touch disjoint ranges.
+  uint32_t* indices;
+  // Runs right subtrees as jobs if set
+  JobSystem* jobs;
+};
+
+void BVH::Build(std::span<const AABB> objectBounds, JobSystem* jobs) {
+  LIZUAL_PROFILE_SCOPE("BVH::Build");
+  nodes_.clear();
+  objectIndices_.resize(objectBounds.size());
+  std::iota(objectIndices_.begin(), objectIndices_.end(), 0u);
+  if (objectBounds.empty()) {
+    leafBounds_.Resize(0);
+    return;
+  }
+
+  BuildContext context{objectBounds, {}, objectIndices_.data(), jobs};
+  context.centroids.resize(objectBounds.size());
+  for (size_t i = 0; i < objectBounds.size(); ++i) {
+    context.centroids[i] = objectBounds[i].GetCenter();
+  }
+
+  // Each node becomes a leaf or has two children, so there are at most
+  // 2n - 1 nodes
+  nodes_.reserve(objectBounds.size() * 2);
+  BuildRecursive(
+    context, 0, static_cast<uint32_t>(objectBounds.size()), nodes_
+  );
+
+  leafBounds_.Resize(objectIndices_.size());
+  for (size_t i = 0; i < objectIndices_.size(); ++i) {
+    const AABB& box = objectBounds[objectIndices_[i]];
+    leafBounds_.Set(i, box.min, box.max);
+  }
+}
+
+void BVH::BuildRecursive(
+  BuildContext& context,
+  uint32_t firstObject,
+  uint32_t objectCount,
+  std::vector<Node>& out
+) {
+  uint32_t* const indices = context.indices + firstObject;
+  AABB bounds;
+  AABB centroidBounds;
+  for (uint32_t i = 0; i < objectCount; ++i) {
+    bounds.Grow(context.bounds[indices[i]]);
+    centroidBounds.Grow(context.centroids[indices[i]]);
+  }
+
+  const size_t nodeIndex = out.size();
+  out.push_back(Node{bounds, firstObject, objectCount, 0});
+  if (objectCount <= 2) { return; }
+
+  // Evaluate the binned SAH on every axis, binning all three in one pass
+  struct Bin {
+    AABB bounds;
+    uint32_t count = 0;
+  };
+  const glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+  glm::vec3 binScale(0.0f);
+  for (int axis = 0; axis < 3; ++axis) {
+    if (centroidExtent[axis] > 0.0f) {
+      binScale[axis] = kBinCount / centroidExtent[axis];
+    }
+  }
+  std::array<std::array<Bin, kBinCount>, 3> bins;
+  for (uint32_t i = 0; i < objectCount; ++i) {
+    const AABB& box = context.bounds[indices[i]];
+    const glm::vec3 offset =
+      (context.centroids[indices[i]] - centroidBounds.min) * binScale;
+    for (int axis = 0; axis < 3; ++axis) {
+      const int bin = std::min(kBinCount - 1, static_cast<int>(offset[axis]));
+      bins[axis][bin].bounds.Grow(box);
+      ++bins[axis][bin].count;
+    }
+  }
+
+  float bestCost = std::numeric_limits<float>::max();
+  int bestAxis = -1;
+  int bestSplit = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (binScale[axis] == 0.0f) { continue; }
+    // Sweep from the right to get the cost of everything right of each split,
+    // then from the left to combine
+    std::array<float, kBinCount> rightCost;
+    AABB rightBounds;
+    uint32_t rightCount = 0;
+    for (int split = kBinCount - 1; split > 0; --split) {
+      rightBounds.Grow(bins[axis][split].bounds);
+      rightCount += bins[axis][split].count;
+      rightCost[split] = rightCount * rightBounds.GetHalfArea();
+    }
+    AABB leftBounds;
+    uint32_t leftCount = 0;
+    for (int split = 1; split < kBinCount; ++split) {
+      leftBounds.Grow(bins[axis][split - 1].bounds);
+      leftCount += bins[axis][split - 1].count;
+      if (leftCount == 0 || leftCount == objectCount) { continue; }
+      const float cost =
+        leftCount * leftBounds.GetHalfArea() + rightCost[split];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = split;
+      }
+    }
+  }
+
+  const float leafCost = kIntersectionCost * objectCount;
+  const float splitCost =
+    kTraversalCost + kIntersectionCost * bestCost / bounds.GetHalfArea();
+  uint32_t leftCount = 0;
+  if (bestAxis >= 0 &&
+      (splitCost < leafCost || objectCount > kMaxLeafObjects)) {
+    const float scale = binScale[bestAxis];
+    const float minimum = centroidBounds.min[bestAxis];
+    uint32_t* middle = std::partition(
+      indices, indices + objectCount, [&](uint32_t object) {
+        const float offset = context.centroids[object][bestAxis] - minimum;
+        return std::min(kBinCount - 1, static_cast<int>(offset * scale)) <
+               bestSplit;
+      }
+    );
+    leftCount = static_cast<uint32_t>(middle - indices);
+  } else if (objectCount > kMaxLeafObjects) {
+    // All centroids coincide, so any split is as good as another
+    leftCount = objectCount / 2;
+  } else {
+    return;
+  }
+
+  const uint32_t rightCount = objectCount - leftCount;
+  if (context.jobs != nullptr && objectCount >= kParallelBuildThreshold) {
+    // Idle threads steal the right subtree while this one builds the left,
+    // and forks below spread further the same way
+    std::vector<Node> rightNodes;
+    rightNodes.reserve(rightCount * 2);
+    JobCounter right;
+    context.jobs->Submit(
+      [&]() {
+        LIZUAL_PROFILE_SCOPE("BVH::BuildSubtree");
+        BuildRecursive(
+          context, firstObject + leftCount, rightCount, rightNodes
+        );
+      },
+      &right
+    );
+    BuildRecursive(context, firstObject, leftCount, out);
+    context.jobs->Wait(right);
+    out[nodeIndex].rightOffset = static_cast<uint32_t>(out.size() - nodeIndex);
+    out.insert(out.end(), rightNodes.begin(), rightNodes.end());
+  } else {
+    BuildRecursive(context, firstObject, leftCount, out);
+    out[nodeIndex].rightOffset = static_cast<uint32_t>(out.size() - nodeIndex);
+    BuildRecursive(context, firstObject + leftCount, rightCount, out);
+  }
+}
+
+void BVH::Refit(std::span<const AABB> objectBounds) {
+  for (size_t i = 0; i < objectIndices_.size(); ++i) {
+    const AABB& box = objectBounds[objectIndices_[i]];
+    leafBounds_.Set(i, box.min, box.max);
+  }
+  // Children always come after their parent, so a reverse sweep visits them
+  // first
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    Node& node = nodes_[i];
+    if (node.IsLeaf()) {
+      node.bounds = AABB{};
+      for (uint32_t j = 0; j < node.objectCount; ++j) {
+        node.bounds.Grow(objectBounds[objectIndices_[node.firstObject + j]]);
+      }
+    } else {
+      node.bounds = nodes_[i + 1].bounds;
+      node.bounds.Grow(nodes_[i + node.rightOffset].bounds);
+    }
+  }
+}
+
+void BVH::AppendSubtree(const Node& node, std::vector<uint32_t>& out) const {
+  const auto first = objectIndices_.begin() + node.firstObject;
+  out.insert(out.end(), first, first + node.objectCount);
+}
+
+void BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out)
+  const {
+  if (nodes_.empty()) { return; }
+
+  std::vector<uint32_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[nodeIndex];
+    switch (frustum.ClassifyAABB(node.bounds.min, node.bounds.max)) {
+      case Frustum::Containment::kOutside:
+        break;
+      case Frustum::Containment::kInside:
+        AppendSubtree(node, out);
+        break;
+      case Frustum::Containment::kIntersecting:
+        if (node.IsLeaf()) {
+          // Cull the leaf's boxes in one SIMD batch, writing leaf-order
+          // indices into the tail of out, then map them to objects
+          const size_t first = out.size();
+          out.resize(first + node.objectCount);
+          const size_t visible = CullAABBs(
+            frustum,
+            leafBounds_,
+            node.firstObject,
+            node.firstObject + node.objectCount,
+            out.data() + first
+          );
+          out.resize(first + visible);
+          for (size_t i = first; i < out.size(); ++i) {
+            out[i] = objectIndices_[out[i]];
+          }
+        } else {
+          stack.push_back(nodeIndex + node.rightOffset);
+          stack.push_back(nodeIndex + 1);
+        }
+        break;
+    }
+  }
+}
+
+std::optional<BVH::RayHit> BVH::Raycast(
+  const glm::vec3& origin, const glm::vec3& direction, float maxDistance
+) const {
+  if (nodes_.empty()) { return std::nullopt; }
+
+  const glm::vec3 normalizedDirection = glm::normalize(direction);
+  const glm::vec3 inverseDirection = 1.0f / normalizedDirection;
+  std::optional<RayHit> nearest;
+  float nearestDistance = maxDistance;
+
+  std::vector<uint32_t> stack;
+  stack.reserve(64);
+  if (IntersectRay(nodes_[0].bounds, origin, inverseDirection, maxDistance) >=
+      0.0f) {
+    stack.push_back(0);
+  }
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[nodeIndex];
+    // The node may have been pushed before a nearer hit was found
+    if (IntersectRay(node.bounds, origin, inverseDirection, nearestDistance) <
+        0.0f) {
+      continue;
+    }
+
+    if (node.IsLeaf()) {
+      for (uint32_t i = 0; i < node.objectCount; ++i) {
+        const uint32_t leafIndex = node.firstObject + i;
+        const glm::vec3 center(
+          leafBounds_.centerX[leafIndex],
+          leafBounds_.centerY[leafIndex],
+          leafBounds_.centerZ[leafIndex]
+        );
+        const glm::vec3 extent(
+          leafBounds_.extentX[leafIndex],
+          leafBounds_.extentY[leafIndex],
+          leafBounds_.extentZ[leafIndex]
+        );
+        const float distance = IntersectRay(
+          AABB{center - extent, center + extent},
+          origin,
+          inverseDirection,
+          nearestDistance
+        );
+        if (distance >= 0.0f) {
+          nearestDistance = distance;
+          nearest = RayHit{objectIndices_[leafIndex], distance};
+        }
+      }
+      continue;
+    }
+
+    // Visit the nearer child first so the far one is likely pruned
+    const uint32_t children[2] = {nodeIndex + 1, nodeIndex + node.rightOffset};
+    float distances[2];
+    for (int i = 0; i < 2; ++i) {
+      distances[i] = IntersectRay(
+        nodes_[children[i]].bounds, origin, inverseDirection, nearestDistance
+      );
+    }
+    const bool rightIsNearer =
+      distances[1] >= 0.0f &&
+      (distances[0] < 0.0f || distances[1] < distances[0]);
+    const int nearChild = rightIsNearer ? 1 : 0;
+    const int farChild = 1 - nearChild;
+    if (distances[farChild] >= 0.0f) { stack.push_back(children[farChild]); }
+    if (distances[nearChild] >= 0.0f) { stack.push_back(children[nearChild]); }
+  }
+  return nearest;
+}
+
+void BVH::QueryRadius(
+  const glm::vec3& center, float radius, std::vector<uint32_t>& out
+) const {
+  if (nodes_.empty()) { return; }
+
+  std::vector<uint32_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const uint32_t nodeIndex = stack.back();
+    stack.pop_back();
+    const Node& node = nodes_[nodeIndex];
+    if (!IntersectsSphere(node.bounds, center, radius)) { continue; }
+
+    if (!node.IsLeaf()) {
+      stack.push_back(nodeIndex + node.rightOffset);
+      stack.push_back(nodeIndex + 1);
+      continue;
+    }
+    for (uint32_t i = 0; i < node.objectCount; ++i) {
+      const uint32_t leafIndex = node.firstObject + i;
+      const glm::vec3 boxCenter(
+        leafBounds_.centerX[leafIndex],
+        leafBounds_.centerY[leafIndex],
+        leafBounds_.centerZ[leafIndex]
+      );
+      const glm::vec3 extent(
+        leafBounds_.extentX[leafIndex],
+        leafBounds_.extentY[leafIndex],
+        leafBounds_.extentZ[leafIndex]
+      );
+      if (IntersectsSphere(
+            AABB{boxCenter - extent, boxCenter + extent}, center, radius
+          )) {
+        out.push_back(objectIndices_[leafIndex]);
+      }
+    }
+  }
+}
+
+AABB BVH::GetBounds() const {
+  return nodes_.empty() ? AABB{} : nodes_[0].bounds;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Frustum.h"
+
+class JobSystem;
+
+struct AABB {
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+  void Grow(const glm::vec3& point);
+  void Grow(const AABB& other);
+  glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+  // Half the surface area, which is all the SAH needs
+  float GetHalfArea() const;
+};
+
+// Bounding volume hierarchy over object bounds, for frustum, ray and radius
+// queries that are sub-linear in the object count.
+//
+// Built top-down with the binned surface area heuristic. Objects that move
+// can be handled with Refit, which keeps the topology and only recomputes
+// node bounds; rebuild when the tree quality degrades.
+class BVH {
+ public:
+  // Objects per leaf the builder aims for at most. Matches the AVX2 culling
+  // width, so one leaf is one culling batch.
+  static constexpr uint32_t kMaxLeafObjects = 8;
+
+  struct RayHit {
+    uint32_t object;
+    // Distance along the (normalized) ray direction to the object's bounds
+    float distance;
+  };
+
+  // Builds the hierarchy over objectBounds, indexed by object. Subtrees above
+  // a size threshold are built as jobs on jobs if given, serially otherwise.
+  void Build(std::span<const AABB> objectBounds, JobSystem* jobs = nullptr);
+
+  // Recomputes node bounds bottom-up for new object bounds. objectBounds must
+  // have the same size as in Build.
+  void Refit(std::span<const AABB> objectBounds);
+
+  // Appends the objects whose bounds intersect the frustum. Fully contained
+  // subtrees are appended without further tests, partially contained leaves
+  // are tested with the SIMD box culler.
+  void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out) const;
+
+  // Finds the nearest object whose bounds the ray hits within maxDistance
+  std::optional<RayHit> Raycast(
+    const glm::vec3& origin,
+    const glm::vec3& direction,
+    float maxDistance = std::numeric_limits<float>::max()
+  ) const;
+
+  // Appends the objects whose bounds intersect the sphere
+  void QueryRadius(
+    const glm::vec3& center, float radius, std::vector<uint32_t>& out
+  ) const;
+
+  size_t GetNodeCount() const { return nodes_.size(); }
+  size_t GetObjectCount() const { return objectIndices_.size(); }
+  // Root bounds, or an empty AABB for an empty hierarchy
+  AABB GetBounds() const;
+
+ private:
+  // Nodes are stored depth-first: a node's left child directly follows it and
+  // its right child is rightOffset nodes after it. Every subtree covers the
+  // contiguous range [firstObject, firstObject + objectCount) of
+  // objectIndices_.
+  struct Node {
+    AABB bounds;
+    uint32_t firstObject;
+    uint32_t objectCount;
+    // 0 for leaves
+    uint32_t rightOffset;
+
+    bool IsLeaf() const { return rightOffset == 0; }
+  };
+
+  struct BuildContext;
+  static void BuildRecursive(
+    BuildContext& context,
+    uint32_t firstObject,
+    uint32_t objectCount,
+    std::vector<Node>& out
+  );
+  void AppendSubtree(const Node& node, std::vector<uint32_t>& out) const;
+
+  std::vector<Node> nodes_;
+  // Object indices in leaf order
+  std::vector<uint32_t> objectIndices_;
+  // Object bounds in leaf order, for the SIMD leaf tests
+  BoundingBoxes leafBounds_;
+};
@@ -0,0 +1,281 @@
+#include "Benchmark.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <SDL3/SDL_video.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+
+#include "JsonWriter.h"
+#include "Profiler.h"
+
+namespace {
+constexpr float kPathRadius = 12.0f;
+// How far the orbit moves in and out
+constexpr float kPathRadiusVariation = 6.0f;
+// Orbit speed in radians per simulated second
+constexpr float kPathAngularSpeed = 0.5f;
+
+std::string_view GetGLString(GLenum name) {
+  const GLubyte* string = glGetString(name);
+  return string != nullptr ? reinterpret_cast<const char*>(string) : "";
+}
+
+// Peak resident set size of the process, or 0 if unknown
+size_t GetPeakMemoryBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!K32GetProcessMemoryInfo(
+        GetCurrentProcess(), &counters, sizeof(counters)
+      )) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if defined(__APPLE__)
+  // Bytes on macOS, kilobytes elsewhere
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void WriteSamples(
+  JsonWriter& writer, std::string_view key, const std::vector<float>& samples
+) {
+  writer.Key(key);
+  writer.BeginArray();
+  for (const float sample : samples) { writer.Value(sample); }
+  writer.EndArray();
+}
+
+double ToMegabytes(size_t bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+}  // namespace
+
+Benchmark::Benchmark(const Settings& settings)
+    : settings_(settings),
+      renderer_(GetGLString(GL_RENDERER)),
+      glVersion_(GetGLString(GL_VERSION)),
+      frameIndex_(0),
+      measureStartNs_(0),
+      measureEndNs_(0),
+      cpuStats_(settings.budgetMs, std::max(settings.measuredFrames, 1u)),
+      gpuStats_(settings.budgetMs, std::max(settings.measuredFrames, 1u)),
+      gpuResolvedFrames_(0),
+      gpuDroppedFramesAtStart_(0),
+      gpuDroppedFrames_(0) {}
+
+float Benchmark::GetTime() const {
+  return static_cast<float>(frameIndex_ * kTimeStepSeconds);
+}
+
+void Benchmark::ApplyCameraPath(Camera& camera) const {
+  const float angle = GetTime() * kPathAngularSpeed;
+  const float radius =
+    kPathRadius + kPathRadiusVariation * glm::sin(angle * 3.0f);
+  const glm::vec3 offset(
+    radius * glm::sin(angle),
+    2.0f * glm::sin(angle * 2.0f),
+    radius * glm::cos(angle)
+  );
+  camera.position = settings_.pathCenter + offset;
+  // The camera looks down -Z at zero yaw, so yawing by the orbit angle keeps
+  // it facing the center
+  camera.yaw = glm::degrees(angle);
+  camera.pitch = 0.0f;
+}
+
+bool Benchmark::EndFrame(
+  uint64_t cpuFrameNs,
+  const GpuTimer::Results& gpuResults,
+  const GLStats::Frame& glStats
+) {
+  const uint64_t nowNs = Profiler::Now();
+  if (frameIndex_ == settings_.warmupFrames) {
+    // The first measured frame started cpuFrameNs ago
+    measureStartNs_ = nowNs - cpuFrameNs;
+    gpuDroppedFramesAtStart_ = gpuResults.droppedFrames;
+  }
+  const bool measuring = frameIndex_ >= settings_.warmupFrames;
+
+  if (measuring) {
+    cpuStats_.Record(cpuFrameNs);
+    // Like the GPU times, GL counts come from the render thread a few frames
+    // late, which only shifts the window they are summed over
+    glTotals_.drawCalls += glStats.drawCalls;
+    glTotals_.triangles += glStats.triangles;
+    glTotals_.instances += glStats.instances;
+    glTotals_.stateChanges += glStats.stateChanges;
+    glTotals_.stateChangesElided += glStats.stateChangesElided;
+    glTotals_.uniformUpdates += glStats.uniformUpdates;
+    glTotals_.uniformUpdatesElided += glStats.uniformUpdatesElided;
+    glTotals_.bufferBytesUploaded += glStats.bufferBytesUploaded;
+    glTotals_.textureBytesUploaded += glStats.textureBytesUploaded;
+  }
+
+  // GPU results arrive GpuTimer::kFramesInFlight frames late. Skip those that
+  // belong to warmup frames.
+  if (gpuResults.resolvedFrames != gpuResolvedFrames_) {
+    gpuResolvedFrames_ = gpuResults.resolvedFrames;
+    if (frameIndex_ >= settings_.warmupFrames + GpuTimer::kFramesInFlight) {
+      gpuStats_.Record(
+        static_cast<uint64_t>(gpuResults.frameGpuMs * SDL_NS_PER_MS)
+      );
+      for (const GpuTimer::PassTime& pass : gpuResults.passTimes) {
+        auto totals = std::find_if(
+          passTotals_.begin(), passTotals_.end(), [&](const PassTotals& t) {
+            return std::string_view(t.name) == pass.name;
+          }
+        );
+        if (totals == passTotals_.end()) {
+          passTotals_.push_back({pass.name, 0.0, 0.0, 0});
+          totals = passTotals_.end() - 1;
+        }
+        totals->cpuMs += pass.cpuMs;
+        totals->gpuMs += pass.gpuMs;
+        ++totals->count;
+      }
+    }
+  }
+
+  ++frameIndex_;
+  if (frameIndex_ < settings_.warmupFrames + settings_.measuredFrames) {
+    return false;
+  }
+  measureEndNs_ = nowNs;
+  gpuDroppedFrames_ = gpuResults.droppedFrames - gpuDroppedFramesAtStart_;
+  return true;
+}
+
+bool Benchmark::WriteReport(const std::filesystem::path& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    SDL_Log(
+      "Benchmark: Failed to open report file for writing: %s",
+      path.string().c_str()
+    );
+    return false;
+  }
+
+  const double wallSeconds =
+    static_cast<double>(measureEndNs_ - measureStartNs_) / SDL_NS_PER_SECOND;
+  JsonWriter writer(out);
+  writer.BeginObject();
+  writer.Field("renderer", std::string_view(renderer_));
+  writer.Field("gl_version", std::string_view(glVersion_));
+  const char* videoDriver = SDL_GetCurrentVideoDriver();
+  writer.Field("video_driver", videoDriver != nullptr ? videoDriver : "");
+  writer.Field("width", settings_.width);
+  writer.Field("height", settings_.height);
+  writer.Field("warmup_frames", settings_.warmupFrames);
+  writer.Field("frames", settings_.measuredFrames);
+  writer.Field("startup_ms", settings_.startupMs);
+  writer.Field("render_frames_in_flight", settings_.renderFramesInFlight);
+  writer.Field("peak_memory_mb", ToMegabytes(GetPeakMemoryBytes()));
+  writer.Key("scene");
+  writer.BeginObject();
+  writer.Field(
+    "distribution",
+    std::string_view(GetSceneDistributionName(settings_.scene.distribution))
+  );
+  writer.Field("objects", settings_.scene.objectCount);
+  writer.Field("animated_fraction", settings_.scene.animatedFraction);
+  writer.Field("meshes", settings_.scene.meshCount);
+  writer.Field("textures", settings_.scene.textureCount);
+  writer.Field("seed", settings_.scene.seed);
+  writer.Field("memory_mb", ToMegabytes(settings_.sceneMemoryBytes));
+  writer.EndObject();
+  writer.Field("wall_time_s", wallSeconds);
+  writer.Field(
+    "average_fps",
+    wallSeconds > 0.0 ? settings_.measuredFrames / wallSeconds : 0.0
+  );
+  writer.Key("cpu_frame");
+  cpuStats_.WriteJson(writer);
+  writer.Key("gpu_frame");
+  gpuStats_.WriteJson(writer);
+  writer.Field("gpu_dropped_frames", gpuDroppedFrames_);
+
+  writer.Key("passes");
+  writer.BeginArray();
+  for (const PassTotals& totals : passTotals_) {
+    writer.BeginObject();
+    writer.Field("name", std::string_view(totals.name));
+    writer.Field("cpu_mean_ms", totals.cpuMs / totals.count);
+    writer.Field("gpu_mean_ms", totals.gpuMs / totals.count);
+    writer.EndObject();
+  }
+  writer.EndArray();
+
+  // Mean GL work per measured frame, not counting the UI's
+  const double frames = std::max(settings_.measuredFrames, 1u);
+  writer.Key("gl_per_frame");
+  writer.BeginObject();
+  writer.Field("draw_calls", glTotals_.drawCalls / frames);
+  writer.Field("instances", glTotals_.instances / frames);
+  writer.Field("triangles", glTotals_.triangles / frames);
+  writer.Field("state_changes", glTotals_.stateChanges / frames);
+  writer.Field("state_changes_elided", glTotals_.stateChangesElided / frames);
+  writer.Field("uniform_updates", glTotals_.uniformUpdates / frames);
+  writer.Field(
+    "uniform_updates_elided", glTotals_.uniformUpdatesElided / frames
+  );
+  writer.Field("buffer_upload_bytes", glTotals_.bufferBytesUploaded / frames);
+  writer.Field(
+    "texture_upload_bytes", glTotals_.textureBytesUploaded / frames
+  );
+  writer.EndObject();
+
+  // Every measured frame, for statistical comparisons between runs
+  writer.Key("samples");
+  writer.BeginObject();
+  std::vector<float> samples;
+  cpuStats_.GetRecentFrameTimes(settings_.measuredFrames, samples);
+  WriteSamples(writer, "cpu_frame_ms", samples);
+  samples.clear();
+  gpuStats_.GetRecentFrameTimes(settings_.measuredFrames, samples);
+  WriteSamples(writer, "gpu_frame_ms", samples);
+  writer.EndObject();
+  writer.EndObject();
+
+  if (!out) {
+    SDL_Log(
+      "Benchmark: Failed to write report file: %s", path.string().c_str()
+    );
+    return false;
+  }
+
+  const FrameStats::Summary cpu = cpuStats_.ComputeSummary();
+  const FrameStats::Summary gpu = gpuStats_.ComputeSummary();
+  SDL_Log(
+    "Benchmark: %u frames in %.2f s, cpu p50 %.3f ms p99 %.3f ms, gpu p50 "
+    "%.3f ms p99 %.3f ms",
+    settings_.measuredFrames,
+    wallSeconds,
+    cpu.p50Ms,
+    cpu.p99Ms,
+    gpu.p50Ms,
+    gpu.p99Ms
+  );
+  SDL_Log("Benchmark: Wrote report to %s", path.string().c_str());
+  return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "FrameStats.h"
+#include "GLStats.h"
+#include "GpuTimer.h"
+#include "Scene.h"
+
+// Drives a headless benchmark run: a fixed simulation time step and camera
+// path so every run renders the same frames, warmup, and CPU/GPU frame time
+// statistics written as a JSON report along with the scene size, startup
+// time and peak memory use.
+class Benchmark {
+ public:
+  struct Settings {
+    uint32_t warmupFrames;
+    uint32_t measuredFrames;
+    double budgetMs;
+    uint32_t width;
+    uint32_t height;
+    // The camera orbits this point
+    glm::vec3 pathCenter;
+    // Recorded in the report so runs can be compared across scene sizes
+    SceneSettings scene;
+    size_t sceneMemoryBytes;
+    // Time spent initializing, including generating the scene and building
+    // its hierarchy
+    double startupMs;
+    // Frames the simulation may run ahead of the render thread
+    uint32_t renderFramesInFlight;
+  };
+
+  // Simulation seconds per frame, independent of how long frames take
+  static constexpr double kTimeStepSeconds = 1.0 / 60.0;
+
+  // Must be called with the GL context current, to record the renderer
+  explicit Benchmark(const Settings& settings);
+
+  // Simulation time of the current frame in seconds
+  float GetTime() const;
+
+  // Places the camera on the path for the current frame: an orbit around the
+  // scene that moves in and out, so culling results change over the run
+  void ApplyCameraPath(Camera& camera) const;
+
+  // Records the frame that just finished, with the latest GPU results and GL
+  // counts, and advances to the next. Returns true once all frames have been
+  // rendered.
+  bool EndFrame(
+    uint64_t cpuFrameNs,
+    const GpuTimer::Results& gpuResults,
+    const GLStats::Frame& glStats
+  );
+
+  // Writes the report. Returns false if the file could not be written.
+  bool WriteReport(const std::filesystem::path& path) const;
+
+ private:
+  struct PassTotals {
+    const char* name;
+    double cpuMs;
+    double gpuMs;
+    uint64_t count;
+  };
+
+  Settings settings_;
+  std::string renderer_;
+  std::string glVersion_;
+  uint32_t frameIndex_;
+  // Start of the first measured frame
+  uint64_t measureStartNs_;
+  uint64_t measureEndNs_;
+  FrameStats cpuStats_;
+  FrameStats gpuStats_;
+  std::vector<PassTotals> passTotals_;
+  uint64_t gpuResolvedFrames_;
+  uint64_t gpuDroppedFramesAtStart_;
+  uint64_t gpuDroppedFrames_;
+  // Sums of the GL counts of the measured frames
+  GLStats::Frame glTotals_;
+};
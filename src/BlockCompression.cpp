@@ -0,0 +1,937 @@
+#include "BlockCompression.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "BlockCompressionKernels.h"
+#include "JobSystem.h"
+
+#if LIZUAL_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+using block_kernels::Block;
+
+namespace {
+const struct {
+  BlockQuality quality;
+  const char* name;
+} kQualityNames[] = {
+  {BlockQuality::kFast, "fast"},
+  {BlockQuality::kNormal, "normal"},
+  {BlockQuality::kHigh, "high"},
+};
+
+constexpr int kBlockTexels = 16;
+constexpr float kInfiniteError = std::numeric_limits<float>::max();
+// Rounds of +-1 endpoint nudges the high tier tries
+constexpr int kMaxNudgeRounds = 8;
+
+// Palette entry k of BC1 in four color mode sits this far from color0 to
+// color1
+constexpr float kBC1Positions[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+// BC7 interpolation weights of 4-bit indices, out of 64
+constexpr int kBC7Weights[16] = {
+  0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+int GetRefineIterations(BlockQuality quality) {
+  switch (quality) {
+    case BlockQuality::kFast:
+      return 0;
+    case BlockQuality::kNormal:
+      return 2;
+    case BlockQuality::kHigh:
+      return 6;
+  }
+  return 0;
+}
+
+Block LoadBlock(
+  std::span<const uint8_t> rgba, int width, int height, int blockX, int blockY
+) {
+  Block block;
+  for (int y = 0; y < 4; ++y) {
+    const int sourceY = std::min(blockY * 4 + y, height - 1);
+    for (int x = 0; x < 4; ++x) {
+      const int sourceX = std::min(blockX * 4 + x, width - 1);
+      const uint8_t* texel =
+        &rgba[(static_cast<size_t>(sourceY) * width + sourceX) * 4];
+      const int i = y * 4 + x;
+      block.r[i] = texel[0];
+      block.g[i] = texel[1];
+      block.b[i] = texel[2];
+      block.a[i] = texel[3];
+    }
+  }
+  return block;
+}
+
+glm::vec4 GetTexel(const Block& block, int i) {
+  return {block.r[i], block.g[i], block.b[i], block.a[i]};
+}
+
+float FindNearest(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const glm::vec4& channelWeights,
+  uint8_t* indices,
+  SimdLevel level
+) {
+  const float* weights = &channelWeights.x;
+  switch (level) {
+    case SimdLevel::kScalar:
+      return block_kernels::FindNearestScalar(
+        block, palette, paletteSize, weights, indices
+      );
+    case SimdLevel::kSSE2:
+      return block_kernels::FindNearestSSE2(
+        block, palette, paletteSize, weights, indices
+      );
+    case SimdLevel::kAVX2:
+      return block_kernels::FindNearestAVX2(
+        block, palette, paletteSize, weights, indices
+      );
+  }
+  return kInfiniteError;
+}
+
+// Initial endpoints: the extremes of the texels projected on their principal
+// axis, found by power iteration from the bounding box diagonal. The fast
+// tier takes a single iteration. Channels with weight 0 are ignored.
+void FitEndpoints(
+  const Block& block,
+  const glm::vec4& channelWeights,
+  BlockQuality quality,
+  glm::vec4& e0,
+  glm::vec4& e1
+) {
+  glm::vec4 mean(0.0f);
+  glm::vec4 minimum(255.0f);
+  glm::vec4 maximum(0.0f);
+  for (int i = 0; i < kBlockTexels; ++i) {
+    const glm::vec4 texel = GetTexel(block, i) * channelWeights;
+    mean += texel;
+    minimum = glm::min(minimum, texel);
+    maximum = glm::max(maximum, texel);
+  }
+  mean /= static_cast<float>(kBlockTexels);
+
+  glm::mat4 covariance(0.0f);
+  for (int i = 0; i < kBlockTexels; ++i) {
+    const glm::vec4 offset = GetTexel(block, i) * channelWeights - mean;
+    covariance += glm::outerProduct(offset, offset);
+  }
+  glm::vec4 axis = maximum - minimum;
+  const int iterations = quality == BlockQuality::kFast ? 1 : 8;
+  for (int i = 0; i < iterations; ++i) {
+    const glm::vec4 next = covariance * axis;
+    const float length = glm::length(next);
+    if (length < 1e-6f) { break; }
+    axis = next / length;
+  }
+
+  float tMin = 0.0f;
+  float tMax = 0.0f;
+  if (glm::dot(axis, axis) > 1e-12f) {
+    axis = glm::normalize(axis);
+    tMin = std::numeric_limits<float>::max();
+    tMax = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < kBlockTexels; ++i) {
+      const float t =
+        glm::dot(GetTexel(block, i) * channelWeights - mean, axis);
+      tMin = std::min(tMin, t);
+      tMax = std::max(tMax, t);
+    }
+  }
+  e0 = glm::clamp(mean + axis * tMin, 0.0f, 255.0f);
+  e1 = glm::clamp(mean + axis * tMax, 0.0f, 255.0f);
+}
+
+// Least squares endpoints for texels reconstructed as mix(e0, e1, t[i]).
+// Returns false if every t is the same.
+bool SolveEndpoints(
+  const Block& block, const float* t, glm::vec4& e0, glm::vec4& e1
+) {
+  float a = 0.0f;
+  float b = 0.0f;
+  float c = 0.0f;
+  glm::vec4 r0(0.0f);
+  glm::vec4 r1(0.0f);
+  for (int i = 0; i < kBlockTexels; ++i) {
+    const float s = 1.0f - t[i];
+    a += s * s;
+    b += s * t[i];
+    c += t[i] * t[i];
+    r0 += s * GetTexel(block, i);
+    r1 += t[i] * GetTexel(block, i);
+  }
+  const float determinant = a * c - b * b;
+  if (std::abs(determinant) < 1e-6f) { return false; }
+  e0 = glm::clamp((c * r0 - b * r1) / determinant, 0.0f, 255.0f);
+  e1 = glm::clamp((a * r1 - b * r0) / determinant, 0.0f, 255.0f);
+  return true;
+}
+
+// Writes values LSB first, as the BC formats are laid out
+class BitWriter {
+ public:
+  explicit BitWriter(uint8_t* out) : out_(out) {}
+  void Write(uint32_t value, int bitCount) {
+    for (int i = 0; i < bitCount; ++i, ++position_) {
+      if ((value >> i) & 1) { out_[position_ / 8] |= 1 << (position_ % 8); }
+    }
+  }
+
+ private:
+  uint8_t* out_;
+  int position_ = 0;
+};
+
+class BitReader {
+ public:
+  explicit BitReader(const uint8_t* in) : in_(in) {}
+  uint32_t Read(int bitCount) {
+    uint32_t value = 0;
+    for (int i = 0; i < bitCount; ++i, ++position_) {
+      value |= ((in_[position_ / 8] >> (position_ % 8)) & 1u) << i;
+    }
+    return value;
+  }
+
+ private:
+  const uint8_t* in_;
+  int position_ = 0;
+};
+
+// ---- BC1 ----
+
+uint16_t ToColor565(const glm::vec4& color) {
+  const int r = static_cast<int>(std::round(color.r * 31.0f / 255.0f));
+  const int g = static_cast<int>(std::round(color.g * 63.0f / 255.0f));
+  const int b = static_cast<int>(std::round(color.b * 31.0f / 255.0f));
+  return static_cast<uint16_t>(
+    (std::clamp(r, 0, 31) << 11) | (std::clamp(g, 0, 63) << 5) |
+    std::clamp(b, 0, 31)
+  );
+}
+
+glm::ivec3 FromColor565(uint16_t color) {
+  const int r = color >> 11;
+  const int g = (color >> 5) & 63;
+  const int b = color & 31;
+  return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// The four colors the decoder derives from two endpoints, in four color mode
+void BuildBC1Palette(uint16_t color0, uint16_t color1, glm::ivec4* out) {
+  const glm::ivec3 c0 = FromColor565(color0);
+  const glm::ivec3 c1 = FromColor565(color1);
+  out[0] = glm::ivec4(c0, 255);
+  out[1] = glm::ivec4(c1, 255);
+  out[2] = glm::ivec4((2 * c0 + c1) / 3, 255);
+  out[3] = glm::ivec4((c0 + 2 * c1) / 3, 255);
+}
+
+struct BC1Candidate {
+  uint16_t color0;
+  uint16_t color1;
+  uint8_t indices[kBlockTexels];
+  float error;
+};
+
+// Evaluates the endpoints in four color mode, which needs color0 > color1,
+// and keeps them in best if they beat it
+void EvaluateBC1(
+  const Block& block,
+  uint16_t a,
+  uint16_t b,
+  SimdLevel level,
+  BC1Candidate& best
+) {
+  BC1Candidate candidate{std::max(a, b), std::min(a, b), {}, 0.0f};
+  glm::ivec4 colors[4];
+  BuildBC1Palette(candidate.color0, candidate.color1, colors);
+  float palette[4][4];
+  for (int i = 0; i < 4; ++i) {
+    for (int channel = 0; channel < 4; ++channel) {
+      palette[i][channel] = static_cast<float>(colors[i][channel]);
+    }
+  }
+  // Equal endpoints would select three color mode, so only index 0 is safe
+  const size_t paletteSize = candidate.color0 == candidate.color1 ? 1 : 4;
+  candidate.error = FindNearest(
+    block,
+    &palette[0][0],
+    paletteSize,
+    glm::vec4(1.0f, 1.0f, 1.0f, 0.0f),
+    candidate.indices,
+    level
+  );
+  if (candidate.error < best.error) { best = candidate; }
+}
+
+// Tries moving each channel of each endpoint by one step while that helps
+template <typename Candidate, typename Evaluate>
+void NudgeEndpoints(Candidate& best, int channelCount, Evaluate evaluate) {
+  for (int round = 0; round < kMaxNudgeRounds; ++round) {
+    const float previousError = best.error;
+    for (int endpoint = 0; endpoint < 2; ++endpoint) {
+      for (int channel = 0; channel < channelCount; ++channel) {
+        for (const int step : {-1, 1}) {
+          evaluate(Candidate(best), endpoint, channel, step);
+        }
+      }
+    }
+    if (best.error >= previousError) { break; }
+  }
+}
+
+float EncodeBC1(
+  const Block& block, const BlockSettings& settings, uint8_t* out
+) {
+  const glm::vec4 channelWeights(1.0f, 1.0f, 1.0f, 0.0f);
+  glm::vec4 e0;
+  glm::vec4 e1;
+  FitEndpoints(block, channelWeights, settings.quality, e0, e1);
+
+  BC1Candidate best{0, 0, {}, kInfiniteError};
+  const int iterations = GetRefineIterations(settings.quality);
+  for (int i = 0;; ++i) {
+    EvaluateBC1(
+      block, ToColor565(e0), ToColor565(e1), settings.simdLevel, best
+    );
+    if (i == iterations) { break; }
+    float t[kBlockTexels];
+    for (int texel = 0; texel < kBlockTexels; ++texel) {
+      t[texel] = kBC1Positions[best.indices[texel]];
+    }
+    if (!SolveEndpoints(block, t, e0, e1)) { break; }
+  }
+
+  if (settings.quality == BlockQuality::kHigh) {
+    // 565 channels: red at bit 11, green at 5, blue at 0
+    constexpr int kShifts[3] = {11, 5, 0};
+    constexpr int kMaxima[3] = {31, 63, 31};
+    NudgeEndpoints(
+      best,
+      3,
+      [&](BC1Candidate candidate, int endpoint, int channel, int step) {
+        uint16_t& color = endpoint == 0 ? candidate.color0 : candidate.color1;
+        const int value =
+          ((color >> kShifts[channel]) & kMaxima[channel]) + step;
+        if (value < 0 || value > kMaxima[channel]) { return; }
+        color = static_cast<uint16_t>(
+          (color & ~(kMaxima[channel] << kShifts[channel])) |
+          (value << kShifts[channel])
+        );
+        EvaluateBC1(
+          block, candidate.color0, candidate.color1, settings.simdLevel, best
+        );
+      }
+    );
+  }
+
+  out[0] = static_cast<uint8_t>(best.color0);
+  out[1] = static_cast<uint8_t>(best.color0 >> 8);
+  out[2] = static_cast<uint8_t>(best.color1);
+  out[3] = static_cast<uint8_t>(best.color1 >> 8);
+  uint32_t indices = 0;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    indices |= static_cast<uint32_t>(best.indices[i]) << (2 * i);
+  }
+  std::memcpy(out + 4, &indices, sizeof(indices));
+  return best.error;
+}
+
+void DecodeBC1(const uint8_t* in, bool alwaysFourColors, uint8_t* out) {
+  const uint16_t color0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+  const uint16_t color1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+  glm::ivec4 palette[4];
+  BuildBC1Palette(color0, color1, palette);
+  if (color0 <= color1 && !alwaysFourColors) {
+    // Three colors and transparent black
+    const glm::ivec3 c0 = FromColor565(color0);
+    const glm::ivec3 c1 = FromColor565(color1);
+    palette[2] = glm::ivec4((c0 + c1) / 2, 255);
+    palette[3] = glm::ivec4(0);
+  }
+  uint32_t indices;
+  std::memcpy(&indices, in + 4, sizeof(indices));
+  for (int i = 0; i < kBlockTexels; ++i) {
+    const glm::ivec4& color = palette[(indices >> (2 * i)) & 3];
+    for (int channel = 0; channel < 4; ++channel) {
+      out[i * 4 + channel] = static_cast<uint8_t>(color[channel]);
+    }
+  }
+}
+
+// ---- BC3 alpha (BC4) ----
+
+// The eight alphas the decoder derives from two endpoints. a0 > a1 selects
+// six interpolated values, otherwise four plus 0 and 255.
+void BuildBC4Palette(int a0, int a1, int* out) {
+  out[0] = a0;
+  out[1] = a1;
+  if (a0 > a1) {
+    for (int i = 2; i < 8; ++i) { out[i] = ((8 - i) * a0 + (i - 1) * a1) / 7; }
+  } else {
+    for (int i = 2; i < 6; ++i) { out[i] = ((6 - i) * a0 + (i - 1) * a1) / 5; }
+    out[6] = 0;
+    out[7] = 255;
+  }
+}
+
+struct BC4Candidate {
+  int a0;
+  int a1;
+  uint8_t indices[kBlockTexels];
+  float error;
+};
+
+void EvaluateBC4(
+  const Block& block, int a0, int a1, SimdLevel level, BC4Candidate& best
+) {
+  BC4Candidate candidate{a0, a1, {}, 0.0f};
+  int alphas[8];
+  BuildBC4Palette(a0, a1, alphas);
+  float palette[8][4] = {};
+  for (int i = 0; i < 8; ++i) { palette[i][3] = static_cast<float>(alphas[i]); }
+  candidate.error = FindNearest(
+    block,
+    &palette[0][0],
+    8,
+    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+    candidate.indices,
+    level
+  );
+  if (candidate.error < best.error) { best = candidate; }
+}
+
+float EncodeBC4Alpha(
+  const Block& block, const BlockSettings& settings, uint8_t* out
+) {
+  float minimum = 255.0f;
+  float maximum = 0.0f;
+  // Excluding 0 and 255, which six value mode has for free
+  float innerMinimum = 255.0f;
+  float innerMaximum = 0.0f;
+  for (const float alpha : block.a) {
+    minimum = std::min(minimum, alpha);
+    maximum = std::max(maximum, alpha);
+    if (alpha > 0.0f && alpha < 255.0f) {
+      innerMinimum = std::min(innerMinimum, alpha);
+      innerMaximum = std::max(innerMaximum, alpha);
+    }
+  }
+
+  BC4Candidate best{0, 0, {}, kInfiniteError};
+  EvaluateBC4(
+    block,
+    static_cast<int>(maximum),
+    static_cast<int>(minimum),
+    settings.simdLevel,
+    best
+  );
+  if (settings.quality != BlockQuality::kFast && innerMinimum <= innerMaximum &&
+      (minimum == 0.0f || maximum == 255.0f)) {
+    EvaluateBC4(
+      block,
+      static_cast<int>(innerMinimum),
+      static_cast<int>(innerMaximum),
+      settings.simdLevel,
+      best
+    );
+  }
+
+  const int iterations = GetRefineIterations(settings.quality);
+  for (int i = 0; i < iterations && best.a0 > best.a1; ++i) {
+    float t[kBlockTexels];
+    for (int texel = 0; texel < kBlockTexels; ++texel) {
+      const int index = best.indices[texel];
+      t[texel] = index < 2 ? static_cast<float>(index) : (index - 1) / 7.0f;
+    }
+    glm::vec4 e0;
+    glm::vec4 e1;
+    if (!SolveEndpoints(block, t, e0, e1)) { break; }
+    const int a0 = static_cast<int>(std::round(e0.a));
+    const int a1 = static_cast<int>(std::round(e1.a));
+    EvaluateBC4(
+      block, std::max(a0, a1), std::min(a0, a1), settings.simdLevel, best
+    );
+  }
+
+  if (settings.quality == BlockQuality::kHigh) {
+    NudgeEndpoints(
+      best,
+      1,
+      [&](BC4Candidate candidate, int endpoint, int, int step) {
+        int& alpha = endpoint == 0 ? candidate.a0 : candidate.a1;
+        alpha += step;
+        if (alpha < 0 || alpha > 255) { return; }
+        EvaluateBC4(
+          block, candidate.a0, candidate.a1, settings.simdLevel, best
+        );
+      }
+    );
+  }
+
+  std::memset(out, 0, 8);
+  out[0] = static_cast<uint8_t>(best.a0);
+  out[1] = static_cast<uint8_t>(best.a1);
+  BitWriter writer(out + 2);
+  for (const uint8_t index : best.indices) { writer.Write(index, 3); }
+  return best.error;
+}
+
+void DecodeBC4Alpha(const uint8_t* in, uint8_t* out) {
+  int palette[8];
+  BuildBC4Palette(in[0], in[1], palette);
+  BitReader reader(in + 2);
+  for (int i = 0; i < kBlockTexels; ++i) {
+    out[i * 4 + 3] = static_cast<uint8_t>(palette[reader.Read(3)]);
+  }
+}
+
+// ---- BC7 mode 6 ----
+// One RGBA line per block: 7-bit endpoints, each with a p-bit shared by its
+// channels as the 8th bit, and 4-bit indices.
+
+glm::ivec4 QuantizeBC7(const glm::vec4& endpoint, int pBit) {
+  const glm::ivec4 quantized(glm::round((endpoint - float(pBit)) / 2.0f));
+  return glm::clamp(quantized, 0, 127);
+}
+
+glm::ivec4 ExpandBC7(const glm::ivec4& quantized, int pBit) {
+  return (quantized << 1) | pBit;
+}
+
+// The p-bit that reproduces endpoint most closely
+int PickPBit(const glm::vec4& endpoint) {
+  float errors[2];
+  for (int pBit = 0; pBit < 2; ++pBit) {
+    const glm::vec4 offset =
+      glm::vec4(ExpandBC7(QuantizeBC7(endpoint, pBit), pBit)) - endpoint;
+    errors[pBit] = glm::dot(offset, offset);
+  }
+  return errors[1] < errors[0] ? 1 : 0;
+}
+
+struct BC7Candidate {
+  glm::ivec4 q0;
+  glm::ivec4 q1;
+  int p0;
+  int p1;
+  uint8_t indices[kBlockTexels];
+  float error;
+};
+
+void EvaluateBC7(
+  const Block& block,
+  const glm::ivec4& q0,
+  const glm::ivec4& q1,
+  int p0,
+  int p1,
+  SimdLevel level,
+  BC7Candidate& best
+) {
+  BC7Candidate candidate{q0, q1, p0, p1, {}, 0.0f};
+  const glm::ivec4 e0 = ExpandBC7(q0, p0);
+  const glm::ivec4 e1 = ExpandBC7(q1, p1);
+  float palette[16][4];
+  for (int i = 0; i < 16; ++i) {
+    const glm::ivec4 color =
+      ((64 - kBC7Weights[i]) * e0 + kBC7Weights[i] * e1 + 32) >> 6;
+    for (int channel = 0; channel < 4; ++channel) {
+      palette[i][channel] = static_cast<float>(color[channel]);
+    }
+  }
+  candidate.error = FindNearest(
+    block, &palette[0][0], 16, glm::vec4(1.0f), candidate.indices, level
+  );
+  if (candidate.error < best.error) { best = candidate; }
+}
+
+float EncodeBC7(
+  const Block& block, const BlockSettings& settings, uint8_t* out
+) {
+  glm::vec4 e0;
+  glm::vec4 e1;
+  FitEndpoints(block, glm::vec4(1.0f), settings.quality, e0, e1);
+
+  BC7Candidate best{{}, {}, 0, 0, {}, kInfiniteError};
+  const int iterations = GetRefineIterations(settings.quality);
+  for (int i = 0;; ++i) {
+    if (settings.quality == BlockQuality::kHigh) {
+      for (int pBits = 0; pBits < 4; ++pBits) {
+        const int p0 = pBits & 1;
+        const int p1 = pBits >> 1;
+        EvaluateBC7(
+          block,
+          QuantizeBC7(e0, p0),
+          QuantizeBC7(e1, p1),
+          p0,
+          p1,
+          settings.simdLevel,
+          best
+        );
+      }
+    } else {
+      const int p0 = PickPBit(e0);
+      const int p1 = PickPBit(e1);
+      EvaluateBC7(
+        block,
+        QuantizeBC7(e0, p0),
+        QuantizeBC7(e1, p1),
+        p0,
+        p1,
+        settings.simdLevel,
+        best
+      );
+    }
+    if (i == iterations) { break; }
+    float t[kBlockTexels];
+    for (int texel = 0; texel < kBlockTexels; ++texel) {
+      t[texel] = kBC7Weights[best.indices[texel]] / 64.0f;
+    }
+    if (!SolveEndpoints(block, t, e0, e1)) { break; }
+  }
+
+  if (settings.quality == BlockQuality::kHigh) {
+    NudgeEndpoints(
+      best,
+      4,
+      [&](BC7Candidate candidate, int endpoint, int channel, int step) {
+        int& value = (endpoint == 0 ? candidate.q0 : candidate.q1)[channel];
+        value += step;
+        if (value < 0 || value > 127) { return; }
+        EvaluateBC7(
+          block,
+          candidate.q0,
+          candidate.q1,
+          candidate.p0,
+          candidate.p1,
+          settings.simdLevel,
+          best
+        );
+      }
+    );
+  }
+
+  // The first index is stored without its top bit, so it must be below 8.
+  // Swapping the endpoints mirrors the indices.
+  if (best.indices[0] >= 8) {
+    std::swap(best.q0, best.q1);
+    std::swap(best.p0, best.p1);
+    for (uint8_t& index : best.indices) { index = 15 - index; }
+  }
+  std::memset(out, 0, 16);
+  BitWriter writer(out);
+  writer.Write(1 << 6, 7);
+  for (int channel = 0; channel < 4; ++channel) {
+    writer.Write(best.q0[channel], 7);
+    writer.Write(best.q1[channel], 7);
+  }
+  writer.Write(best.p0, 1);
+  writer.Write(best.p1, 1);
+  writer.Write(best.indices[0], 3);
+  for (int i = 1; i < kBlockTexels; ++i) { writer.Write(best.indices[i], 4); }
+  return best.error;
+}
+
+void DecodeBC7(const uint8_t* in, uint8_t* out) {
+  // The mode is the position of the lowest set bit
+  if ((in[0] & 0x7f) != 1 << 6) {
+    for (int i = 0; i < kBlockTexels; ++i) {
+      out[i * 4] = 255;
+      out[i * 4 + 1] = 0;
+      out[i * 4 + 2] = 255;
+      out[i * 4 + 3] = 255;
+    }
+    return;
+  }
+  BitReader reader(in);
+  reader.Read(7);
+  glm::ivec4 q0;
+  glm::ivec4 q1;
+  for (int channel = 0; channel < 4; ++channel) {
+    q0[channel] = static_cast<int>(reader.Read(7));
+    q1[channel] = static_cast<int>(reader.Read(7));
+  }
+  const glm::ivec4 e0 = ExpandBC7(q0, static_cast<int>(reader.Read(1)));
+  const glm::ivec4 e1 = ExpandBC7(q1, static_cast<int>(reader.Read(1)));
+  for (int i = 0; i < kBlockTexels; ++i) {
+    const int weight = kBC7Weights[reader.Read(i == 0 ? 3 : 4)];
+    const glm::ivec4 color = ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    for (int channel = 0; channel < 4; ++channel) {
+      out[i * 4 + channel] = static_cast<uint8_t>(color[channel]);
+    }
+  }
+}
+
+size_t GetBlockBytes(TextureFormat format) {
+  return format == TextureFormat::kBC1 ? 8 : 16;
+}
+}  // namespace
+
+namespace block_kernels {
+
+float FindNearestScalar(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  float total = 0.0f;
+  for (int i = 0; i < kBlockTexels; ++i) {
+    float bestDistance = kInfiniteError;
+    uint8_t bestIndex = 0;
+    for (size_t p = 0; p < paletteSize; ++p) {
+      const float* color = palette + p * 4;
+      const float dr = block.r[i] - color[0];
+      const float dg = block.g[i] - color[1];
+      const float db = block.b[i] - color[2];
+      const float da = block.a[i] - color[3];
+      const float distance =
+        channelWeights[0] * dr * dr + channelWeights[1] * dg * dg +
+        channelWeights[2] * db * db + channelWeights[3] * da * da;
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        bestIndex = static_cast<uint8_t>(p);
+      }
+    }
+    indices[i] = bestIndex;
+    total += bestDistance;
+  }
+  return total;
+}
+
+#if LIZUAL_SIMD_X86
+
+float FindNearestSSE2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  const __m128 weightR = _mm_set1_ps(channelWeights[0]);
+  const __m128 weightG = _mm_set1_ps(channelWeights[1]);
+  const __m128 weightB = _mm_set1_ps(channelWeights[2]);
+  const __m128 weightA = _mm_set1_ps(channelWeights[3]);
+  __m128 total = _mm_setzero_ps();
+  // Four texels per register, every palette entry tested against all four
+  for (int i = 0; i < kBlockTexels; i += 4) {
+    const __m128 r = _mm_load_ps(block.r + i);
+    const __m128 g = _mm_load_ps(block.g + i);
+    const __m128 b = _mm_load_ps(block.b + i);
+    const __m128 a = _mm_load_ps(block.a + i);
+    __m128 bestDistance = _mm_set1_ps(kInfiniteError);
+    __m128i bestIndex = _mm_setzero_si128();
+    for (size_t p = 0; p < paletteSize; ++p) {
+      const float* color = palette + p * 4;
+      const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(color[0]));
+      const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(color[1]));
+      const __m128 db = _mm_sub_ps(b, _mm_set1_ps(color[2]));
+      const __m128 da = _mm_sub_ps(a, _mm_set1_ps(color[3]));
+      const __m128 distance = _mm_add_ps(
+        _mm_add_ps(
+          _mm_mul_ps(weightR, _mm_mul_ps(dr, dr)),
+          _mm_mul_ps(weightG, _mm_mul_ps(dg, dg))
+        ),
+        _mm_add_ps(
+          _mm_mul_ps(weightB, _mm_mul_ps(db, db)),
+          _mm_mul_ps(weightA, _mm_mul_ps(da, da))
+        )
+      );
+      const __m128i closer =
+        _mm_castps_si128(_mm_cmplt_ps(distance, bestDistance));
+      bestDistance = _mm_min_ps(distance, bestDistance);
+      bestIndex = _mm_or_si128(
+        _mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))),
+        _mm_andnot_si128(closer, bestIndex)
+      );
+    }
+    total = _mm_add_ps(total, bestDistance);
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+    for (int lane = 0; lane < 4; ++lane) {
+      indices[i + lane] = static_cast<uint8_t>(lanes[lane]);
+    }
+  }
+  alignas(16) float sums[4];
+  _mm_store_ps(sums, total);
+  return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+#if !LIZUAL_AVX2_KERNELS
+// This build has no AVX2 kernels (see CMakeLists.txt), so the AVX2
+// translation unit is empty and AVX2 requests fall back to SSE2.
+float FindNearestAVX2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  return FindNearestSSE2(block, palette, paletteSize, channelWeights, indices);
+}
+#endif
+
+#else
+
+float FindNearestSSE2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  return FindNearestScalar(
+    block, palette, paletteSize, channelWeights, indices
+  );
+}
+
+float FindNearestAVX2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  return FindNearestScalar(
+    block, palette, paletteSize, channelWeights, indices
+  );
+}
+
+#endif  // LIZUAL_SIMD_X86
+
+}  // namespace block_kernels
+
+std::optional<BlockQuality> ParseBlockQuality(std::string_view name) {
+  for (const auto& entry : kQualityNames) {
+    if (name == entry.name) { return entry.quality; }
+  }
+  return std::nullopt;
+}
+
+const char* GetBlockQualityName(BlockQuality quality) {
+  for (const auto& entry : kQualityNames) {
+    if (entry.quality == quality) { return entry.name; }
+  }
+  return "unknown";
+}
+
+std::vector<uint8_t> CompressImage(
+  std::span<const uint8_t> rgba,
+  int width,
+  int height,
+  TextureFormat format,
+  const BlockSettings& settings,
+  JobSystem* jobs
+) {
+  const int blocksX = (width + 3) / 4;
+  const int blocksY = (height + 3) / 4;
+  const size_t blockBytes = GetBlockBytes(format);
+  std::vector<uint8_t> out(GetTextureLevelSize(format, width, height));
+
+  auto encodeRows = [&](int firstRow, int endRow) {
+    for (int blockY = firstRow; blockY < endRow; ++blockY) {
+      for (int blockX = 0; blockX < blocksX; ++blockX) {
+        const Block block = LoadBlock(rgba, width, height, blockX, blockY);
+        uint8_t* blockOut =
+          &out[(static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes];
+        switch (format) {
+          case TextureFormat::kBC1:
+            EncodeBC1(block, settings, blockOut);
+            break;
+          case TextureFormat::kBC3:
+            EncodeBC4Alpha(block, settings, blockOut);
+            EncodeBC1(block, settings, blockOut + 8);
+            break;
+          case TextureFormat::kBC7:
+            EncodeBC7(block, settings, blockOut);
+            break;
+          case TextureFormat::kRGBA8:
+            break;
+        }
+      }
+    }
+  };
+
+  if (jobs == nullptr) {
+    encodeRows(0, blocksY);
+    return out;
+  }
+  jobs->ParallelFor(blocksY, 1, [&](size_t firstRow, size_t endRow) {
+    encodeRows(static_cast<int>(firstRow), static_cast<int>(endRow));
+  });
+  return out;
+}
+
+std::vector<uint8_t> DecompressImage(
+  std::span<const uint8_t> blocks, int width, int height, TextureFormat format
+) {
+  const int blocksX = (width + 3) / 4;
+  const int blocksY = (height + 3) / 4;
+  const size_t blockBytes = GetBlockBytes(format);
+  std::vector<uint8_t> out(static_cast<size_t>(width) * height * 4);
+  uint8_t texels[kBlockTexels * 4];
+  for (int blockY = 0; blockY < blocksY; ++blockY) {
+    for (int blockX = 0; blockX < blocksX; ++blockX) {
+      const uint8_t* in =
+        &blocks[(static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes];
+      switch (format) {
+        case TextureFormat::kBC1:
+          DecodeBC1(in, false, texels);
+          break;
+        case TextureFormat::kBC3:
+          // BC3 colors always use four color mode
+          DecodeBC1(in + 8, true, texels);
+          DecodeBC4Alpha(in, texels);
+          break;
+        case TextureFormat::kBC7:
+          DecodeBC7(in, texels);
+          break;
+        case TextureFormat::kRGBA8:
+          return {};
+      }
+      // Clip blocks that hang over the edge
+      const int rowTexels = std::min(4, width - blockX * 4);
+      for (int y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+        const size_t row = static_cast<size_t>(blockY) * 4 + y;
+        std::memcpy(
+          &out[(row * width + blockX * 4) * 4],
+          &texels[y * 16],
+          static_cast<size_t>(rowTexels) * 4
+        );
+      }
+    }
+  }
+  return out;
+}
+
+double ComputePsnr(
+  std::span<const uint8_t> expected,
+  std::span<const uint8_t> actual,
+  bool includeAlpha
+) {
+  double squaredError = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (i % 4 == 3 && !includeAlpha) { continue; }
+    const double difference =
+      static_cast<double>(expected[i]) - static_cast<double>(actual[i]);
+    squaredError += difference * difference;
+    ++count;
+  }
+  if (squaredError == 0.0) { return std::numeric_limits<double>::infinity(); }
+  const double meanSquaredError = squaredError / static_cast<double>(count);
+  return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "Simd.h"
+#include "TextureFile.h"
+
+class JobSystem;
+
+// Speed/quality tiers of the block encoders. Fast fits endpoints along a rough
+// principal axis of a block, normal converges the axis and refines the
+// endpoints by least squares, and high also searches the neighbouring
+// quantized endpoints.
+enum class BlockQuality { kFast, kNormal, kHigh };
+
+std::optional<BlockQuality> ParseBlockQuality(std::string_view name);
+const char* GetBlockQualityName(BlockQuality quality);
+
+struct BlockSettings {
+  BlockQuality quality = BlockQuality::kNormal;
+  SimdLevel simdLevel = GetSupportedSimdLevel();
+};
+
+// Compresses an RGBA8 image into a block compressed format (BC1, BC3 or BC7).
+// BC1 drops alpha, and BC7 only uses mode 6 (one RGBA line per block). Blocks
+// over the edge of sizes that aren't a multiple of 4 repeat the last row and
+// column. Rows of blocks are spread over jobs if given.
+std::vector<uint8_t> CompressImage(
+  std::span<const uint8_t> rgba,
+  int width,
+  int height,
+  TextureFormat format,
+  const BlockSettings& settings = {},
+  JobSystem* jobs = nullptr
+);
+
+// Decodes the output of CompressImage back to RGBA8, for drivers without the
+// compressed formats and to measure quality. Only decodes BC7 mode 6 blocks;
+// others come out magenta.
+std::vector<uint8_t> DecompressImage(
+  std::span<const uint8_t> blocks, int width, int height, TextureFormat format
+);
+
+// Peak signal-to-noise ratio between two RGBA8 images, in dB, over the color
+// channels and optionally alpha. Infinite if they are identical.
+double ComputePsnr(
+  std::span<const uint8_t> expected,
+  std::span<const uint8_t> actual,
+  bool includeAlpha
+);
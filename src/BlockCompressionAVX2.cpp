@@ -0,0 +1,71 @@
+// Built with AVX2 and FMA enabled (see CMakeLists.txt). Only called after
+// GetSupportedSimdLevel() has checked that the CPU supports them. Must not
+// include glm or other headers with inline functions shared with the rest of
+// the program.
+#include "BlockCompressionKernels.h"
+#include "Simd.h"
+
+#if LIZUAL_AVX2_KERNELS
+#include <immintrin.h>
+
+#include <limits>
+
+namespace block_kernels {
+
+float FindNearestAVX2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+) {
+  const __m256 weightR = _mm256_set1_ps(channelWeights[0]);
+  const __m256 weightG = _mm256_set1_ps(channelWeights[1]);
+  const __m256 weightB = _mm256_set1_ps(channelWeights[2]);
+  const __m256 weightA = _mm256_set1_ps(channelWeights[3]);
+  __m256 total = _mm256_setzero_ps();
+  // Eight texels per register, so a block is two passes over the palette
+  for (int i = 0; i < 16; i += 8) {
+    const __m256 r = _mm256_load_ps(block.r + i);
+    const __m256 g = _mm256_load_ps(block.g + i);
+    const __m256 b = _mm256_load_ps(block.b + i);
+    const __m256 a = _mm256_load_ps(block.a + i);
+    __m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 bestIndex = _mm256_setzero_ps();
+    for (size_t p = 0; p < paletteSize; ++p) {
+      const float* color = palette + p * 4;
+      const __m256 dr = _mm256_sub_ps(r, _mm256_set1_ps(color[0]));
+      const __m256 dg = _mm256_sub_ps(g, _mm256_set1_ps(color[1]));
+      const __m256 db = _mm256_sub_ps(b, _mm256_set1_ps(color[2]));
+      const __m256 da = _mm256_sub_ps(a, _mm256_set1_ps(color[3]));
+      __m256 distance = _mm256_mul_ps(weightR, _mm256_mul_ps(dr, dr));
+      distance = _mm256_fmadd_ps(weightG, _mm256_mul_ps(dg, dg), distance);
+      distance = _mm256_fmadd_ps(weightB, _mm256_mul_ps(db, db), distance);
+      distance = _mm256_fmadd_ps(weightA, _mm256_mul_ps(da, da), distance);
+      // Indices are carried as floats so one blend selects them
+      const __m256 closer = _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ);
+      bestDistance = _mm256_min_ps(distance, bestDistance);
+      bestIndex = _mm256_blendv_ps(
+        bestIndex, _mm256_set1_ps(static_cast<float>(p)), closer
+      );
+    }
+    total = _mm256_add_ps(total, bestDistance);
+    alignas(32) int32_t lanes[8];
+    _mm256_store_si256(
+      reinterpret_cast<__m256i*>(lanes), _mm256_cvttps_epi32(bestIndex)
+    );
+    for (int lane = 0; lane < 8; ++lane) {
+      indices[i + lane] = static_cast<uint8_t>(lanes[lane]);
+    }
+  }
+  const __m128 sum4 = _mm_add_ps(
+    _mm256_castps256_ps128(total), _mm256_extractf128_ps(total, 1)
+  );
+  alignas(16) float sums[4];
+  _mm_store_ps(sums, sum4);
+  return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+}  // namespace block_kernels
+
+#endif  // LIZUAL_AVX2_KERNELS
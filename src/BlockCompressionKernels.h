@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels behind the block compression encoders. Like TransformBatchKernels.h,
+// this is kept free of glm so the AVX2 translation unit can include it.
+namespace block_kernels {
+
+// A 4x4 texel block with one stream per channel, in 0-255
+struct alignas(32) Block {
+  float r[16];
+  float g[16];
+  float b[16];
+  float a[16];
+};
+
+// For every texel, picks the palette entry (paletteSize RGBA colors) with the
+// smallest squared distance, each channel's term scaled by channelWeights.
+// Writes the picks to indices and returns the sum of their distances. Ties
+// pick the lower index.
+float FindNearestScalar(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+);
+float FindNearestSSE2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+);
+float FindNearestAVX2(
+  const Block& block,
+  const float* palette,
+  size_t paletteSize,
+  const float* channelWeights,
+  uint8_t* indices
+);
+
+}  // namespace block_kernels
@@ -13,6 +13,27 @@ glm::mat4 Camera::GetViewMatrix() const {
   return view;
 }
 
+glm::mat4 Camera::GetProjectionMatrix(float aspectRatio) const {
+  return glm::perspective(
+    glm::radians(fieldOfView), aspectRatio, nearPlane, farPlane
+  );
+}
+
+Frustum Camera::GetFrustum(float aspectRatio) const {
+  return Frustum::FromMatrix(
+    GetProjectionMatrix(aspectRatio) * GetViewMatrix()
+  );
+}
+
+glm::vec3 Camera::GetRayDirection(glm::vec2 ndc, float aspectRatio) const {
+  // Point on the z = -1 plane in view space, then rotated into world space
+  const float tanHalfFov = glm::tan(glm::radians(fieldOfView) * 0.5f);
+  const glm::vec3 viewDirection(
+    ndc.x * tanHalfFov * aspectRatio, ndc.y * tanHalfFov, -1.0f
+  );
+  return glm::normalize(GetOrientation() * viewDirection);
+}
+
 glm::quat Camera::GetOrientation() const {
   return glm::quat{glm::vec3(glm::radians(pitch), glm::radians(yaw), 0.0f)};
 }
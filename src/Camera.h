@@ -1,7 +1,11 @@
+#pragma once
+
 #include <glm/gtx/quaternion.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include "Frustum.h"
+
 // First-person Camera
 class Camera {
  public:
@@ -12,7 +16,13 @@ class Camera {
   )
       : position(position), pitch(pitch), yaw(yaw) {};
   glm::mat4 GetViewMatrix() const;
+  glm::mat4 GetProjectionMatrix(float aspectRatio) const;
   glm::quat GetOrientation() const;
+  // World-space frustum of the view and projection matrices
+  Frustum GetFrustum(float aspectRatio) const;
+  // World-space direction (normalized) of the ray from the camera through a
+  // point in normalized device coordinates, e.g. the mouse cursor
+  glm::vec3 GetRayDirection(glm::vec2 ndc, float aspectRatio) const;
 
   // Update pitch and yaw by a given delta
   void Rotate(glm::vec2 deltaDegrees);
@@ -22,4 +32,9 @@ class Camera {
   glm::vec3 position;
   float pitch;
   float yaw;
+
+  // Vertical field of view in degrees
+  float fieldOfView = 45.0f;
+  float nearPlane = 0.1f;
+  float farPlane = 100.0f;
 };
@@ -0,0 +1,196 @@
+#include "DrawCommands.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace {
+constexpr int kDepthBits = 19;
+constexpr uint64_t kDepthMask = (uint64_t{1} << kDepthBits) - 1;
+constexpr int kPassShift = 60;
+constexpr int kTranslucentShift = 59;
+// Opaque layout: state, then depth in the low bits
+constexpr int kOpaqueProgramShift = 51;
+constexpr int kOpaqueTextureShift = 35;
+constexpr int kOpaqueMeshShift = 19;
+// Translucent layout: depth right after the translucent bit, then state
+constexpr int kTranslucentDepthShift = 40;
+constexpr int kTranslucentProgramShift = 32;
+constexpr int kTranslucentTextureShift = 16;
+
+// Commands per chunk of the radix sort at least, below which a chunk costs
+// more to schedule than it takes to sort
+constexpr size_t kMinSortChunkSize = 16384;
+// Chunks per thread, so a slow chunk doesn't hold up the rest
+constexpr size_t kSortChunksPerThread = 4;
+
+bool IsTranslucent(uint64_t key) { return (key >> kTranslucentShift) & 1; }
+
+int GetDepthShift(uint64_t key) {
+  return IsTranslucent(key) ? kTranslucentDepthShift : 0;
+}
+
+uint64_t GetStateBits(uint64_t key) {
+  return key & ~(kDepthMask << GetDepthShift(key));
+}
+
+// Calls body(chunk) for every chunk in [0, chunkCount), over jobs if given
+template <typename Body>
+void ForEachChunk(JobSystem* jobs, size_t chunkCount, const Body& body) {
+  if (jobs == nullptr || chunkCount == 1) {
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) { body(chunk); }
+    return;
+  }
+  jobs->ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) { body(chunk); }
+  });
+}
+}  // namespace
+
+uint64_t EncodeSortKey(const DrawKey& key) {
+  const uint64_t depth = static_cast<uint64_t>(
+    std::lround(std::clamp(key.depth, 0.0f, 1.0f) * kDepthMask)
+  );
+  const uint64_t head = static_cast<uint64_t>(key.pass & 0xf) << kPassShift |
+                        static_cast<uint64_t>(key.translucent)
+                          << kTranslucentShift;
+  if (key.translucent) {
+    return head | (kDepthMask - depth) << kTranslucentDepthShift |
+           static_cast<uint64_t>(key.program) << kTranslucentProgramShift |
+           static_cast<uint64_t>(key.texture) << kTranslucentTextureShift |
+           key.mesh;
+  }
+  return head | static_cast<uint64_t>(key.program) << kOpaqueProgramShift |
+         static_cast<uint64_t>(key.texture) << kOpaqueTextureShift |
+         static_cast<uint64_t>(key.mesh) << kOpaqueMeshShift | depth;
+}
+
+DrawKey DecodeSortKey(uint64_t key) {
+  DrawKey decoded;
+  decoded.pass = static_cast<uint8_t>(key >> kPassShift);
+  decoded.translucent = IsTranslucent(key);
+  if (decoded.translucent) {
+    decoded.program = static_cast<uint8_t>(key >> kTranslucentProgramShift);
+    decoded.texture = static_cast<uint16_t>(key >> kTranslucentTextureShift);
+    decoded.mesh = static_cast<uint16_t>(key);
+    const uint64_t depth = (key >> kTranslucentDepthShift) & kDepthMask;
+    decoded.depth = static_cast<float>(kDepthMask - depth) / kDepthMask;
+  } else {
+    decoded.program = static_cast<uint8_t>(key >> kOpaqueProgramShift);
+    decoded.texture = static_cast<uint16_t>(key >> kOpaqueTextureShift);
+    decoded.mesh = static_cast<uint16_t>(key >> kOpaqueMeshShift);
+    decoded.depth = static_cast<float>(key & kDepthMask) / kDepthMask;
+  }
+  return decoded;
+}
+
+bool HasSameDrawState(uint64_t a, uint64_t b) {
+  return GetStateBits(a) == GetStateBits(b);
+}
+
+DrawCommandList::DrawCommandList(size_t threadCount)
+    : buffers_(std::max<size_t>(threadCount, 1)) {}
+
+void DrawCommandList::Clear() {
+  for (Buffer& buffer : buffers_) { buffer.commands.clear(); }
+}
+
+std::span<const DrawCommand> DrawCommandList::Sort(JobSystem* jobs) {
+  LIZUAL_PROFILE_SCOPE("Sort draw commands");
+  // Merge the buffers, noting which key bits differ between commands
+  std::vector<size_t> offsets(buffers_.size() + 1, 0);
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    offsets[i + 1] = offsets[i] + buffers_[i].commands.size();
+  }
+  sorted_.resize(offsets.back());
+  scratch_.resize(offsets.back());
+  std::vector<uint64_t> keysOr(buffers_.size(), 0);
+  std::vector<uint64_t> keysAnd(buffers_.size(), ~uint64_t{0});
+  ForEachChunk(jobs, buffers_.size(), [&](size_t i) {
+    const std::vector<DrawCommand>& commands = buffers_[i].commands;
+    std::copy(commands.begin(), commands.end(), sorted_.begin() + offsets[i]);
+    for (const DrawCommand& command : commands) {
+      keysOr[i] |= command.key;
+      keysAnd[i] &= command.key;
+    }
+  });
+  uint64_t differingBits = 0;
+  uint64_t commonBits = ~uint64_t{0};
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    differingBits |= keysOr[i];
+    commonBits &= keysAnd[i];
+  }
+  differingBits &= ~commonBits;
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    if (((differingBits >> shift) & 0xff) != 0) { SortByByte(shift, jobs); }
+  }
+  return sorted_;
+}
+
+void DrawCommandList::SortByByte(int shift, JobSystem* jobs) {
+  const size_t count = sorted_.size();
+  const size_t threadCount = jobs != nullptr ? jobs->GetThreadCount() : 1;
+  const size_t chunkSize = std::max(
+    kMinSortChunkSize,
+    (count + threadCount * kSortChunksPerThread - 1) /
+      (threadCount * kSortChunksPerThread)
+  );
+  const size_t chunkCount =
+    std::max<size_t>((count + chunkSize - 1) / chunkSize, 1);
+  histograms_.assign(chunkCount, {});
+  auto getByte = [shift](const DrawCommand& command) {
+    return static_cast<uint8_t>(command.key >> shift);
+  };
+
+  ForEachChunk(jobs, chunkCount, [&](size_t chunk) {
+    std::array<uint32_t, 256>& histogram = histograms_[chunk];
+    const size_t end = std::min(count, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; ++i) {
+      ++histogram[getByte(sorted_[i])];
+    }
+  });
+  // Byte-major, chunk-minor, so each chunk writes a byte value after the
+  // chunks before it and the sort stays stable
+  uint32_t offset = 0;
+  for (size_t byte = 0; byte < 256; ++byte) {
+    for (std::array<uint32_t, 256>& histogram : histograms_) {
+      const uint32_t byteCount = histogram[byte];
+      histogram[byte] = offset;
+      offset += byteCount;
+    }
+  }
+  ForEachChunk(jobs, chunkCount, [&](size_t chunk) {
+    std::array<uint32_t, 256>& cursors = histograms_[chunk];
+    const size_t end = std::min(count, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; ++i) {
+      scratch_[cursors[getByte(sorted_[i])]++] = sorted_[i];
+    }
+  });
+  sorted_.swap(scratch_);
+}
+
+void BuildDrawCalls(
+  std::span<const DrawCommand> sorted, std::vector<DrawCall>& draws
+) {
+  draws.clear();
+  size_t first = 0;
+  while (first < sorted.size()) {
+    const uint64_t key = sorted[first].key;
+    size_t end = first + 1;
+    while (end < sorted.size() && HasSameDrawState(key, sorted[end].key)) {
+      ++end;
+    }
+    const DrawKey state = DecodeSortKey(key);
+    draws.push_back({
+      state.program,
+      state.texture,
+      state.mesh,
+      static_cast<uint32_t>(first),
+      static_cast<uint32_t>(end - first),
+    });
+    first = end;
+  }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class JobSystem;
+
+// What a draw needs, in the order draws are sorted by
+struct DrawKey {
+  // Passes are drawn in order, e.g. the scene before anything drawn over it
+  uint8_t pass = 0;
+  // Translucent draws come after the opaque ones of their pass
+  bool translucent = false;
+  uint8_t program = 0;
+  // Texture, or texture array, bound to unit 0
+  uint16_t texture = 0;
+  uint16_t mesh = 0;
+  // Distance from the camera: 0 at the camera, 1 at the far plane
+  float depth = 0.0f;
+};
+
+// Packs a key into 64 bits, most significant first: pass (4 bits),
+// translucent (1), program (8), texture (16), mesh (16) and depth (19).
+// Opaque draws of the same state are therefore adjacent, and front to back
+// among themselves so the depth test rejects hidden fragments early.
+// Translucent draws move the depth, inverted to go back to front, up to right
+// after the translucent bit, as blending needs that order more than it needs
+// fewer state changes.
+uint64_t EncodeSortKey(const DrawKey& key);
+// Unpacks a key, with the depth quantized to its 19 bits
+DrawKey DecodeSortKey(uint64_t key);
+// Whether two keys differ in depth only, so their draws can share one
+// instanced draw call
+bool HasSameDrawState(uint64_t a, uint64_t b);
+
+// One object to draw, recorded by the frame's jobs
+struct DrawCommand {
+  uint64_t key;
+  uint32_t object;
+};
+
+// Instanced draw of a run of sorted commands with the same state. Instance i
+// is the command at firstInstance + i.
+struct DrawCall {
+  uint8_t program;
+  uint16_t texture;
+  uint16_t mesh;
+  uint32_t firstInstance;
+  uint32_t instanceCount;
+};
+
+// Draw commands recorded by several threads at once, each into a buffer of
+// its own so recording takes no locks, then merged and sorted by key.
+class DrawCommandList {
+ public:
+  // One buffer per recording thread, e.g. JobSystem::GetThreadCount()
+  explicit DrawCommandList(size_t threadCount);
+
+  // Empties the buffers, keeping their storage
+  void Clear();
+  // Buffer of the thread with threadIndex. Only that thread may record into
+  // it, until Sort.
+  std::vector<DrawCommand>& GetBuffer(size_t threadIndex) {
+    return buffers_[threadIndex].commands;
+  }
+
+  // Merges the buffers in thread order and sorts the commands by key with an
+  // LSD radix sort, spread over jobs if given. Only the key bytes that differ
+  // between commands get a pass, so a frame whose draws share a pass and
+  // program skips those bytes. Commands with equal keys stay in recording
+  // order. Valid until the next Sort.
+  std::span<const DrawCommand> Sort(JobSystem* jobs = nullptr);
+
+  size_t GetThreadCount() const { return buffers_.size(); }
+
+ private:
+  // Kept on separate cache lines, as threads append to them at once
+  struct alignas(64) Buffer {
+    std::vector<DrawCommand> commands;
+  };
+
+  // Stable counting sort of sorted_ by the byte at shift, into scratch_, then
+  // swaps the two. Each chunk counts and scatters its commands on its own.
+  void SortByByte(int shift, JobSystem* jobs);
+
+  std::vector<Buffer> buffers_;
+  std::vector<DrawCommand> sorted_;
+  std::vector<DrawCommand> scratch_;
+  // Per chunk: count of each byte value, then where the chunk writes it
+  std::vector<std::array<uint32_t, 256>> histograms_;
+};
+
+// Replaces draws with one draw call per run of sorted commands with the same
+// state
+void BuildDrawCalls(
+  std::span<const DrawCommand> sorted, std::vector<DrawCall>& draws
+);
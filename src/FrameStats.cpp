@@ -0,0 +1,138 @@
+#include "FrameStats.h"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+#include "JsonWriter.h"
+
+namespace {
+double ToMilliseconds(uint64_t ns) {
+  return static_cast<double>(ns) / SDL_NS_PER_MS;
+}
+}  // namespace
+
+FrameStats::FrameStats(double budgetMs, size_t capacity)
+    : budgetMs_(budgetMs),
+      totalFrames_(0),
+      totalOverBudget_(0),
+      maxFrameNs_(0) {
+  frameNs_.resize(std::max<size_t>(capacity, 1));
+}
+
+void FrameStats::Record(uint64_t frameNs) {
+  frameNs_[totalFrames_ % frameNs_.size()] = frameNs;
+  ++totalFrames_;
+  if (ToMilliseconds(frameNs) > budgetMs_) { ++totalOverBudget_; }
+  maxFrameNs_ = std::max(maxFrameNs_, frameNs);
+}
+
+FrameStats::Summary FrameStats::ComputeSummary() const {
+  Summary summary;
+  summary.frameCount = std::min<size_t>(totalFrames_, frameNs_.size());
+  if (summary.frameCount == 0) { return summary; }
+
+  scratch_.assign(frameNs_.begin(), frameNs_.begin() + summary.frameCount);
+  const uint64_t totalNs =
+    std::accumulate(scratch_.begin(), scratch_.end(), uint64_t{0});
+  summary.meanMs = ToMilliseconds(totalNs) / summary.frameCount;
+  summary.overBudgetCount = std::count_if(
+    scratch_.begin(), scratch_.end(), [this](uint64_t frameNs) {
+      return ToMilliseconds(frameNs) > budgetMs_;
+    }
+  );
+
+  // Nearest-rank percentiles in increasing order, so each selection only
+  // needs to look at the part above the previous one
+  const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  double* results[] = {
+    &summary.p50Ms, &summary.p90Ms, &summary.p99Ms, &summary.p999Ms
+  };
+  auto first = scratch_.begin();
+  for (size_t i = 0; i < std::size(percentiles); ++i) {
+    const size_t rank = static_cast<size_t>(
+      std::ceil(percentiles[i] * summary.frameCount) - 1
+    );
+    const auto nth = scratch_.begin() + rank;
+    std::nth_element(first, nth, scratch_.end());
+    *results[i] = ToMilliseconds(*nth);
+    first = nth;
+  }
+  summary.maxMs = ToMilliseconds(*std::max_element(first, scratch_.end()));
+  return summary;
+}
+
+void FrameStats::GetRecentFrameTimes(
+  size_t maxCount, std::vector<float>& out
+) const {
+  const uint64_t count = std::min<uint64_t>(
+    {maxCount, totalFrames_, frameNs_.size()}
+  );
+  for (uint64_t i = totalFrames_ - count; i < totalFrames_; ++i) {
+    out.push_back(
+      static_cast<float>(ToMilliseconds(frameNs_[i % frameNs_.size()]))
+    );
+  }
+}
+
+void FrameStats::ComputeHistogram(
+  double maxMs, size_t binCount, std::vector<float>& out
+) const {
+  out.assign(binCount, 0.0f);
+  if (binCount == 0 || maxMs <= 0.0) { return; }
+
+  const size_t frameCount = std::min<size_t>(totalFrames_, frameNs_.size());
+  for (size_t i = 0; i < frameCount; ++i) {
+    const size_t bin = static_cast<size_t>(
+      ToMilliseconds(frameNs_[i]) / maxMs * binCount
+    );
+    out[std::min(bin, binCount - 1)] += 1.0f;
+  }
+}
+
+void FrameStats::WriteJson(JsonWriter& writer) const {
+  const Summary summary = ComputeSummary();
+  writer.BeginObject();
+  writer.Field("budget_ms", budgetMs_);
+  writer.Field("total_frames", totalFrames_);
+  writer.Field("total_over_budget", totalOverBudget_);
+  writer.Field("total_max_ms", ToMilliseconds(maxFrameNs_));
+  writer.Key("window");
+  writer.BeginObject();
+  writer.Field("frames", summary.frameCount);
+  writer.Field("mean_ms", summary.meanMs);
+  writer.Field("p50_ms", summary.p50Ms);
+  writer.Field("p90_ms", summary.p90Ms);
+  writer.Field("p99_ms", summary.p99Ms);
+  writer.Field("p99.9_ms", summary.p999Ms);
+  writer.Field("max_ms", summary.maxMs);
+  writer.Field("over_budget", summary.overBudgetCount);
+  writer.EndObject();
+  writer.EndObject();
+}
+
+bool FrameStats::WriteReport(const std::filesystem::path& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    SDL_Log(
+      "FrameStats: Failed to open report file for writing: %s",
+      path.string().c_str()
+    );
+    return false;
+  }
+
+  JsonWriter writer(out);
+  WriteJson(writer);
+  if (!out) {
+    SDL_Log(
+      "FrameStats: Failed to write report file: %s", path.string().c_str()
+    );
+    return false;
+  }
+  SDL_Log("FrameStats: Wrote report to %s", path.string().c_str());
+  return true;
+}
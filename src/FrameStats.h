@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class JsonWriter;
+
+// Rolling record of frame times with tail-latency statistics. Keeps the last
+// `capacity` frames; averages hide hitches, percentiles and the over-budget
+// count do not.
+class FrameStats {
+ public:
+  static constexpr size_t kDefaultCapacity = 10'000;
+
+  struct Summary {
+    // Frames in the window
+    size_t frameCount = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p99Ms = 0.0;
+    double p999Ms = 0.0;
+    double maxMs = 0.0;
+    // Frames in the window that took longer than the budget
+    size_t overBudgetCount = 0;
+  };
+
+  explicit FrameStats(double budgetMs, size_t capacity = kDefaultCapacity);
+
+  void Record(uint64_t frameNs);
+
+  // Statistics over the frames currently in the window. O(capacity).
+  Summary ComputeSummary() const;
+
+  // Frame times in milliseconds, oldest first, for graphs. Appends at most the
+  // last maxCount frames.
+  void GetRecentFrameTimes(size_t maxCount, std::vector<float>& out) const;
+
+  // Counts frames of the window into binCount equal bins over [0, maxMs].
+  // Longer frames land in the last bin.
+  void ComputeHistogram(
+    double maxMs, size_t binCount, std::vector<float>& out
+  ) const;
+
+  // Writes the summary and lifetime totals as a JSON object
+  void WriteJson(JsonWriter& writer) const;
+  // Writes WriteJson's object to a file. Returns false if the file could not
+  // be written.
+  bool WriteReport(const std::filesystem::path& path) const;
+
+  double GetBudgetMs() const { return budgetMs_; }
+  // Frames recorded since construction, including those no longer in the
+  // window
+  uint64_t GetTotalFrameCount() const { return totalFrames_; }
+  uint64_t GetTotalOverBudgetCount() const { return totalOverBudget_; }
+
+ private:
+  double budgetMs_;
+  // Ring of frame times in nanoseconds; frame i is at i % capacity
+  std::vector<uint64_t> frameNs_;
+  uint64_t totalFrames_;
+  uint64_t totalOverBudget_;
+  uint64_t maxFrameNs_;
+  // Reused by ComputeSummary to avoid allocating every frame
+  mutable std::vector<uint64_t> scratch_;
+};
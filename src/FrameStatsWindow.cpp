@@ -0,0 +1,86 @@
+#include "FrameStatsWindow.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+constexpr size_t kGraphFrameCount = 600;
+constexpr size_t kHistogramBinCount = 60;
+constexpr float kPlotHeight = 80.0f;
+}  // namespace
+
+void FrameStatsWindow::Draw(
+  const FrameStats& stats, const FrameStats::Summary& summary
+) {
+  if (!open) { return; }
+
+  ImGui::SetNextWindowSize(ImVec2(480, 360), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Frame times", &open)) {
+    ImGui::End();
+    return;
+  }
+
+  const double overBudgetPercent =
+    summary.frameCount > 0
+      ? 100.0 * summary.overBudgetCount / summary.frameCount
+      : 0.0;
+  ImGui::Text(
+    "Last %zu frames, budget %.2f ms", summary.frameCount, stats.GetBudgetMs()
+  );
+  ImGui::Text(
+    "mean %.2f  p50 %.2f  p90 %.2f ms",
+    summary.meanMs,
+    summary.p50Ms,
+    summary.p90Ms
+  );
+  ImGui::Text(
+    "p99 %.2f  p99.9 %.2f  max %.2f ms",
+    summary.p99Ms,
+    summary.p999Ms,
+    summary.maxMs
+  );
+  ImGui::Text(
+    "Over budget: %zu (%.2f%%), %llu of %llu since start",
+    summary.overBudgetCount,
+    overBudgetPercent,
+    static_cast<unsigned long long>(stats.GetTotalOverBudgetCount()),
+    static_cast<unsigned long long>(stats.GetTotalFrameCount())
+  );
+
+  // Both plots share a range that shows the budget and the tail
+  const float plotMaxMs = static_cast<float>(
+    std::max(2.0 * stats.GetBudgetMs(), summary.p999Ms * 1.1)
+  );
+  const float plotWidth = ImGui::GetContentRegionAvail().x;
+
+  recentFrameTimes_.clear();
+  stats.GetRecentFrameTimes(kGraphFrameCount, recentFrameTimes_);
+  ImGui::PlotLines(
+    "##FrameTimes",
+    recentFrameTimes_.data(),
+    static_cast<int>(recentFrameTimes_.size()),
+    0,
+    "frame time",
+    0.0f,
+    plotMaxMs,
+    ImVec2(plotWidth, kPlotHeight)
+  );
+
+  stats.ComputeHistogram(plotMaxMs, kHistogramBinCount, histogram_);
+  char overlay[64];
+  std::snprintf(overlay, sizeof(overlay), "0 - %.1f ms", plotMaxMs);
+  ImGui::PlotHistogram(
+    "##Histogram",
+    histogram_.data(),
+    static_cast<int>(histogram_.size()),
+    0,
+    overlay,
+    0.0f,
+    *std::max_element(histogram_.begin(), histogram_.end()),
+    ImVec2(plotWidth, kPlotHeight)
+  );
+
+  ImGui::End();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include "FrameStats.h"
+
+// ImGui window with frame-time percentiles, a graph of the recent frames and
+// a histogram of the whole window
+class FrameStatsWindow {
+ public:
+  // Draws the window if open. Call between ImGui::NewFrame and ImGui::Render.
+  void Draw(const FrameStats& stats, const FrameStats::Summary& summary);
+
+  bool open = false;
+
+ private:
+  std::vector<float> recentFrameTimes_;
+  std::vector<float> histogram_;
+};
@@ -0,0 +1,414 @@
+#include "Frustum.h"
+
+#include <glm/geometric.hpp>
+
+#include <bit>
+#include <cmath>
+
+#include "FrustumKernels.h"
+
+#if LIZUAL_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection) {
+  // glm is column-major, so row i of the matrix is m[0][i], m[1][i], ...
+  const glm::mat4& m = viewProjection;
+  const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+  Frustum frustum;
+  frustum.planes[kLeft] = row3 + row0;
+  frustum.planes[kRight] = row3 - row0;
+  frustum.planes[kBottom] = row3 + row1;
+  frustum.planes[kTop] = row3 - row1;
+  frustum.planes[kNear] = row3 + row2;
+  frustum.planes[kFar] = row3 - row2;
+  for (glm::vec4& plane : frustum.planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return frustum;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+  for (const glm::vec4& plane : planes) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Frustum::Containment Frustum::ClassifyAABB(
+  const glm::vec3& min, const glm::vec3& max
+) const {
+  const glm::vec3 center = (min + max) * 0.5f;
+  const glm::vec3 extent = (max - min) * 0.5f;
+  Containment result = Containment::kInside;
+  for (const glm::vec4& plane : planes) {
+    const glm::vec3 normal(plane);
+    const float distance = glm::dot(normal, center) + plane.w;
+    const float projectedExtent = glm::dot(glm::abs(normal), extent);
+    if (distance < -projectedExtent) { return Containment::kOutside; }
+    if (distance < projectedExtent) { result = Containment::kIntersecting; }
+  }
+  return result;
+}
+
+void BoundingSpheres::Resize(size_t size) {
+  centerX.resize(size);
+  centerY.resize(size);
+  centerZ.resize(size);
+  radius.resize(size);
+}
+
+void BoundingSpheres::Set(
+  size_t index, const glm::vec3& center, float sphereRadius
+) {
+  centerX[index] = center.x;
+  centerY[index] = center.y;
+  centerZ[index] = center.z;
+  radius[index] = sphereRadius;
+}
+
+void BoundingBoxes::Resize(size_t size) {
+  centerX.resize(size);
+  centerY.resize(size);
+  centerZ.resize(size);
+  extentX.resize(size);
+  extentY.resize(size);
+  extentZ.resize(size);
+}
+
+void BoundingBoxes::Set(
+  size_t index, const glm::vec3& min, const glm::vec3& max
+) {
+  const glm::vec3 center = (min + max) * 0.5f;
+  const glm::vec3 extent = (max - min) * 0.5f;
+  centerX[index] = center.x;
+  centerY[index] = center.y;
+  centerZ[index] = center.z;
+  extentX[index] = extent.x;
+  extentY[index] = extent.y;
+  extentZ[index] = extent.z;
+}
+
+namespace frustum_kernels {
+
+Volumes Advance(const Volumes& volumes, size_t index) {
+  return Volumes{
+    volumes.centerX + index,
+    volumes.centerY + index,
+    volumes.centerZ + index,
+    volumes.extentX + index,
+    volumes.extentY != nullptr ? volumes.extentY + index : nullptr,
+    volumes.extentZ != nullptr ? volumes.extentZ + index : nullptr,
+  };
+}
+
+size_t CullSpheresScalar(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  size_t visibleCount = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bool visible = true;
+    for (const float* plane : planes.planes) {
+      const float distance = plane[0] * volumes.centerX[i] +
+                             plane[1] * volumes.centerY[i] +
+                             plane[2] * volumes.centerZ[i] + plane[3];
+      visible = visible && distance >= -volumes.extentX[i];
+    }
+    // Branchless compaction: always write, only advance when visible
+    visibleIndices[visibleCount] = firstIndex + static_cast<uint32_t>(i);
+    visibleCount += visible;
+  }
+  return visibleCount;
+}
+
+size_t CullAABBsScalar(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  size_t visibleCount = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bool visible = true;
+    for (const float* plane : planes.planes) {
+      const float distance = plane[0] * volumes.centerX[i] +
+                             plane[1] * volumes.centerY[i] +
+                             plane[2] * volumes.centerZ[i] + plane[3];
+      const float projectedExtent = std::abs(plane[0]) * volumes.extentX[i] +
+                                    std::abs(plane[1]) * volumes.extentY[i] +
+                                    std::abs(plane[2]) * volumes.extentZ[i];
+      visible = visible && distance >= -projectedExtent;
+    }
+    visibleIndices[visibleCount] = firstIndex + static_cast<uint32_t>(i);
+    visibleCount += visible;
+  }
+  return visibleCount;
+}
+
+#if LIZUAL_SIMD_X86
+namespace {
+// Appends firstIndex + i for each set bit i of mask
+size_t AppendVisible(
+  int mask, uint32_t firstIndex, uint32_t* visibleIndices, size_t visibleCount
+) {
+  while (mask != 0) {
+    const int bit = std::countr_zero(static_cast<unsigned>(mask));
+    visibleIndices[visibleCount++] = firstIndex + static_cast<uint32_t>(bit);
+    mask &= mask - 1;
+  }
+  return visibleCount;
+}
+
+// Culls 4 volumes per iteration. kBoxes selects the box test, which projects
+// the half extents onto each plane normal instead of using a radius.
+template <bool kBoxes>
+size_t Cull4(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  size_t visibleCount = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 cx = _mm_loadu_ps(volumes.centerX + i);
+    const __m128 cy = _mm_loadu_ps(volumes.centerY + i);
+    const __m128 cz = _mm_loadu_ps(volumes.centerZ + i);
+    const __m128 ex = _mm_loadu_ps(volumes.extentX + i);
+    __m128 ey = ex;
+    __m128 ez = ex;
+    if constexpr (kBoxes) {
+      ey = _mm_loadu_ps(volumes.extentY + i);
+      ez = _mm_loadu_ps(volumes.extentZ + i);
+    }
+    __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const float* plane : planes.planes) {
+      const __m128 nx = _mm_set1_ps(plane[0]);
+      const __m128 ny = _mm_set1_ps(plane[1]);
+      const __m128 nz = _mm_set1_ps(plane[2]);
+      const __m128 distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+        _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(plane[3]))
+      );
+      __m128 projectedExtent = ex;
+      if constexpr (kBoxes) {
+        projectedExtent = _mm_add_ps(
+          _mm_add_ps(
+            _mm_mul_ps(_mm_andnot_ps(signMask, nx), ex),
+            _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)
+          ),
+          _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez)
+        );
+      }
+      // Visible while distance + extent >= 0 for every plane
+      visible = _mm_and_ps(
+        visible,
+        _mm_cmpge_ps(_mm_add_ps(distance, projectedExtent), _mm_setzero_ps())
+      );
+    }
+    visibleCount = AppendVisible(
+      _mm_movemask_ps(visible),
+      firstIndex + static_cast<uint32_t>(i),
+      visibleIndices,
+      visibleCount
+    );
+  }
+
+  // Tail
+  const Volumes tail = Advance(volumes, i);
+  const uint32_t tailFirstIndex = firstIndex + static_cast<uint32_t>(i);
+  if constexpr (kBoxes) {
+    visibleCount += CullAABBsScalar(
+      planes, tail, count - i, tailFirstIndex, visibleIndices + visibleCount
+    );
+  } else {
+    visibleCount += CullSpheresScalar(
+      planes, tail, count - i, tailFirstIndex, visibleIndices + visibleCount
+    );
+  }
+  return visibleCount;
+}
+}  // namespace
+
+size_t CullSpheresSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return Cull4<false>(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullAABBsSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return Cull4<true>(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+#if !LIZUAL_AVX2_KERNELS
+size_t CullSpheresAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullSpheresSSE2(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullAABBsAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullAABBsSSE2(planes, volumes, count, firstIndex, visibleIndices);
+}
+#endif
+
+#else
+
+size_t CullSpheresSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullSpheresScalar(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullSpheresAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullSpheresScalar(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullAABBsSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullAABBsScalar(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullAABBsAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return CullAABBsScalar(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+#endif  // LIZUAL_SIMD_X86
+
+}  // namespace frustum_kernels
+
+namespace {
+frustum_kernels::Planes ToKernelPlanes(const Frustum& frustum) {
+  frustum_kernels::Planes planes;
+  for (int i = 0; i < Frustum::kPlaneCount; ++i) {
+    for (int j = 0; j < 4; ++j) { planes.planes[i][j] = frustum.planes[i][j]; }
+  }
+  return planes;
+}
+}  // namespace
+
+size_t CullSpheres(
+  const Frustum& frustum,
+  const BoundingSpheres& spheres,
+  size_t begin,
+  size_t end,
+  uint32_t* visibleIndices,
+  SimdLevel level
+) {
+  const frustum_kernels::Planes planes = ToKernelPlanes(frustum);
+  const frustum_kernels::Volumes volumes{
+    spheres.centerX.data() + begin,
+    spheres.centerY.data() + begin,
+    spheres.centerZ.data() + begin,
+    spheres.radius.data() + begin,
+    nullptr,
+    nullptr,
+  };
+  const size_t count = end - begin;
+  const uint32_t firstIndex = static_cast<uint32_t>(begin);
+  switch (level) {
+    case SimdLevel::kScalar:
+      return frustum_kernels::CullSpheresScalar(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+    case SimdLevel::kSSE2:
+      return frustum_kernels::CullSpheresSSE2(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+    case SimdLevel::kAVX2:
+      return frustum_kernels::CullSpheresAVX2(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+  }
+  return 0;
+}
+
+size_t CullAABBs(
+  const Frustum& frustum,
+  const BoundingBoxes& boxes,
+  size_t begin,
+  size_t end,
+  uint32_t* visibleIndices,
+  SimdLevel level
+) {
+  const frustum_kernels::Planes planes = ToKernelPlanes(frustum);
+  const frustum_kernels::Volumes volumes{
+    boxes.centerX.data() + begin,
+    boxes.centerY.data() + begin,
+    boxes.centerZ.data() + begin,
+    boxes.extentX.data() + begin,
+    boxes.extentY.data() + begin,
+    boxes.extentZ.data() + begin,
+  };
+  const size_t count = end - begin;
+  const uint32_t firstIndex = static_cast<uint32_t>(begin);
+  switch (level) {
+    case SimdLevel::kScalar:
+      return frustum_kernels::CullAABBsScalar(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+    case SimdLevel::kSSE2:
+      return frustum_kernels::CullAABBsSSE2(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+    case SimdLevel::kAVX2:
+      return frustum_kernels::CullAABBsAVX2(
+        planes, volumes, count, firstIndex, visibleIndices
+      );
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simd.h"
+
+// A view frustum as six normalized planes (normal.xyz, distance.w) whose
+// normals point inwards, so a point p is inside a plane when
+// dot(normal, p) + distance >= 0.
+struct Frustum {
+  enum Plane { kLeft, kRight, kBottom, kTop, kNear, kFar, kPlaneCount };
+
+  // Result of testing a volume against all planes
+  enum class Containment { kOutside, kIntersecting, kInside };
+
+  // Extracts the planes of a projection * view matrix (Gribb & Hartmann), in
+  // world space.
+  static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+  bool IntersectsSphere(const glm::vec3& center, float radius) const;
+  Containment ClassifyAABB(const glm::vec3& min, const glm::vec3& max) const;
+
+  std::array<glm::vec4, kPlaneCount> planes;
+};
+
+// Bounding spheres in structure-of-arrays layout, for CullSpheres
+struct BoundingSpheres {
+  std::vector<float> centerX;
+  std::vector<float> centerY;
+  std::vector<float> centerZ;
+  std::vector<float> radius;
+
+  size_t Size() const { return centerX.size(); }
+  void Resize(size_t size);
+  void Set(size_t index, const glm::vec3& center, float radius);
+};
+
+// Axis-aligned boxes as center and half extents in structure-of-arrays layout,
+// for CullAABBs
+struct BoundingBoxes {
+  std::vector<float> centerX;
+  std::vector<float> centerY;
+  std::vector<float> centerZ;
+  std::vector<float> extentX;
+  std::vector<float> extentY;
+  std::vector<float> extentZ;
+
+  size_t Size() const { return centerX.size(); }
+  void Resize(size_t size);
+  void Set(size_t index, const glm::vec3& min, const glm::vec3& max);
+};
+
+// Tests spheres [begin, end) against the frustum 4 (SSE2) or 8 (AVX2) at a
+// time, and writes the indices of the ones that are at least partially inside
+// to visibleIndices, which must have room for end - begin entries. Returns the
+// number of visible spheres. Indices are written in increasing order.
+size_t CullSpheres(
+  const Frustum& frustum,
+  const BoundingSpheres& spheres,
+  size_t begin,
+  size_t end,
+  uint32_t* visibleIndices,
+  SimdLevel level = GetSupportedSimdLevel()
+);
+
+// Same as CullSpheres for axis-aligned boxes
+size_t CullAABBs(
+  const Frustum& frustum,
+  const BoundingBoxes& boxes,
+  size_t begin,
+  size_t end,
+  uint32_t* visibleIndices,
+  SimdLevel level = GetSupportedSimdLevel()
+);
@@ -0,0 +1,108 @@
+// Built with AVX2 and FMA enabled (see CMakeLists.txt), like
+// TransformBatchAVX2.cpp, and under the same restrictions.
+#include "FrustumKernels.h"
+#include "Simd.h"
+
+#if LIZUAL_AVX2_KERNELS
+#include <immintrin.h>
+
+namespace frustum_kernels {
+
+namespace {
+// 8-lane version of Cull4 in Frustum.cpp
+template <bool kBoxes>
+size_t Cull8(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  size_t visibleCount = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256 cx = _mm256_loadu_ps(volumes.centerX + i);
+    const __m256 cy = _mm256_loadu_ps(volumes.centerY + i);
+    const __m256 cz = _mm256_loadu_ps(volumes.centerZ + i);
+    const __m256 ex = _mm256_loadu_ps(volumes.extentX + i);
+    __m256 ey = ex;
+    __m256 ez = ex;
+    if constexpr (kBoxes) {
+      ey = _mm256_loadu_ps(volumes.extentY + i);
+      ez = _mm256_loadu_ps(volumes.extentZ + i);
+    }
+    __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const float* plane : planes.planes) {
+      const __m256 nx = _mm256_set1_ps(plane[0]);
+      const __m256 ny = _mm256_set1_ps(plane[1]);
+      const __m256 nz = _mm256_set1_ps(plane[2]);
+      __m256 distance = _mm256_fmadd_ps(nz, cz, _mm256_set1_ps(plane[3]));
+      distance = _mm256_fmadd_ps(ny, cy, distance);
+      distance = _mm256_fmadd_ps(nx, cx, distance);
+      // Add the radius, or the half extents projected onto the normal
+      if constexpr (kBoxes) {
+        const __m256 absX = _mm256_andnot_ps(signMask, nx);
+        const __m256 absY = _mm256_andnot_ps(signMask, ny);
+        const __m256 absZ = _mm256_andnot_ps(signMask, nz);
+        distance = _mm256_fmadd_ps(absX, ex, distance);
+        distance = _mm256_fmadd_ps(absY, ey, distance);
+        distance = _mm256_fmadd_ps(absZ, ez, distance);
+      } else {
+        distance = _mm256_add_ps(distance, ex);
+      }
+      visible = _mm256_and_ps(
+        visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ)
+      );
+    }
+
+    // Compacts without <bit>, which this file must not include. Every lane
+    // is written and only visible ones are kept, which stays in bounds as
+    // visibleCount never passes the index being written.
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(visible));
+    const uint32_t batchFirstIndex = firstIndex + static_cast<uint32_t>(i);
+    for (uint32_t lane = 0; lane < 8; ++lane) {
+      visibleIndices[visibleCount] = batchFirstIndex + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+
+  // The remaining volumes fit in one SSE2 batch plus scalar
+  const Volumes tail = Advance(volumes, i);
+  const uint32_t tailFirstIndex = firstIndex + static_cast<uint32_t>(i);
+  if constexpr (kBoxes) {
+    visibleCount += CullAABBsSSE2(
+      planes, tail, count - i, tailFirstIndex, visibleIndices + visibleCount
+    );
+  } else {
+    visibleCount += CullSpheresSSE2(
+      planes, tail, count - i, tailFirstIndex, visibleIndices + visibleCount
+    );
+  }
+  return visibleCount;
+}
+}  // namespace
+
+size_t CullSpheresAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return Cull8<false>(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+size_t CullAABBsAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+) {
+  return Cull8<true>(planes, volumes, count, firstIndex, visibleIndices);
+}
+
+}  // namespace frustum_kernels
+
+#endif  // LIZUAL_AVX2_KERNELS
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels behind CullSpheres and CullAABBs. Like TransformBatchKernels.h, this
+// is kept free of glm so the AVX2 translation unit can include it.
+namespace frustum_kernels {
+
+// Six planes as (x, y, z, w) rows
+struct Planes {
+  float planes[6][4];
+};
+
+// Volumes are centers plus either a radius (spheres) or three half extents
+// (boxes). Indices written to visibleIndices are offset by firstIndex.
+struct Volumes {
+  const float* centerX;
+  const float* centerY;
+  const float* centerZ;
+  // Spheres: radius. Boxes: extentX.
+  const float* extentX;
+  // Boxes only
+  const float* extentY;
+  const float* extentZ;
+};
+
+size_t CullSpheresScalar(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+size_t CullSpheresSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+size_t CullSpheresAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+
+size_t CullAABBsScalar(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+size_t CullAABBsSSE2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+size_t CullAABBsAVX2(
+  const Planes& planes,
+  const Volumes& volumes,
+  size_t count,
+  uint32_t firstIndex,
+  uint32_t* visibleIndices
+);
+
+// Offsets every stream by index
+Volumes Advance(const Volumes& volumes, size_t index);
+
+}  // namespace frustum_kernels
@@ -0,0 +1,260 @@
+#include "GLState.h"
+
+#include <array>
+#include <unordered_map>
+
+#include "GLStats.h"
+
+namespace {
+// Shadowed value that is not known, after startup or Invalidate. No GL name
+// or enum takes this value.
+constexpr GLuint kUnknown = 0xffffffffu;
+
+// Shadowed buffer targets and texture targets
+constexpr std::array<GLenum, 3> kBufferTargets = {
+  GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_PIXEL_UNPACK_BUFFER
+};
+constexpr std::array<GLenum, 2> kTextureTargets = {
+  GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY
+};
+constexpr std::array<GLenum, 4> kCapabilities = {
+  GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST
+};
+
+// Where an attribute of a vertex array points
+struct VertexAttribute {
+  GLuint buffer = kUnknown;
+  GLint size = 0;
+  GLenum type = 0;
+  bool normalized = false;
+  GLsizei stride = 0;
+  size_t offset = 0;
+
+  bool operator==(const VertexAttribute&) const = default;
+};
+
+using VertexAttributes =
+  std::array<VertexAttribute, GLState::kVertexAttributes>;
+
+struct Shadow {
+  GLuint program = kUnknown;
+  GLuint vertexArray = kUnknown;
+  std::array<GLuint, kBufferTargets.size()> buffers;
+  GLuint activeTexture = kUnknown;
+  std::array<std::array<GLuint, kTextureTargets.size()>, GLState::kTextureUnits>
+    textures;
+  // 0 or 1, or kUnknown
+  std::array<GLuint, kCapabilities.size()> capabilities;
+  GLuint blendSource = kUnknown;
+  GLuint blendDestination = kUnknown;
+  GLuint depthFunction = kUnknown;
+  GLuint depthMask = kUnknown;
+  std::array<GLint, 4> viewport;
+  bool viewportKnown = false;
+  // Attributes of the vertex arrays pointed through here, by name
+  std::unordered_map<GLuint, VertexAttributes> vertexArrays;
+
+  Shadow() {
+    buffers.fill(kUnknown);
+    for (auto& unit : textures) { unit.fill(kUnknown); }
+    capabilities.fill(kUnknown);
+  }
+};
+
+Shadow shadow;
+
+// Index of value in values, or -1 if it isn't shadowed
+template <size_t N>
+int FindIndex(const std::array<GLenum, N>& values, GLenum value) {
+  for (size_t i = 0; i < N; ++i) {
+    if (values[i] == value) { return static_cast<int>(i); }
+  }
+  return -1;
+}
+
+// Whether a call setting the shadowed value to value must be issued,
+// updating the shadow and the stats
+bool Update(GLuint& shadowed, GLuint value) {
+  const bool changed = shadowed != value;
+  shadowed = value;
+  GLStats::RecordStateChange(changed);
+  return changed;
+}
+
+// Forgets every shadowed binding of name
+template <typename Bindings>
+void Forget(Bindings& bindings, GLuint name) {
+  for (GLuint& binding : bindings) {
+    if (binding == name) { binding = kUnknown; }
+  }
+}
+}  // namespace
+
+void GLState::UseProgram(GLuint program) {
+  if (Update(shadow.program, program)) { glUseProgram(program); }
+}
+
+void GLState::BindVertexArray(GLuint vertexArray) {
+  if (Update(shadow.vertexArray, vertexArray)) {
+    glBindVertexArray(vertexArray);
+    shadow.buffers[FindIndex(kBufferTargets, GL_ELEMENT_ARRAY_BUFFER)] =
+      kUnknown;
+  }
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+  const int index = FindIndex(kBufferTargets, target);
+  if (index < 0) {
+    GLStats::RecordStateChange(true);
+    glBindBuffer(target, buffer);
+    return;
+  }
+  if (Update(shadow.buffers[index], buffer)) { glBindBuffer(target, buffer); }
+}
+
+void GLState::ActiveTexture(GLenum unit) {
+  if (Update(shadow.activeTexture, unit)) { glActiveTexture(unit); }
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture) {
+  const int index = FindIndex(kTextureTargets, target);
+  const GLuint unit = shadow.activeTexture - GL_TEXTURE0;
+  if (index < 0 || shadow.activeTexture == kUnknown || unit >= kTextureUnits) {
+    GLStats::RecordStateChange(true);
+    glBindTexture(target, texture);
+    return;
+  }
+  if (Update(shadow.textures[unit][index], texture)) {
+    glBindTexture(target, texture);
+  }
+}
+
+void GLState::SetEnabled(GLenum capability, bool enabled) {
+  const int index = FindIndex(kCapabilities, capability);
+  if (index < 0) {
+    GLStats::RecordStateChange(true);
+  } else if (!Update(shadow.capabilities[index], enabled)) {
+    return;
+  }
+  if (enabled) {
+    glEnable(capability);
+  } else {
+    glDisable(capability);
+  }
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination) {
+  if (shadow.blendSource == source && shadow.blendDestination == destination) {
+    GLStats::RecordStateChange(false);
+    return;
+  }
+  shadow.blendSource = source;
+  shadow.blendDestination = destination;
+  GLStats::RecordStateChange(true);
+  glBlendFunc(source, destination);
+}
+
+void GLState::DepthFunc(GLenum function) {
+  if (Update(shadow.depthFunction, function)) { glDepthFunc(function); }
+}
+
+void GLState::DepthMask(bool enabled) {
+  if (Update(shadow.depthMask, enabled)) {
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  }
+}
+
+void GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  const std::array<GLint, 4> viewport = {x, y, width, height};
+  if (shadow.viewportKnown && shadow.viewport == viewport) {
+    GLStats::RecordStateChange(false);
+    return;
+  }
+  shadow.viewport = viewport;
+  shadow.viewportKnown = true;
+  GLStats::RecordStateChange(true);
+  glViewport(x, y, width, height);
+}
+
+void GLState::VertexAttribPointer(
+  GLuint index,
+  GLint size,
+  GLenum type,
+  bool normalized,
+  GLsizei stride,
+  size_t offset
+) {
+  const GLuint buffer =
+    shadow.buffers[FindIndex(kBufferTargets, GL_ARRAY_BUFFER)];
+  if (shadow.vertexArray != kUnknown && index < kVertexAttributes) {
+    VertexAttribute& shadowed = shadow.vertexArrays[shadow.vertexArray][index];
+    const VertexAttribute attribute = {
+      buffer, size, type, normalized, stride, offset
+    };
+    // With the buffer unknown, so is the attribute after the call
+    const bool changed = buffer == kUnknown || shadowed != attribute;
+    shadowed = attribute;
+    GLStats::RecordStateChange(changed);
+    if (!changed) { return; }
+  } else {
+    GLStats::RecordStateChange(true);
+  }
+  glVertexAttribPointer(
+    index,
+    size,
+    type,
+    normalized ? GL_TRUE : GL_FALSE,
+    stride,
+    reinterpret_cast<const void*>(offset)
+  );
+}
+
+void GLState::SetVertexAttribArrayEnabled(GLuint index, bool enabled) {
+  GLStats::RecordStateChange(true);
+  if (enabled) {
+    glEnableVertexAttribArray(index);
+  } else {
+    glDisableVertexAttribArray(index);
+  }
+}
+
+void GLState::VertexAttribDivisor(GLuint index, GLuint divisor) {
+  GLStats::RecordStateChange(true);
+  glVertexAttribDivisor(index, divisor);
+}
+
+void GLState::DeleteProgram(GLuint program) {
+  if (shadow.program == program) { shadow.program = kUnknown; }
+  glDeleteProgram(program);
+}
+
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+  for (GLsizei i = 0; i < count; ++i) {
+    if (shadow.vertexArray == vertexArrays[i]) {
+      shadow.vertexArray = kUnknown;
+    }
+    shadow.vertexArrays.erase(vertexArrays[i]);
+  }
+  glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLState::DeleteBuffers(GLsizei count, const GLuint* buffers) {
+  for (GLsizei i = 0; i < count; ++i) {
+    Forget(shadow.buffers, buffers[i]);
+    for (auto& [vertexArray, attributes] : shadow.vertexArrays) {
+      for (VertexAttribute& attribute : attributes) {
+        if (attribute.buffer == buffers[i]) { attribute.buffer = kUnknown; }
+      }
+    }
+  }
+  glDeleteBuffers(count, buffers);
+}
+
+void GLState::DeleteTextures(GLsizei count, const GLuint* textures) {
+  for (GLsizei i = 0; i < count; ++i) {
+    for (auto& unit : shadow.textures) { Forget(unit, textures[i]); }
+  }
+  glDeleteTextures(count, textures);
+}
+
+void GLState::Invalidate() { shadow = Shadow(); }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+
+// Shadow of the GL context's bindings and fixed-function state. Each setter
+// compares with the shadow and drops the call if it would change nothing, as
+// every GL call costs driver time whether or not it does anything. Issued and
+// dropped calls are counted in GLStats. Code that goes through here must not
+// change the same state with raw GL calls, or must call Invalidate after.
+//
+// There is one context, used by one thread at a time, so the shadow is global
+// and unsynchronized. Targets, units and capabilities the shadow doesn't
+// cover are passed through.
+class GLState {
+ public:
+  // Texture units shadowed, from GL_TEXTURE0
+  static constexpr int kTextureUnits = 16;
+  // Vertex attributes shadowed per vertex array, the minimum GL guarantees
+  static constexpr GLuint kVertexAttributes = 16;
+
+  static void UseProgram(GLuint program);
+  // Also forgets the element array buffer, which is vertex array state
+  static void BindVertexArray(GLuint vertexArray);
+  static void BindBuffer(GLenum target, GLuint buffer);
+  static void ActiveTexture(GLenum unit);
+  // Binds to the active unit
+  static void BindTexture(GLenum target, GLuint texture);
+  static void SetEnabled(GLenum capability, bool enabled);
+  static void BlendFunc(GLenum source, GLenum destination);
+  static void DepthFunc(GLenum function);
+  static void DepthMask(bool enabled);
+  static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  // Points an attribute of the bound vertex array at offset in the bound
+  // GL_ARRAY_BUFFER
+  static void VertexAttribPointer(
+    GLuint index,
+    GLint size,
+    GLenum type,
+    bool normalized,
+    GLsizei stride,
+    size_t offset
+  );
+  // Attribute state of the bound vertex array that is set once per vertex
+  // array, so not shadowed, only counted
+  static void SetVertexAttribArrayEnabled(GLuint index, bool enabled);
+  static void VertexAttribDivisor(GLuint index, GLuint divisor);
+
+  // Delete the objects and forget any bindings of them, as GL may hand their
+  // names out again
+  static void DeleteProgram(GLuint program);
+  static void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+  static void DeleteBuffers(GLsizei count, const GLuint* buffers);
+  static void DeleteTextures(GLsizei count, const GLuint* textures);
+
+  // Forgets the whole shadow, so the next call of each setter is issued. For
+  // after code that sets GL state itself, such as the ImGui backend.
+  static void Invalidate();
+};
@@ -0,0 +1,39 @@
+#include "GLStats.h"
+
+namespace {
+GLStats::Frame frame;
+}  // namespace
+
+void GLStats::BeginFrame() { frame = {}; }
+
+const GLStats::Frame& GLStats::GetFrame() { return frame; }
+
+void GLStats::RecordDraw(uint64_t triangles, uint64_t instances) {
+  ++frame.drawCalls;
+  frame.triangles += triangles * instances;
+  frame.instances += instances;
+}
+
+void GLStats::RecordStateChange(bool issued) {
+  if (issued) {
+    ++frame.stateChanges;
+  } else {
+    ++frame.stateChangesElided;
+  }
+}
+
+void GLStats::RecordUniformUpdate(bool issued) {
+  if (issued) {
+    ++frame.uniformUpdates;
+  } else {
+    ++frame.uniformUpdatesElided;
+  }
+}
+
+void GLStats::RecordBufferUpload(size_t bytes) {
+  frame.bufferBytesUploaded += bytes;
+}
+
+void GLStats::RecordTextureUpload(size_t bytes) {
+  frame.textureBytesUploaded += bytes;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts of the GL work issued in the current frame: draws, state changes,
+// uniform updates and bytes uploaded. Recorded next to the GL calls, so
+// only calls made through this code are counted, not the ImGui backend's.
+//
+// Like GLState, the counts are global and unsynchronized, as one thread at a
+// time uses the context.
+class GLStats {
+ public:
+  struct Frame {
+    uint64_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint64_t instances = 0;
+    // Binds, vertex attribute and fixed-function state changes issued, and
+    // dropped by GLState as redundant
+    uint64_t stateChanges = 0;
+    uint64_t stateChangesElided = 0;
+    uint64_t uniformUpdates = 0;
+    uint64_t uniformUpdatesElided = 0;
+    // Bytes of data handed to buffer and texture uploads. Allocations
+    // without data, such as orphaning, upload nothing.
+    uint64_t bufferBytesUploaded = 0;
+    uint64_t textureBytesUploaded = 0;
+  };
+
+  // Starts counting a new frame
+  static void BeginFrame();
+  // Counts of the frame so far
+  static const Frame& GetFrame();
+
+  static void RecordDraw(uint64_t triangles, uint64_t instances = 1);
+  static void RecordStateChange(bool issued);
+  static void RecordUniformUpdate(bool issued);
+  static void RecordBufferUpload(size_t bytes);
+  static void RecordTextureUpload(size_t bytes);
+};
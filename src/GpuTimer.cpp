@@ -0,0 +1,80 @@
+#include "GpuTimer.h"
+
+#include <SDL3/SDL_log.h>
+
+#include "Profiler.h"
+
+GpuTimer::GpuTimer() : frameIndex_(0), passStartNs_(0) {
+  for (FrameSlot& slot : slots_) {
+    glGenQueries(
+      static_cast<GLsizei>(slot.queries.size()), slot.queries.data()
+    );
+  }
+}
+
+GpuTimer::~GpuTimer() {
+  for (FrameSlot& slot : slots_) {
+    glDeleteQueries(
+      static_cast<GLsizei>(slot.queries.size()), slot.queries.data()
+    );
+  }
+}
+
+void GpuTimer::BeginFrame() {
+  ++frameIndex_;
+  FrameSlot& slot = slots_[frameIndex_ % kFramesInFlight];
+  if (slot.passCount > 0) { Resolve(slot); }
+  slot.passCount = 0;
+}
+
+void GpuTimer::BeginPass(const char* name) {
+  FrameSlot& slot = slots_[frameIndex_ % kFramesInFlight];
+  if (slot.passCount == kMaxPasses) {
+    SDL_Log("GpuTimer: Too many passes, ignoring %s", name);
+    return;
+  }
+  slot.names[slot.passCount] = name;
+  passStartNs_ = Profiler::Now();
+  glQueryCounter(slot.queries[slot.passCount * 2], GL_TIMESTAMP);
+}
+
+void GpuTimer::EndPass() {
+  // Ignored passes never started
+  if (passStartNs_ == 0) { return; }
+
+  FrameSlot& slot = slots_[frameIndex_ % kFramesInFlight];
+  glQueryCounter(slot.queries[slot.passCount * 2 + 1], GL_TIMESTAMP);
+  slot.cpuNs[slot.passCount] = Profiler::Now() - passStartNs_;
+  passStartNs_ = 0;
+  ++slot.passCount;
+}
+
+void GpuTimer::Resolve(FrameSlot& slot) {
+  // GL doesn't promise queries complete in order, and reading a result that
+  // isn't available blocks, so check every query before reading any
+  for (size_t i = 0; i < slot.passCount * 2; ++i) {
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+      ++results_.droppedFrames;
+      return;
+    }
+  }
+
+  results_.passTimes.clear();
+  GLuint64 frameStart = 0;
+  GLuint64 frameEnd = 0;
+  for (size_t pass = 0; pass < slot.passCount; ++pass) {
+    GLuint64 start;
+    GLuint64 end;
+    glGetQueryObjectui64v(slot.queries[pass * 2], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(slot.queries[pass * 2 + 1], GL_QUERY_RESULT, &end);
+    if (pass == 0) { frameStart = start; }
+    frameEnd = end;
+    results_.passTimes.push_back(
+      {slot.names[pass], slot.cpuNs[pass] / 1e6, (end - start) / 1e6}
+    );
+  }
+  results_.frameGpuMs = (frameEnd - frameStart) / 1e6;
+  ++results_.resolvedFrames;
+}
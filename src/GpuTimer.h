@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Measures how long the GPU spends on each render pass with GL_TIMESTAMP
+// queries. Queries are kept in a ring of kFramesInFlight frames and read back
+// when their slot comes around again, by which point the GPU has normally
+// finished them, so reading never stalls the CPU. Frames whose queries are
+// still not available are dropped rather than waited on.
+//
+// Passes must not nest or overlap.
+class GpuTimer {
+ public:
+  // Frames between issuing a query and reading it back
+  static constexpr size_t kFramesInFlight = 4;
+  static constexpr size_t kMaxPasses = 8;
+
+  struct PassTime {
+    // String literal passed to BeginPass
+    const char* name;
+    double cpuMs;
+    double gpuMs;
+  };
+
+  // Results of the most recently resolved frame, kFramesInFlight frames
+  // behind the current one
+  struct Results {
+    // CPU times are from the same frame
+    std::vector<PassTime> passTimes;
+    // GPU time from the start of the first pass to the end of the last one
+    double frameGpuMs = 0.0;
+    // Frames whose results were not ready when their slot was reused
+    uint64_t droppedFrames = 0;
+    // Frames resolved so far. Changes whenever passTimes has new results.
+    uint64_t resolvedFrames = 0;
+  };
+
+  GpuTimer();
+  ~GpuTimer();
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  // Starts a new frame, resolving the oldest frame in the ring if its results
+  // are available
+  void BeginFrame();
+  void BeginPass(const char* name);
+  void EndPass();
+
+  // Copyable, so the results can be handed to another thread
+  const Results& GetResults() const { return results_; }
+
+ private:
+  struct FrameSlot {
+    // Begin and end timestamp query of each pass
+    std::array<GLuint, kMaxPasses * 2> queries;
+    std::array<const char*, kMaxPasses> names;
+    std::array<uint64_t, kMaxPasses> cpuNs;
+    size_t passCount = 0;
+  };
+
+  void Resolve(FrameSlot& slot);
+
+  std::array<FrameSlot, kFramesInFlight> slots_;
+  uint64_t frameIndex_;
+  // CPU start of the open pass, 0 if none is open
+  uint64_t passStartNs_;
+  Results results_;
+};
+
+// Times the enclosing scope as a GPU pass
+class GpuTimerScope {
+ public:
+  GpuTimerScope(GpuTimer& timer, const char* name) : timer_(timer) {
+    timer_.BeginPass(name);
+  }
+  ~GpuTimerScope() { timer_.EndPass(); }
+
+  GpuTimerScope(const GpuTimerScope&) = delete;
+  GpuTimerScope& operator=(const GpuTimerScope&) = delete;
+
+ private:
+  GpuTimer& timer_;
+};
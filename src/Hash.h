@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// 32-bit and 64-bit FNV-1a hashes. Pass a previous result as the seed to hash
+// several pieces of data as one stream.
+constexpr uint32_t kFnv1a32Seed = 2166136261u;
+constexpr uint64_t kFnv1a64Seed = 14695981039346656037ull;
+
+constexpr uint32_t HashFnv1a32(
+  std::string_view data, uint32_t seed = kFnv1a32Seed
+) {
+  uint32_t hash = seed;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+constexpr uint64_t HashFnv1a64(
+  std::string_view data, uint64_t seed = kFnv1a64Seed
+) {
+  uint64_t hash = seed;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
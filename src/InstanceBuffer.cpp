@@ -0,0 +1,85 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+
+#include "GLState.h"
+#include "GLStats.h"
+
+namespace {
+// Grow geometrically so a slowly growing scene doesn't reallocate every frame
+constexpr size_t kMinimumCapacity = 256;
+}  // namespace
+
+InstanceBuffer::InstanceBuffer() : vbo_(0), capacity_(0), instanceCount_(0) {
+  glGenBuffers(1, &vbo_);
+}
+
+InstanceBuffer::~InstanceBuffer() { GLState::DeleteBuffers(1, &vbo_); }
+
+void InstanceBuffer::AttachToVertexArray(GLuint vao) const {
+  GLState::BindVertexArray(vao);
+  // A mat4 attribute is four vec4 columns in consecutive locations
+  for (GLuint column = 0; column < 4; ++column) {
+    GLState::SetVertexAttribArrayEnabled(kModelMatrixLocation + column, true);
+    GLState::VertexAttribDivisor(kModelMatrixLocation + column, 1);
+  }
+  GLState::SetVertexAttribArrayEnabled(kTextureLayerLocation, true);
+  GLState::VertexAttribDivisor(kTextureLayerLocation, 1);
+  SetFirstInstance(vao, 0);
+}
+
+void InstanceBuffer::SetFirstInstance(GLuint vao, size_t firstInstance) const {
+  GLState::BindVertexArray(vao);
+  GLState::BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  const size_t offset = firstInstance * sizeof(glm::mat4);
+  for (GLuint column = 0; column < 4; ++column) {
+    GLState::VertexAttribPointer(
+      kModelMatrixLocation + column,
+      4,
+      GL_FLOAT,
+      false,
+      sizeof(glm::mat4),
+      offset + column * sizeof(glm::vec4)
+    );
+  }
+  // Converted to float, which holds any layer index exactly. Four bytes each,
+  // as some drivers are slow with attributes that are not 4-byte aligned.
+  GLState::VertexAttribPointer(
+    kTextureLayerLocation,
+    1,
+    GL_UNSIGNED_INT,
+    false,
+    sizeof(uint32_t),
+    capacity_ * sizeof(glm::mat4) + firstInstance * sizeof(uint32_t)
+  );
+}
+
+void InstanceBuffer::Upload(
+  std::span<const glm::mat4> modelMatrices,
+  std::span<const uint32_t> textureLayers
+) {
+  instanceCount_ = modelMatrices.size();
+  GLState::BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  if (instanceCount_ > capacity_) {
+    capacity_ = std::max({kMinimumCapacity, capacity_ * 2, instanceCount_});
+  }
+  // Orphan the old storage, then fill the fresh one
+  glBufferData(
+    GL_ARRAY_BUFFER,
+    capacity_ * (sizeof(glm::mat4) + sizeof(uint32_t)),
+    nullptr,
+    GL_STREAM_DRAW
+  );
+  glBufferSubData(
+    GL_ARRAY_BUFFER, 0, modelMatrices.size_bytes(), modelMatrices.data()
+  );
+  glBufferSubData(
+    GL_ARRAY_BUFFER,
+    capacity_ * sizeof(glm::mat4),
+    textureLayers.size_bytes(),
+    textureLayers.data()
+  );
+  GLStats::RecordBufferUpload(
+    modelMatrices.size_bytes() + textureLayers.size_bytes()
+  );
+}
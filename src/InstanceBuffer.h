@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Per-instance vertex data, streamed to the GPU every frame and read by the
+// vertex shader through attributes with a divisor of 1.
+class InstanceBuffer {
+ public:
+  // The model matrix occupies four consecutive vec4 attribute locations
+  static constexpr GLuint kModelMatrixLocation = 2;
+  // Layer of the texture array to sample, as a float
+  static constexpr GLuint kTextureLayerLocation = 6;
+
+  InstanceBuffer();
+  ~InstanceBuffer();
+  InstanceBuffer(const InstanceBuffer&) = delete;
+  InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+  // Enables the instance attributes of a vertex array object and points them
+  // at this buffer. Once per vertex array. Leaves vao bound.
+  void AttachToVertexArray(GLuint vao) const;
+  // Points the instance attributes of an attached vertex array object at
+  // firstInstance, which is how several draws share one upload without GL
+  // 4.2's base instance. The texture layers are placed by capacity, so call
+  // again after an Upload. Offsets that don't change are dropped by GLState.
+  // Leaves vao bound.
+  void SetFirstInstance(GLuint vao, size_t firstInstance) const;
+
+  // Replaces the buffer contents, one texture layer per model matrix. The
+  // previous storage is orphaned instead of overwritten so the CPU never waits
+  // on draws still reading it.
+  void Upload(
+    std::span<const glm::mat4> modelMatrices,
+    std::span<const uint32_t> textureLayers
+  );
+
+  size_t GetInstanceCount() const { return instanceCount_; }
+
+ private:
+  // The model matrices, followed by the texture layers
+  GLuint vbo_;
+  // Capacity of vbo_ in instances
+  size_t capacity_;
+  size_t instanceCount_;
+};
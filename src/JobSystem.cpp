@@ -0,0 +1,327 @@
+#include "JobSystem.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <string>
+
+#include "Profiler.h"
+
+struct JobCounter::Job {
+  std::function<void()> task;
+  JobCounter* counter;
+};
+
+namespace {
+constexpr int64_t kInitialDequeCapacity = 256;
+// Rounds of looking for work before an idle worker sleeps. Frames submit
+// bursts of jobs, and waking a sleeping thread costs more than a short spin.
+constexpr int kSpinRounds = 64;
+
+// Which system's deque the current thread owns, if any
+thread_local const JobSystem* tSystem = nullptr;
+thread_local int tThreadIndex = -1;
+
+// Pins the calling thread to one core, wrapping around the cores there are
+bool PinThread(unsigned core) {
+  core %= std::max(std::thread::hardware_concurrency(), 1u);
+#if defined(_WIN32)
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << core) != 0;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)core;
+  return false;
+#endif
+}
+}  // namespace
+
+JobSystem::Deque::Buffer::Buffer(int64_t capacity)
+    : capacity(capacity),
+      slots(std::make_unique<std::atomic<Job*>[]>(capacity)) {}
+
+JobSystem::Deque::Deque() {
+  buffers_.push_back(std::make_unique<Buffer>(kInitialDequeCapacity));
+  buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+void JobSystem::Deque::Push(Job* job) {
+  const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+  const int64_t top = top_.load(std::memory_order_acquire);
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  if (bottom - top > buffer->capacity - 1) {
+    auto grown = std::make_unique<Buffer>(buffer->capacity * 2);
+    for (int64_t i = top; i < bottom; ++i) { grown->Put(i, buffer->Get(i)); }
+    buffer = grown.get();
+    buffers_.push_back(std::move(grown));
+    buffer_.store(buffer, std::memory_order_release);
+  }
+  buffer->Put(bottom, job);
+  bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+JobSystem::Job* JobSystem::Deque::Pop() {
+  const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t top = top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    // Empty
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  Job* job = buffer->Get(bottom);
+  if (top == bottom) {
+    // The last job, which a thief may be taking at the same time
+    if (!top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+        )) {
+      job = nullptr;
+    }
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+JobSystem::Job* JobSystem::Deque::Steal() {
+  int64_t top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const int64_t bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) { return nullptr; }
+  Job* job = buffer_.load(std::memory_order_acquire)->Get(top);
+  if (!top_.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+      )) {
+    // Lost the race to another thief or the owner
+    return nullptr;
+  }
+  return job;
+}
+
+JobSystem::JobSystem(const JobSystemSettings& settings) {
+  unsigned workerCount = settings.workerCount;
+  if (workerCount == 0) {
+    workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  }
+  tSystem = this;
+  tThreadIndex = 0;
+  if (settings.pinThreads && !PinThread(settings.firstCore)) {
+    SDL_Log("JobSystem: Pinning threads isn't supported here");
+  }
+  for (unsigned i = 0; i <= workerCount; ++i) {
+    deques_.push_back(std::make_unique<Deque>());
+  }
+  threads_.reserve(workerCount);
+  for (unsigned i = 0; i < workerCount; ++i) {
+    threads_.emplace_back([this, i, settings] {
+      if (settings.pinThreads) { PinThread(settings.firstCore + i + 1); }
+      WorkerMain(i);
+    });
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard lock(sleepMutex_);
+    stopping_ = true;
+  }
+  jobQueued_.notify_all();
+  for (std::thread& thread : threads_) { thread.join(); }
+  if (tSystem == this) {
+    tSystem = nullptr;
+    tThreadIndex = -1;
+  }
+
+  // Drop the jobs that never ran
+  for (const std::unique_ptr<Deque>& deque : deques_) {
+    while (Job* job = deque->Pop()) { delete job; }
+  }
+  for (Job* job : externalJobs_) { delete job; }
+  for (Job* job : backgroundJobs_) { delete job; }
+}
+
+void JobSystem::Submit(std::function<void()> job, JobCounter* counter) {
+  if (counter != nullptr) {
+    counter->pending_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Push(new Job{std::move(job), counter});
+}
+
+void JobSystem::SubmitAfter(
+  JobCounter& dependency, std::function<void()> job, JobCounter* counter
+) {
+  if (counter != nullptr) {
+    counter->pending_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Job* pending = new Job{std::move(job), counter};
+  {
+    // Finish takes the dependents under the same lock once the count is zero,
+    // so a job added while it is not is always released
+    std::lock_guard lock(dependency.mutex_);
+    if (dependency.pending_.load(std::memory_order_acquire) != 0) {
+      dependency.dependents_.push_back(pending);
+      return;
+    }
+  }
+  Push(pending);
+}
+
+void JobSystem::SubmitBackground(std::function<void()> job) {
+  {
+    std::lock_guard lock(queueMutex_);
+    backgroundJobs_.push_back(new Job{std::move(job), nullptr});
+  }
+  // Sequentially consistent, see Wake
+  queuedJobs_.fetch_add(1);
+  Wake();
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+  const int threadIndex = GetThreadIndex();
+  while (!counter.IsDone()) {
+    if (Job* job = FindJob(threadIndex, false)) {
+      Run(job);
+    } else {
+      // The remaining jobs are running on other threads
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::ParallelFor(
+  size_t count,
+  size_t minRangeSize,
+  const std::function<void(size_t, size_t)>& body
+) {
+  if (count == 0) { return; }
+  minRangeSize = std::max<size_t>(minRangeSize, 1);
+  const size_t rangeCount = std::min(
+    (count + minRangeSize - 1) / minRangeSize, GetThreadCount() * 4
+  );
+  if (rangeCount <= 1) {
+    body(0, count);
+    return;
+  }
+  JobCounter done;
+  for (size_t range = 1; range < rangeCount; ++range) {
+    const size_t begin = count * range / rangeCount;
+    const size_t end = count * (range + 1) / rangeCount;
+    Submit([&body, begin, end] { body(begin, end); }, &done);
+  }
+  body(0, count / rangeCount);
+  Wait(done);
+}
+
+int JobSystem::GetThreadIndex() const {
+  return tSystem == this ? tThreadIndex : -1;
+}
+
+void JobSystem::Push(Job* job) {
+  const int threadIndex = GetThreadIndex();
+  if (threadIndex >= 0) {
+    deques_[threadIndex]->Push(job);
+  } else {
+    std::lock_guard lock(queueMutex_);
+    externalJobs_.push_back(job);
+  }
+  // Sequentially consistent, see Wake
+  queuedJobs_.fetch_add(1);
+  Wake();
+}
+
+JobSystem::Job* JobSystem::FindJob(int threadIndex, bool allowBackground) {
+  Job* job = nullptr;
+  if (threadIndex >= 0) { job = deques_[threadIndex]->Pop(); }
+  // Steal starting after our own deque, so thieves spread over the victims
+  const size_t dequeCount = deques_.size();
+  const size_t start = static_cast<size_t>(threadIndex + 1);
+  for (size_t i = 0; job == nullptr && i < dequeCount; ++i) {
+    const size_t victim = (start + i) % dequeCount;
+    if (static_cast<int>(victim) != threadIndex) {
+      job = deques_[victim]->Steal();
+    }
+  }
+  if (job == nullptr) {
+    std::lock_guard lock(queueMutex_);
+    if (!externalJobs_.empty()) {
+      job = externalJobs_.front();
+      externalJobs_.pop_front();
+    } else if (allowBackground && !backgroundJobs_.empty()) {
+      job = backgroundJobs_.front();
+      backgroundJobs_.pop_front();
+    }
+  }
+  if (job != nullptr) { queuedJobs_.fetch_sub(1, std::memory_order_relaxed); }
+  return job;
+}
+
+void JobSystem::Run(Job* job) {
+  job->task();
+  Finish(job->counter);
+  delete job;
+}
+
+void JobSystem::Finish(JobCounter* counter) {
+  if (counter == nullptr) { return; }
+  counter->finishing_.fetch_add(1, std::memory_order_relaxed);
+  std::vector<Job*> ready;
+  if (counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard lock(counter->mutex_);
+    ready.swap(counter->dependents_);
+  }
+  // The counter may be destroyed by its waiter from here on
+  counter->finishing_.fetch_sub(1, std::memory_order_release);
+  for (Job* job : ready) { Push(job); }
+}
+
+void JobSystem::Wake() {
+  // A worker counts itself sleeping before checking for jobs, and jobs are
+  // counted before this checks for sleepers. Both sequentially consistent, so
+  // either this sees the sleeper or the sleeper sees the job, and pushes
+  // don't serialize on the mutex while every worker is busy.
+  if (sleepingWorkers_.load() == 0) { return; }
+  // Taking the lock orders this with a worker checking for jobs before it
+  // sleeps, so the notification can't slip in between
+  { std::lock_guard lock(sleepMutex_); }
+  jobQueued_.notify_one();
+}
+
+void JobSystem::WorkerMain(unsigned index) {
+  Profiler::SetThreadName(("Worker " + std::to_string(index + 1)).c_str());
+  tSystem = this;
+  tThreadIndex = static_cast<int>(index + 1);
+
+  int idleRounds = 0;
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    if (Job* job = FindJob(tThreadIndex, true)) {
+      Run(job);
+      idleRounds = 0;
+      continue;
+    }
+    if (++idleRounds < kSpinRounds) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::unique_lock lock(sleepMutex_);
+    sleepingWorkers_.fetch_add(1);
+    jobQueued_.wait(lock, [this] {
+      return stopping_.load(std::memory_order_relaxed) ||
+             queuedJobs_.load() > 0;
+    });
+    sleepingWorkers_.fetch_sub(1, std::memory_order_relaxed);
+    idleRounds = 0;
+  }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Counts unfinished jobs, for waiting on them or for running jobs after them.
+// Submitting with a counter increments it, and it is decremented when the job
+// finishes. Must outlive the jobs that count against it.
+class JobCounter {
+ public:
+  JobCounter() = default;
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  bool IsDone() const {
+    return pending_.load(std::memory_order_acquire) == 0 &&
+           finishing_.load(std::memory_order_acquire) == 0;
+  }
+
+ private:
+  friend class JobSystem;
+  struct Job;
+
+  std::atomic<uint32_t> pending_ = 0;
+  // Jobs still releasing dependents after counting themselves finished, so
+  // a waiter doesn't destroy the counter under them
+  std::atomic<uint32_t> finishing_ = 0;
+  // Jobs submitted to run after this counter reaches zero
+  std::mutex mutex_;
+  std::vector<Job*> dependents_;
+};
+
+struct JobSystemSettings {
+  // 0 picks one less than the hardware concurrency, leaving a core for the
+  // creating thread, but at least one
+  unsigned workerCount = 0;
+  // Pins the creating thread to firstCore and each worker to the next cores,
+  // wrapping around, where the platform allows it (Linux and Windows)
+  bool pinThreads = false;
+  unsigned firstCore = 0;
+};
+
+// Work-stealing job scheduler. Each worker, and the thread that created the
+// system, owns a Chase-Lev deque: it pushes and pops jobs at the bottom
+// without locks, and idle threads steal from the top of the others. Waiting
+// on a counter runs other jobs meanwhile, so jobs can fork and join jobs of
+// their own, as recursive builds do.
+//
+// Long jobs nobody waits on (e.g. decoding files) go to a background queue
+// that only idle workers take from, so a frame waiting on its own jobs never
+// picks one up and stalls behind it.
+class JobSystem {
+ public:
+  explicit JobSystem(const JobSystemSettings& settings = {});
+  // Waits for running jobs to finish. Jobs that have not started are dropped.
+  ~JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // Queues job, on the calling thread's deque if it is one of this system's
+  void Submit(std::function<void()> job, JobCounter* counter = nullptr);
+  // Queues job once dependency reaches zero, right away if it already has
+  void SubmitAfter(
+    JobCounter& dependency,
+    std::function<void()> job,
+    JobCounter* counter = nullptr
+  );
+  // Queues a long job for an idle worker
+  void SubmitBackground(std::function<void()> job);
+  // Runs other jobs until counter reaches zero
+  void Wait(JobCounter& counter);
+
+  // Calls body(begin, end) for ranges covering [0, count), each of at least
+  // minRangeSize unless count is smaller, and returns when all are done. The
+  // calling thread runs one range itself. Ranges are a few per thread, so a
+  // slow range doesn't hold up the rest.
+  void ParallelFor(
+    size_t count,
+    size_t minRangeSize,
+    const std::function<void(size_t, size_t)>& body
+  );
+
+  // Workers plus the creating thread
+  size_t GetThreadCount() const { return threads_.size() + 1; }
+  // Index of the calling thread in [0, GetThreadCount()): 0 for the creating
+  // thread, then the workers. -1 if it isn't one of this system's threads.
+  int GetThreadIndex() const;
+
+ private:
+  using Job = JobCounter::Job;
+
+  // Chase-Lev deque of jobs, as corrected for weak memory models by Lê et
+  // al. (PPoPP 2013). Grows when full; replaced buffers are kept until
+  // destruction, as a thief may still be reading one.
+  class Deque {
+   public:
+    Deque();
+    // Owner only
+    void Push(Job* job);
+    Job* Pop();
+    // Any thread
+    Job* Steal();
+
+   private:
+    struct Buffer {
+      explicit Buffer(int64_t capacity);
+      Job* Get(int64_t index) const {
+        return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+      }
+      void Put(int64_t index, Job* job) {
+        slots[index & (capacity - 1)].store(job, std::memory_order_relaxed);
+      }
+
+      int64_t capacity;
+      std::unique_ptr<std::atomic<Job*>[]> slots;
+    };
+
+    alignas(64) std::atomic<int64_t> top_ = 0;
+    alignas(64) std::atomic<int64_t> bottom_ = 0;
+    std::atomic<Buffer*> buffer_;
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+  };
+
+  void WorkerMain(unsigned index);
+  void Push(Job* job);
+  // Takes a job from the thread's own deque, then steals from the others and
+  // takes queued jobs from other threads, then background ones if allowed
+  Job* FindJob(int threadIndex, bool allowBackground);
+  void Run(Job* job);
+  // Counts a job as finished and queues the jobs waiting on counter if that
+  // was its last one
+  void Finish(JobCounter* counter);
+  void Wake();
+
+  // Indexed by thread index: 0 is the creating thread, workers follow
+  std::vector<std::unique_ptr<Deque>> deques_;
+  std::vector<std::thread> threads_;
+
+  // Jobs submitted from other threads, and background jobs
+  std::mutex queueMutex_;
+  std::deque<Job*> externalJobs_;
+  std::deque<Job*> backgroundJobs_;
+
+  // Jobs queued anywhere and not taken yet, which idle workers sleep on
+  std::atomic<int64_t> queuedJobs_ = 0;
+  // Workers waiting on jobQueued_, so Wake only locks when there are any
+  std::atomic<int> sleepingWorkers_ = 0;
+  std::mutex sleepMutex_;
+  std::condition_variable jobQueued_;
+  std::atomic<bool> stopping_ = false;
+};
@@ -0,0 +1,292 @@
+#include "JsonReader.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+
+namespace {
+// Nesting deeper than this is rejected instead of overflowing the stack
+constexpr int kMaxDepth = 256;
+
+void AppendUtf8(std::string& out, uint32_t codePoint) {
+  if (codePoint < 0x80) {
+    out += static_cast<char>(codePoint);
+  } else if (codePoint < 0x800) {
+    out += static_cast<char>(0xc0 | (codePoint >> 6));
+    out += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else if (codePoint < 0x10000) {
+    out += static_cast<char>(0xe0 | (codePoint >> 12));
+    out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else {
+    out += static_cast<char>(0xf0 | (codePoint >> 18));
+    out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+}
+}  // namespace
+
+// Recursive descent parser. Not in the anonymous namespace because JsonValue
+// befriends it.
+class JsonParser {
+ public:
+  explicit JsonParser(std::string_view text) : text_(text) {}
+
+  bool ParseDocument(JsonValue& out) {
+    if (!ParseValue(out, 0)) { return false; }
+    SkipWhitespace();
+    if (position_ != text_.size()) { return Fail("Trailing characters"); }
+    return true;
+  }
+
+  const std::string& GetError() const { return error_; }
+
+ private:
+  bool Fail(std::string_view message) {
+    if (error_.empty()) {
+      error_ = std::format("{} at offset {}", message, position_);
+    }
+    return false;
+  }
+
+  void SkipWhitespace() {
+    while (position_ < text_.size() &&
+           (text_[position_] == ' ' || text_[position_] == '\t' ||
+            text_[position_] == '\n' || text_[position_] == '\r')) {
+      ++position_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (position_ < text_.size() && text_[position_] == c) {
+      ++position_;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeLiteral(std::string_view literal) {
+    if (text_.substr(position_, literal.size()) != literal) { return false; }
+    position_ += literal.size();
+    return true;
+  }
+
+  bool ParseValue(JsonValue& out, int depth) {
+    if (depth > kMaxDepth) { return Fail("Nesting too deep"); }
+    SkipWhitespace();
+    if (position_ >= text_.size()) { return Fail("Unexpected end"); }
+
+    const char c = text_[position_];
+    if (c == '{') { return ParseObject(out, depth); }
+    if (c == '[') { return ParseArray(out, depth); }
+    if (c == '"') {
+      out.type_ = JsonValue::Type::kString;
+      return ParseString(out.string_);
+    }
+    if (ConsumeLiteral("true")) {
+      out.type_ = JsonValue::Type::kBool;
+      out.bool_ = true;
+      return true;
+    }
+    if (ConsumeLiteral("false")) {
+      out.type_ = JsonValue::Type::kBool;
+      out.bool_ = false;
+      return true;
+    }
+    if (ConsumeLiteral("null")) {
+      out.type_ = JsonValue::Type::kNull;
+      return true;
+    }
+    return ParseNumber(out);
+  }
+
+  bool ParseObject(JsonValue& out, int depth) {
+    out.type_ = JsonValue::Type::kObject;
+    ++position_;
+    if (Consume('}')) { return true; }
+    do {
+      SkipWhitespace();
+      if (position_ >= text_.size() || text_[position_] != '"') {
+        return Fail("Expected a key");
+      }
+      std::string key;
+      if (!ParseString(key)) { return false; }
+      if (!Consume(':')) { return Fail("Expected ':'"); }
+      JsonValue value;
+      if (!ParseValue(value, depth + 1)) { return false; }
+      out.keys_.push_back(std::move(key));
+      out.values_.push_back(std::move(value));
+    } while (Consume(','));
+    if (!Consume('}')) { return Fail("Expected ',' or '}'"); }
+    return true;
+  }
+
+  bool ParseArray(JsonValue& out, int depth) {
+    out.type_ = JsonValue::Type::kArray;
+    ++position_;
+    if (Consume(']')) { return true; }
+    do {
+      JsonValue value;
+      if (!ParseValue(value, depth + 1)) { return false; }
+      out.values_.push_back(std::move(value));
+    } while (Consume(','));
+    if (!Consume(']')) { return Fail("Expected ',' or ']'"); }
+    return true;
+  }
+
+  bool ParseHex4(uint32_t& out) {
+    if (position_ + 4 > text_.size()) { return Fail("Truncated escape"); }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = text_[position_++];
+      out <<= 4;
+      if (c >= '0' && c <= '9') {
+        out |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        out |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        out |= c - 'A' + 10;
+      } else {
+        return Fail("Invalid \\u escape");
+      }
+    }
+    return true;
+  }
+
+  bool ParseString(std::string& out) {
+    // Opening quote
+    ++position_;
+    while (position_ < text_.size()) {
+      const char c = text_[position_++];
+      if (c == '"') { return true; }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Fail("Control character in string");
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (position_ >= text_.size()) { break; }
+      const char escaped = text_[position_++];
+      switch (escaped) {
+        case '"':
+        case '\\':
+        case '/':
+          out += escaped;
+          break;
+        case 'b':
+          out += '\b';
+          break;
+        case 'f':
+          out += '\f';
+          break;
+        case 'n':
+          out += '\n';
+          break;
+        case 'r':
+          out += '\r';
+          break;
+        case 't':
+          out += '\t';
+          break;
+        case 'u': {
+          uint32_t codePoint;
+          if (!ParseHex4(codePoint)) { return false; }
+          // Combine a surrogate pair
+          if (codePoint >= 0xd800 && codePoint < 0xdc00 &&
+              ConsumeLiteral("\\u")) {
+            uint32_t low;
+            if (!ParseHex4(low)) { return false; }
+            if (low < 0xdc00 || low >= 0xe000) {
+              return Fail("Invalid surrogate pair");
+            }
+            codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+          }
+          AppendUtf8(out, codePoint);
+          break;
+        }
+        default:
+          return Fail("Invalid escape");
+      }
+    }
+    return Fail("Unterminated string");
+  }
+
+  bool ParseNumber(JsonValue& out) {
+    const size_t start = position_;
+    while (position_ < text_.size()) {
+      const char c = text_[position_];
+      if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' &&
+          c != 'e' && c != 'E') {
+        break;
+      }
+      ++position_;
+    }
+    if (position_ == start) { return Fail("Unexpected character"); }
+
+    // strtod needs a terminated string
+    const std::string token(text_.substr(start, position_ - start));
+    char* end = nullptr;
+    out.type_ = JsonValue::Type::kNumber;
+    out.number_ = std::strtod(token.c_str(), &end);
+    if (end != token.c_str() + token.size()) {
+      position_ = start;
+      return Fail("Invalid number");
+    }
+    return true;
+  }
+
+  std::string_view text_;
+  size_t position_ = 0;
+  std::string error_;
+};
+
+std::optional<JsonValue> JsonValue::Parse(
+  std::string_view text, std::string& error
+) {
+  JsonParser parser(text);
+  JsonValue value;
+  if (!parser.ParseDocument(value)) {
+    error = parser.GetError();
+    return std::nullopt;
+  }
+  return value;
+}
+
+bool JsonValue::AsBool(bool fallback) const {
+  return type_ == Type::kBool ? bool_ : fallback;
+}
+
+double JsonValue::AsNumber(double fallback) const {
+  return type_ == Type::kNumber ? number_ : fallback;
+}
+
+const std::string& JsonValue::AsString() const {
+  static const std::string empty;
+  return type_ == Type::kString ? string_ : empty;
+}
+
+const std::vector<JsonValue>& JsonValue::GetElements() const {
+  static const std::vector<JsonValue> empty;
+  return type_ == Type::kArray ? values_ : empty;
+}
+
+const std::vector<std::string>& JsonValue::GetKeys() const {
+  static const std::vector<std::string> empty;
+  return type_ == Type::kObject ? keys_ : empty;
+}
+
+const std::vector<JsonValue>& JsonValue::GetValues() const {
+  static const std::vector<JsonValue> empty;
+  return type_ == Type::kObject ? values_ : empty;
+}
+
+const JsonValue* JsonValue::Find(std::string_view key) const {
+  if (type_ != Type::kObject) { return nullptr; }
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    if (keys_[i] == key) { return &values_[i]; }
+  }
+  return nullptr;
+}
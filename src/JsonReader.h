@@ -0,0 +1,49 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A parsed JSON value, for reading reports back (e.g. to compare benchmark
+// runs). Numbers are doubles, and object members keep their file order.
+class JsonValue {
+ public:
+  enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  // Parses a complete document. On failure returns std::nullopt and describes
+  // the problem and its byte offset in error.
+  static std::optional<JsonValue> Parse(
+    std::string_view text, std::string& error
+  );
+
+  Type GetType() const { return type_; }
+  bool IsNumber() const { return type_ == Type::kNumber; }
+  bool IsString() const { return type_ == Type::kString; }
+  bool IsArray() const { return type_ == Type::kArray; }
+  bool IsObject() const { return type_ == Type::kObject; }
+
+  // Accessors return the fallback or an empty value on a type mismatch, so
+  // optional fields can be read without checking every level
+  bool AsBool(bool fallback = false) const;
+  double AsNumber(double fallback = 0.0) const;
+  const std::string& AsString() const;
+  // Elements of an array
+  const std::vector<JsonValue>& GetElements() const;
+  // Keys and values of an object's members, in the same order
+  const std::vector<std::string>& GetKeys() const;
+  const std::vector<JsonValue>& GetValues() const;
+  // Object member by key, or nullptr if missing or this is not an object
+  const JsonValue* Find(std::string_view key) const;
+
+ private:
+  friend class JsonParser;
+
+  Type type_ = Type::kNull;
+  bool bool_ = false;
+  double number_ = 0.0;
+  std::string string_;
+  // Array elements, or object member values
+  std::vector<JsonValue> values_;
+  std::vector<std::string> keys_;
+};
@@ -0,0 +1,117 @@
+#include "JsonWriter.h"
+
+#include <cmath>
+#include <cstdio>
+
+void JsonWriter::BeginObject() {
+  BeginElement();
+  out_ << '{';
+  hasElements_.push_back(false);
+}
+
+void JsonWriter::EndObject() {
+  const bool hadElements = hasElements_.back();
+  hasElements_.pop_back();
+  if (hadElements) { WriteNewlineAndIndent(); }
+  out_ << '}';
+  if (hasElements_.empty()) { out_ << '\n'; }
+}
+
+void JsonWriter::BeginArray() {
+  BeginElement();
+  out_ << '[';
+  hasElements_.push_back(false);
+}
+
+void JsonWriter::EndArray() {
+  const bool hadElements = hasElements_.back();
+  hasElements_.pop_back();
+  if (hadElements) { WriteNewlineAndIndent(); }
+  out_ << ']';
+  if (hasElements_.empty()) { out_ << '\n'; }
+}
+
+void JsonWriter::Key(std::string_view key) {
+  BeginElement();
+  WriteString(key);
+  out_ << ": ";
+  afterKey_ = true;
+}
+
+void JsonWriter::Value(std::string_view value) {
+  BeginElement();
+  WriteString(value);
+}
+
+void JsonWriter::BeginElement() {
+  if (afterKey_) {
+    afterKey_ = false;
+    return;
+  }
+  if (hasElements_.empty()) { return; }
+  if (hasElements_.back()) { out_ << ','; }
+  hasElements_.back() = true;
+  WriteNewlineAndIndent();
+}
+
+void JsonWriter::WriteRaw(std::string_view text) {
+  BeginElement();
+  out_ << text;
+}
+
+void JsonWriter::WriteInteger(int64_t value) {
+  BeginElement();
+  out_ << value;
+}
+
+void JsonWriter::WriteUnsigned(uint64_t value) {
+  BeginElement();
+  out_ << value;
+}
+
+void JsonWriter::WriteDouble(double value) {
+  BeginElement();
+  if (!std::isfinite(value)) {
+    out_ << "null";
+    return;
+  }
+  // Enough digits for timings without printing float noise
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+  out_ << buffer;
+}
+
+void JsonWriter::WriteString(std::string_view value) {
+  out_ << '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        out_ << "\\\"";
+        break;
+      case '\\':
+        out_ << "\\\\";
+        break;
+      case '\n':
+        out_ << "\\n";
+        break;
+      case '\t':
+        out_ << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out_ << escaped;
+        } else {
+          out_ << c;
+        }
+        break;
+    }
+  }
+  out_ << '"';
+}
+
+void JsonWriter::WriteNewlineAndIndent() {
+  out_ << '\n';
+  for (size_t i = 0; i < hasElements_.size(); ++i) { out_ << "  "; }
+}
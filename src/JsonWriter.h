@@ -0,0 +1,62 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Streaming JSON writer with two-space indentation, for reports. Does not
+// validate structure beyond what it needs for commas and indentation: keys
+// must only be written inside objects and values inside arrays or after a key.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::ostream& out) : out_(out) {}
+
+  void BeginObject();
+  void EndObject();
+  void BeginArray();
+  void EndArray();
+
+  void Key(std::string_view key);
+
+  void Value(std::string_view value);
+  template <std::integral T>
+  void Value(T value) {
+    if constexpr (std::same_as<T, bool>) {
+      WriteRaw(value ? "true" : "false");
+    } else if constexpr (std::signed_integral<T>) {
+      WriteInteger(static_cast<int64_t>(value));
+    } else {
+      WriteUnsigned(static_cast<uint64_t>(value));
+    }
+  }
+  template <std::floating_point T>
+  void Value(T value) {
+    WriteDouble(static_cast<double>(value));
+  }
+
+  // Key followed by a value
+  template <typename T>
+  void Field(std::string_view key, const T& value) {
+    Key(key);
+    Value(value);
+  }
+
+ private:
+  // Writes the separator and indentation that go before a value or key
+  void BeginElement();
+  void WriteRaw(std::string_view text);
+  void WriteInteger(int64_t value);
+  void WriteUnsigned(uint64_t value);
+  // Non-finite values are written as null
+  void WriteDouble(double value);
+  void WriteString(std::string_view value);
+  void WriteNewlineAndIndent();
+
+  std::ostream& out_;
+  // Whether each open object or array has elements yet
+  std::vector<bool> hasElements_;
+  // Set between Key and its value, which goes on the same line
+  bool afterKey_ = false;
+};
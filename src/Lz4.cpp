@@ -0,0 +1,150 @@
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr size_t kMinMatch = 4;
+// The format requires the last 5 bytes to be literals and the last match to
+// start at least 12 bytes before the end
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMatchStartMargin = 12;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 16;
+
+uint32_t Read32(const uint8_t* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t HashSequence(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+// Lengths that don't fit a token nibble continue in bytes of up to 255
+void WriteLength(std::vector<uint8_t>& out, size_t length) {
+  for (; length >= 255; length -= 255) { out.push_back(255); }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+void WriteLiterals(
+  std::vector<uint8_t>& out, std::span<const uint8_t> literals
+) {
+  if (literals.size() >= 15) { WriteLength(out, literals.size() - 15); }
+  out.insert(out.end(), literals.begin(), literals.end());
+}
+
+bool ReadLength(
+  std::span<const uint8_t> input, size_t& position, size_t& length
+) {
+  uint8_t byte;
+  do {
+    if (position >= input.size()) { return false; }
+    byte = input[position++];
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+}  // namespace
+
+std::vector<uint8_t> CompressLz4(std::span<const uint8_t> input) {
+  std::vector<uint8_t> out;
+  out.reserve(input.size() + input.size() / 255 + 16);
+  const uint8_t* data = input.data();
+  const size_t size = input.size();
+  size_t anchor = 0;
+
+  if (size > kMatchStartMargin) {
+    // Positions + 1 of the last sequence with each hash, 0 for none
+    std::vector<uint32_t> table(size_t{1} << kHashBits, 0);
+    const size_t matchEnd = size - kLastLiterals;
+    size_t i = 0;
+    while (i < size - kMatchStartMargin) {
+      const uint32_t sequence = Read32(data + i);
+      uint32_t& slot = table[HashSequence(sequence)];
+      const size_t candidate = slot;
+      slot = static_cast<uint32_t>(i + 1);
+      if (candidate == 0 || i - (candidate - 1) > kMaxOffset ||
+          Read32(data + candidate - 1) != sequence) {
+        ++i;
+        continue;
+      }
+
+      size_t match = candidate - 1;
+      size_t length = kMinMatch;
+      while (i + length < matchEnd &&
+             data[match + length] == data[i + length]) {
+        ++length;
+      }
+      // The bytes before may match too, taking them from the literals
+      while (i > anchor && match > 0 && data[i - 1] == data[match - 1]) {
+        --i;
+        --match;
+        ++length;
+      }
+
+      const size_t literalCount = i - anchor;
+      const size_t matchCode = length - kMinMatch;
+      out.push_back(static_cast<uint8_t>(
+        (std::min<size_t>(literalCount, 15) << 4) |
+        std::min<size_t>(matchCode, 15)
+      ));
+      WriteLiterals(out, input.subspan(anchor, literalCount));
+      const size_t offset = i - match;
+      out.push_back(static_cast<uint8_t>(offset));
+      out.push_back(static_cast<uint8_t>(offset >> 8));
+      if (matchCode >= 15) { WriteLength(out, matchCode - 15); }
+      i += length;
+      anchor = i;
+    }
+  }
+
+  // The last sequence is literals only
+  const size_t literalCount = size - anchor;
+  out.push_back(static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4));
+  WriteLiterals(out, input.subspan(anchor));
+  return out;
+}
+
+bool DecompressLz4(std::span<const uint8_t> input, std::span<uint8_t> output) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < input.size()) {
+    const uint8_t token = input[in++];
+    size_t literalCount = token >> 4;
+    if (literalCount == 15 && !ReadLength(input, in, literalCount)) {
+      return false;
+    }
+    if (literalCount > input.size() - in ||
+        literalCount > output.size() - out) {
+      return false;
+    }
+    if (literalCount > 0) {
+      std::memcpy(output.data() + out, input.data() + in, literalCount);
+    }
+    in += literalCount;
+    out += literalCount;
+    if (in == input.size()) { break; }
+
+    if (input.size() - in < 2) { return false; }
+    const size_t offset = input[in] | (input[in + 1] << 8);
+    in += 2;
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(input, in, length)) { return false; }
+    length += kMinMatch;
+    if (offset == 0 || offset > out || length > output.size() - out) {
+      return false;
+    }
+    uint8_t* destination = output.data() + out;
+    const uint8_t* source = destination - offset;
+    if (offset >= length) {
+      std::memcpy(destination, source, length);
+    } else {
+      // Overlapping copies repeat the last offset bytes, so go byte by byte
+      for (size_t i = 0; i < length; ++i) { destination[i] = source[i]; }
+    }
+    out += length;
+  }
+  return out == output.size();
+}
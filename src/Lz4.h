@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Compression in the LZ4 block format: runs of literal bytes and matches that
+// copy from up to 64 KB back, byte aligned so decoding is little more than
+// memcpy. Ratios are modest but decoding runs at memory speed, which suits
+// assets read at startup. Blocks don't record their decompressed size; the
+// caller stores it.
+
+// Greedy single-pass compression with a hash table of recent 4-byte sequences
+std::vector<uint8_t> CompressLz4(std::span<const uint8_t> input);
+
+// Decompresses a block into output, which must be exactly the original size.
+// Returns false if the block is malformed or doesn't fill output exactly.
+bool DecompressLz4(std::span<const uint8_t> input, std::span<uint8_t> output);
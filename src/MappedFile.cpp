@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+std::optional<MappedFile> MappedFile::Open(
+  const std::filesystem::path& path, std::string& error
+) {
+#if defined(_WIN32)
+  const HANDLE file = CreateFileW(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    error = "failed to open " + path.string();
+    return std::nullopt;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    error = "failed to get the size of " + path.string();
+    return std::nullopt;
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return MappedFile(nullptr, 0);
+  }
+  const HANDLE mapping =
+    CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  // The view keeps the file open
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    error = "failed to map " + path.string();
+    return std::nullopt;
+  }
+  const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    error = "failed to map " + path.string();
+    return std::nullopt;
+  }
+  return MappedFile(
+    static_cast<const uint8_t*>(data), static_cast<size_t>(size.QuadPart)
+  );
+#else
+  const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    error = "failed to open " + path.string() + ": " + std::strerror(errno);
+    return std::nullopt;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    error = "failed to stat " + path.string() + ": " + std::strerror(errno);
+    close(file);
+    return std::nullopt;
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  if (size == 0) {
+    close(file);
+    return MappedFile(nullptr, 0);
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  // The mapping keeps the file open
+  close(file);
+  if (data == MAP_FAILED) {
+    error = "failed to map " + path.string() + ": " + std::strerror(errno);
+    return std::nullopt;
+  }
+  return MappedFile(static_cast<const uint8_t*>(data), size);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+void MappedFile::Close() {
+  if (data_ == nullptr) { return; }
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+#else
+  munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+  if (offset >= size_) { return; }
+  Prefetch({data_ + offset, std::min(size, size_ - offset)});
+}
+
+void MappedFile::Prefetch(std::span<const uint8_t> range) {
+  if (range.empty()) { return; }
+#if defined(_WIN32)
+  WIN32_MEMORY_RANGE_ENTRY entry{
+    const_cast<uint8_t*>(range.data()), range.size()
+  };
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+#else
+  // madvise wants a page aligned start
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t start = reinterpret_cast<uintptr_t>(range.data());
+  const uintptr_t alignedStart = start & ~(pageSize - 1);
+  madvise(
+    reinterpret_cast<void*>(alignedStart),
+    range.size() + (start - alignedStart),
+    MADV_WILLNEED
+  );
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+
+// A whole file mapped read-only into memory. Pages are read on first access,
+// so opening is cheap and reading costs only I/O, with no copy into a buffer.
+class MappedFile {
+ public:
+  // On failure returns std::nullopt and describes the problem in error. Empty
+  // files map to an empty span.
+  static std::optional<MappedFile> Open(
+    const std::filesystem::path& path, std::string& error
+  );
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::span<const uint8_t> GetData() const { return {data_, size_}; }
+  size_t GetSize() const { return size_; }
+
+  // Asks the OS to start reading the given range in the background, so a
+  // later access doesn't fault on every page
+  void Prefetch(size_t offset, size_t size) const;
+  // The same for a range of any mapping, e.g. a view into a file owned
+  // elsewhere
+  static void Prefetch(std::span<const uint8_t> range);
+
+ private:
+  MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+  void Close();
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
@@ -0,0 +1,330 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+#include "GLState.h"
+#include "GLStats.h"
+#include "Hash.h"
+#include "Profiler.h"
+
+namespace {
+// Bitwise vertex key for deduplication
+struct VertexKey {
+  Vertex vertex;
+
+  bool operator==(const VertexKey& other) const {
+    return std::memcmp(&vertex, &other.vertex, sizeof(Vertex)) == 0;
+  }
+};
+
+struct VertexKeyHash {
+  size_t operator()(const VertexKey& key) const {
+    return static_cast<size_t>(HashFnv1a64(std::string_view(
+      reinterpret_cast<const char*>(&key.vertex), sizeof(Vertex)
+    )));
+  }
+};
+
+// Tuning constants from Forsyth's paper
+constexpr int kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float ComputeVertexScore(int cachePosition, uint32_t remainingTriangles) {
+  if (remainingTriangles == 0) { return -1.0f; }
+
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // The vertices of the last triangle get a fixed score so the next
+      // triangle doesn't simply reuse the same edge
+      score = kLastTriangleScore;
+    } else {
+      const float scale = 1.0f / (kCacheSize - 3);
+      score = std::pow(1.0f - (cachePosition - 3) * scale, kCacheDecayPower);
+    }
+  }
+  // Boost vertices with few triangles left so they get finished off
+  score += kValenceBoostScale * std::pow(
+                                  static_cast<float>(remainingTriangles),
+                                  -kValenceBoostPower
+                                );
+  return score;
+}
+}  // namespace
+
+MeshData BuildIndexedMesh(std::span<const Vertex> triangleVertices) {
+  LIZUAL_PROFILE_SCOPE("BuildIndexedMesh");
+  MeshData mesh;
+  mesh.indices.reserve(triangleVertices.size());
+
+  // 1. Merge identical vertices
+  std::unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices;
+  uniqueVertices.reserve(triangleVertices.size());
+  for (const Vertex& vertex : triangleVertices) {
+    auto [it, inserted] = uniqueVertices.try_emplace(
+      VertexKey{vertex}, static_cast<uint32_t>(mesh.vertices.size())
+    );
+    if (inserted) { mesh.vertices.push_back(vertex); }
+    mesh.indices.push_back(it->second);
+  }
+
+  // 2. Reorder triangles for the post-transform cache
+  OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+
+  // 3. Reorder vertices by first use for the pre-transform fetch
+  constexpr uint32_t kUnassigned = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(mesh.vertices.size(), kUnassigned);
+  std::vector<Vertex> orderedVertices;
+  orderedVertices.reserve(mesh.vertices.size());
+  for (uint32_t& index : mesh.indices) {
+    if (remap[index] == kUnassigned) {
+      remap[index] = static_cast<uint32_t>(orderedVertices.size());
+      orderedVertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(orderedVertices);
+
+  return mesh;
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount) {
+  const size_t triangleCount = indices.size() / 3;
+  if (triangleCount == 0) { return; }
+
+  // Per-vertex adjacency: the triangles that use each vertex, as ranges into
+  // one flat array
+  std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+  for (uint32_t index : indices) { ++remainingTriangles[index]; }
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+  }
+  std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+  {
+    std::vector<uint32_t> fill(adjacencyOffsets);
+    for (size_t t = 0; t < triangleCount; ++t) {
+      for (size_t corner = 0; corner < 3; ++corner) {
+        adjacency[fill[indices[t * 3 + corner]]++] = static_cast<uint32_t>(t);
+      }
+    }
+  }
+
+  std::vector<float> vertexScore(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    vertexScore[v] = ComputeVertexScore(-1, remainingTriangles[v]);
+  }
+  std::vector<bool> emitted(triangleCount, false);
+
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  // Simulated LRU cache, most recent first. Holds up to 3 extra entries while
+  // a triangle is being added.
+  std::vector<uint32_t> cache;
+  cache.reserve(kCacheSize + 3);
+  std::vector<uint32_t> newCache;
+  newCache.reserve(kCacheSize + 3);
+
+  // Cursor for the fallback search when no cached vertex has triangles left
+  size_t searchCursor = 0;
+  int64_t bestTriangle = -1;
+  for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+    if (bestTriangle < 0) {
+      while (emitted[searchCursor]) { ++searchCursor; }
+      bestTriangle = static_cast<int64_t>(searchCursor);
+    }
+
+    // Emit the triangle and push its vertices to the front of the cache
+    const size_t t = static_cast<size_t>(bestTriangle);
+    emitted[t] = true;
+    newCache.clear();
+    for (size_t corner = 0; corner < 3; ++corner) {
+      const uint32_t v = indices[t * 3 + corner];
+      output.push_back(v);
+      newCache.push_back(v);
+      --remainingTriangles[v];
+      // Remove the triangle from the vertex's adjacency so the remaining
+      // triangles stay at the front of its range
+      uint32_t* begin = adjacency.data() + adjacencyOffsets[v];
+      uint32_t* end = begin + remainingTriangles[v] + 1;
+      std::iter_swap(std::find(begin, end, static_cast<uint32_t>(t)), end - 1);
+    }
+    for (uint32_t v : cache) {
+      if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+        newCache.push_back(v);
+      }
+    }
+    // Vertices that fall out of the cache lose their cache score
+    for (size_t i = kCacheSize; i < newCache.size(); ++i) {
+      const uint32_t v = newCache[i];
+      vertexScore[v] = ComputeVertexScore(-1, remainingTriangles[v]);
+    }
+    newCache.resize(std::min<size_t>(newCache.size(), kCacheSize));
+    cache.swap(newCache);
+
+    // Rescore the cached vertices and their triangles, tracking the best
+    // candidate for the next emit
+    for (size_t i = 0; i < cache.size(); ++i) {
+      const uint32_t v = cache[i];
+      vertexScore[v] =
+        ComputeVertexScore(static_cast<int>(i), remainingTriangles[v]);
+    }
+    bestTriangle = -1;
+    float bestScore = -1.0f;
+    for (uint32_t v : cache) {
+      const uint32_t* adjacent = adjacency.data() + adjacencyOffsets[v];
+      for (uint32_t i = 0; i < remainingTriangles[v]; ++i) {
+        const uint32_t adjacentTriangle = adjacent[i];
+        const float score = vertexScore[indices[adjacentTriangle * 3]] +
+                            vertexScore[indices[adjacentTriangle * 3 + 1]] +
+                            vertexScore[indices[adjacentTriangle * 3 + 2]];
+        if (score > bestScore) {
+          bestScore = score;
+          bestTriangle = adjacentTriangle;
+        }
+      }
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+float ComputeAverageCacheMissRatio(
+  std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize
+) {
+  if (indices.size() < 3) { return 0.0f; }
+
+  // FIFO cache, as implemented by most hardware
+  std::vector<bool> inCache(vertexCount, false);
+  std::deque<uint32_t> fifo;
+  size_t misses = 0;
+  for (uint32_t index : indices) {
+    if (inCache[index]) { continue; }
+    ++misses;
+    inCache[index] = true;
+    fifo.push_back(index);
+    if (fifo.size() > cacheSize) {
+      inCache[fifo.front()] = false;
+      fifo.pop_front();
+    }
+  }
+  return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+std::vector<Vertex> BuildSphereTriangles(uint32_t segments, uint32_t rings) {
+  segments = std::max(segments, 3u);
+  rings = std::max(rings, 2u);
+  constexpr float kPi = 3.14159265358979f;
+  auto pointAt = [&](uint32_t segment, uint32_t ring) {
+    const float u = static_cast<float>(segment) / segments;
+    const float v = static_cast<float>(ring) / rings;
+    const float theta = u * 2.0f * kPi;
+    const float phi = v * kPi;
+    return Vertex{
+      {0.5f * std::sin(phi) * std::cos(theta),
+       0.5f * std::cos(phi),
+       0.5f * std::sin(phi) * std::sin(theta)},
+      {u, 1.0f - v}
+    };
+  };
+
+  std::vector<Vertex> triangles;
+  triangles.reserve(static_cast<size_t>(segments) * (rings - 1) * 6);
+  for (uint32_t ring = 0; ring < rings; ++ring) {
+    for (uint32_t segment = 0; segment < segments; ++segment) {
+      const Vertex a = pointAt(segment, ring);
+      const Vertex b = pointAt(segment + 1, ring);
+      const Vertex c = pointAt(segment, ring + 1);
+      const Vertex d = pointAt(segment + 1, ring + 1);
+      // The quads touching the poles collapse into one triangle
+      if (ring != 0) { triangles.insert(triangles.end(), {a, b, d}); }
+      if (ring != rings - 1) { triangles.insert(triangles.end(), {a, d, c}); }
+    }
+  }
+  return triangles;
+}
+
+Mesh::Mesh(const MeshData& data)
+    : vao_(0),
+      vbo_(0),
+      ebo_(0),
+      indexCount_(static_cast<GLsizei>(data.indices.size())),
+      indexType_(GL_UNSIGNED_INT) {
+  glGenVertexArrays(1, &vao_);
+  GLState::BindVertexArray(vao_);
+
+  glGenBuffers(1, &vbo_);
+  GLState::BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(
+    GL_ARRAY_BUFFER,
+    data.vertices.size() * sizeof(Vertex),
+    data.vertices.data(),
+    GL_STATIC_DRAW
+  );
+  GLStats::RecordBufferUpload(data.vertices.size() * sizeof(Vertex));
+
+  // The element buffer binding is part of the VAO state
+  glGenBuffers(1, &ebo_);
+  GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+  if (data.vertices.size() <= std::numeric_limits<uint16_t>::max() + 1u) {
+    indexType_ = GL_UNSIGNED_SHORT;
+    std::vector<uint16_t> shortIndices(
+      data.indices.begin(), data.indices.end()
+    );
+    glBufferData(
+      GL_ELEMENT_ARRAY_BUFFER,
+      shortIndices.size() * sizeof(uint16_t),
+      shortIndices.data(),
+      GL_STATIC_DRAW
+    );
+    GLStats::RecordBufferUpload(shortIndices.size() * sizeof(uint16_t));
+  } else {
+    glBufferData(
+      GL_ELEMENT_ARRAY_BUFFER,
+      data.indices.size() * sizeof(uint32_t),
+      data.indices.data(),
+      GL_STATIC_DRAW
+    );
+    GLStats::RecordBufferUpload(data.indices.size() * sizeof(uint32_t));
+  }
+
+  // position
+  GLState::VertexAttribPointer(
+    0, 3, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, position)
+  );
+  GLState::SetVertexAttribArrayEnabled(0, true);
+  // texture coords
+  GLState::VertexAttribPointer(
+    1, 2, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, texCoord)
+  );
+  GLState::SetVertexAttribArrayEnabled(1, true);
+}
+
+Mesh::~Mesh() {
+  GLState::DeleteBuffers(1, &ebo_);
+  GLState::DeleteBuffers(1, &vbo_);
+  GLState::DeleteVertexArrays(1, &vao_);
+}
+
+void Mesh::Draw() const {
+  GLState::BindVertexArray(vao_);
+  glDrawElements(GL_TRIANGLES, indexCount_, indexType_, nullptr);
+  GLStats::RecordDraw(indexCount_ / 3);
+}
+
+void Mesh::DrawInstanced(GLsizei instanceCount) const {
+  GLState::BindVertexArray(vao_);
+  glDrawElementsInstanced(
+    GL_TRIANGLES, indexCount_, indexType_, nullptr, instanceCount
+  );
+  GLStats::RecordDraw(indexCount_ / 3, instanceCount);
+}
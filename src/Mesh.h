@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct Vertex {
+  glm::vec3 position;
+  glm::vec2 texCoord;
+};
+
+// An indexed triangle list on the CPU
+struct MeshData {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// Builds an indexed mesh from a triangle list where every triangle has its own
+// three vertices. Bitwise identical vertices are merged, triangles are
+// reordered for the post-transform vertex cache (OptimizeVertexCache), and
+// vertices are reordered by first use so vertex fetch walks memory linearly.
+MeshData BuildIndexedMesh(std::span<const Vertex> triangleVertices);
+
+// Reorders the triangles of an indexed triangle list to maximize post-transform
+// vertex cache hits, using Tom Forsyth's "Linear-Speed Vertex Cache
+// Optimisation".
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+// Average number of vertex shader invocations per triangle for a FIFO cache of
+// cacheSize entries. 0.5 is the ideal for large regular meshes, 3 is no reuse.
+float ComputeAverageCacheMissRatio(
+  std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize = 16
+);
+
+// Triangle list of a UV sphere of diameter 1 centered at the origin, for
+// BuildIndexedMesh. Texture coordinates wrap once around and from pole to
+// pole.
+std::vector<Vertex> BuildSphereTriangles(uint32_t segments, uint32_t rings);
+
+// An indexed mesh uploaded to the GPU. Vertex attributes 0 (position) and 1
+// (texture coordinates) are set up in its vertex array object. Indices are
+// stored as 16-bit when the vertex count allows it.
+class Mesh {
+ public:
+  explicit Mesh(const MeshData& data);
+  ~Mesh();
+  Mesh(const Mesh&) = delete;
+  Mesh& operator=(const Mesh&) = delete;
+
+  GLuint GetVertexArray() const { return vao_; }
+  GLsizei GetIndexCount() const { return indexCount_; }
+
+  // Draws with the mesh's vertex array object bound
+  void Draw() const;
+  void DrawInstanced(GLsizei instanceCount) const;
+
+ private:
+  GLuint vao_;
+  GLuint vbo_;
+  GLuint ebo_;
+  GLsizei indexCount_;
+  GLenum indexType_;
+};
@@ -0,0 +1,395 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#include "MipGeneratorKernels.h"
+
+#if LIZUAL_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Lobes of the Lanczos filter on each side of a tap
+constexpr int kLanczosRadius = 3;
+
+double Lanczos(double x) {
+  x = std::abs(x);
+  if (x < 1e-8) { return 1.0; }
+  if (x >= kLanczosRadius) { return 0.0; }
+  const double pi = std::numbers::pi;
+  return kLanczosRadius * std::sin(pi * x) * std::sin(pi * x / kLanczosRadius) /
+         (pi * pi * x * x);
+}
+
+// Taps of a 1D resampling from inSize to outSize texels. Every output texel
+// has tapCount taps; unused ones have weight 0.
+struct AxisFilter {
+  size_t tapCount;
+  std::vector<uint32_t> indices;
+  std::vector<float> weights;
+};
+
+AxisFilter BuildAxisFilter(int inSize, int outSize, bool wrap) {
+  // Stretching the filter by the reduction makes it a low-pass at the output's
+  // Nyquist frequency
+  const double scale = static_cast<double>(inSize) / outSize;
+  const double support = kLanczosRadius * scale;
+  AxisFilter filter;
+  filter.tapCount = static_cast<size_t>(std::ceil(2.0 * support)) + 1;
+  filter.indices.resize(outSize * filter.tapCount, 0);
+  filter.weights.resize(outSize * filter.tapCount, 0.0f);
+  for (int i = 0; i < outSize; ++i) {
+    // Texel centers are at half integers
+    const double center = (i + 0.5) * scale;
+    const int first = static_cast<int>(std::ceil(center - support - 0.5));
+    std::vector<double> weights(filter.tapCount);
+    double weightSum = 0.0;
+    for (size_t k = 0; k < filter.tapCount; ++k) {
+      const int tap = first + static_cast<int>(k);
+      weights[k] = Lanczos((tap + 0.5 - center) / scale);
+      weightSum += weights[k];
+      const int index = wrap ? ((tap % inSize) + inSize) % inSize
+                             : std::clamp(tap, 0, inSize - 1);
+      filter.indices[i * filter.tapCount + k] = static_cast<uint32_t>(index);
+    }
+    for (size_t k = 0; k < filter.tapCount; ++k) {
+      filter.weights[i * filter.tapCount + k] =
+        static_cast<float>(weights[k] / weightSum);
+    }
+  }
+  return filter;
+}
+
+float SrgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f
+                         : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// RGBA8 to float RGBA with color in linear light (if srgb) premultiplied by
+// alpha
+std::vector<float> Decode(
+  std::span<const uint8_t> pixels, const MipSettings& settings
+) {
+  std::array<float, 256> toLinear;
+  for (int i = 0; i < 256; ++i) {
+    toLinear[i] = settings.srgb ? SrgbToLinear(i / 255.0f) : i / 255.0f;
+  }
+  std::vector<float> out(pixels.size());
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    const float alpha = pixels[i + 3] / 255.0f;
+    out[i] = toLinear[pixels[i]] * alpha;
+    out[i + 1] = toLinear[pixels[i + 1]] * alpha;
+    out[i + 2] = toLinear[pixels[i + 2]] * alpha;
+    out[i + 3] = alpha;
+  }
+  return out;
+}
+
+// Inverse of Decode. The filter's negative lobes can overshoot, so values
+// are clamped.
+std::vector<uint8_t> Encode(
+  const std::vector<float>& pixels, const MipSettings& settings
+) {
+  auto toByte = [](float c) {
+    return static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+  };
+  std::vector<uint8_t> out(pixels.size());
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    const float alpha = std::clamp(pixels[i + 3], 0.0f, 1.0f);
+    for (size_t channel = 0; channel < 3; ++channel) {
+      float c = alpha > 0.0f ? pixels[i + channel] / alpha : 0.0f;
+      c = std::clamp(c, 0.0f, 1.0f);
+      out[i + channel] = toByte(settings.srgb ? LinearToSrgb(c) : c);
+    }
+    out[i + 3] = toByte(alpha);
+  }
+  return out;
+}
+
+void FilterRows(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out,
+  SimdLevel level
+) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      mip_kernels::FilterRowsScalar(rows, weights, tapCount, count, out);
+      break;
+    case SimdLevel::kSSE2:
+      mip_kernels::FilterRowsSSE2(rows, weights, tapCount, count, out);
+      break;
+    case SimdLevel::kAVX2:
+      mip_kernels::FilterRowsAVX2(rows, weights, tapCount, count, out);
+      break;
+  }
+}
+
+void FilterPixels(
+  const float* row, const AxisFilter& filter, float* out, SimdLevel level
+) {
+  const size_t outWidth = filter.indices.size() / filter.tapCount;
+  switch (level) {
+    case SimdLevel::kScalar:
+      mip_kernels::FilterPixelsScalar(
+        row,
+        filter.indices.data(),
+        filter.weights.data(),
+        filter.tapCount,
+        outWidth,
+        out
+      );
+      break;
+    case SimdLevel::kSSE2:
+      mip_kernels::FilterPixelsSSE2(
+        row,
+        filter.indices.data(),
+        filter.weights.data(),
+        filter.tapCount,
+        outWidth,
+        out
+      );
+      break;
+    case SimdLevel::kAVX2:
+      mip_kernels::FilterPixelsAVX2(
+        row,
+        filter.indices.data(),
+        filter.weights.data(),
+        filter.tapCount,
+        outWidth,
+        out
+      );
+      break;
+  }
+}
+}  // namespace
+
+namespace mip_kernels {
+
+void FilterRowsScalar(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  for (size_t i = 0; i < count; ++i) {
+    float sum = 0.0f;
+    for (size_t k = 0; k < tapCount; ++k) { sum += weights[k] * rows[k][i]; }
+    out[i] = sum;
+  }
+}
+
+void FilterPixelsScalar(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  for (size_t x = 0; x < outWidth; ++x, out += 4) {
+    float sum[4] = {};
+    for (size_t k = 0; k < tapCount; ++k) {
+      const float weight = weights[x * tapCount + k];
+      const float* pixel = row + indices[x * tapCount + k] * 4;
+      for (size_t channel = 0; channel < 4; ++channel) {
+        sum[channel] += weight * pixel[channel];
+      }
+    }
+    std::copy(sum, sum + 4, out);
+  }
+}
+
+#if LIZUAL_SIMD_X86
+
+void FilterRowsSSE2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  size_t i = 0;
+  // Two accumulators hide the latency of the adds
+  for (; i + 8 <= count; i += 8) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      const __m128 weight = _mm_set1_ps(weights[k]);
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(weight, _mm_loadu_ps(rows[k] + i)));
+      sum1 =
+        _mm_add_ps(sum1, _mm_mul_ps(weight, _mm_loadu_ps(rows[k] + i + 4)));
+    }
+    _mm_storeu_ps(out + i, sum0);
+    _mm_storeu_ps(out + i + 4, sum1);
+  }
+  for (; i < count; ++i) {
+    float sum = 0.0f;
+    for (size_t k = 0; k < tapCount; ++k) { sum += weights[k] * rows[k][i]; }
+    out[i] = sum;
+  }
+}
+
+void FilterPixelsSSE2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  // One RGBA pixel per register
+  for (size_t x = 0; x < outWidth; ++x, out += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      const __m128 pixel = _mm_loadu_ps(row + indices[x * tapCount + k] * 4);
+      sum = _mm_add_ps(
+        sum, _mm_mul_ps(_mm_set1_ps(weights[x * tapCount + k]), pixel)
+      );
+    }
+    _mm_storeu_ps(out, sum);
+  }
+}
+
+#if !LIZUAL_AVX2_KERNELS
+// This build has no AVX2 kernels (see CMakeLists.txt), so the AVX2
+// translation unit is empty and AVX2 requests fall back to SSE2.
+void FilterRowsAVX2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  FilterRowsSSE2(rows, weights, tapCount, count, out);
+}
+
+void FilterPixelsAVX2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  FilterPixelsSSE2(row, indices, weights, tapCount, outWidth, out);
+}
+#endif
+
+#else
+
+void FilterRowsSSE2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  FilterRowsScalar(rows, weights, tapCount, count, out);
+}
+
+void FilterRowsAVX2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  FilterRowsScalar(rows, weights, tapCount, count, out);
+}
+
+void FilterPixelsSSE2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  FilterPixelsScalar(row, indices, weights, tapCount, outWidth, out);
+}
+
+void FilterPixelsAVX2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  FilterPixelsScalar(row, indices, weights, tapCount, outWidth, out);
+}
+
+#endif  // LIZUAL_SIMD_X86
+
+}  // namespace mip_kernels
+
+std::vector<MipLevel> GenerateMipChain(
+  std::span<const uint8_t> pixels,
+  int width,
+  int height,
+  const MipSettings& settings,
+  SimdLevel level
+) {
+  std::vector<MipLevel> levels;
+  levels.push_back({width, height, {pixels.begin(), pixels.end()}});
+
+  std::vector<float> current = Decode(pixels, settings);
+  std::vector<float> verticalPass;
+  std::vector<const float*> rows;
+  while (width > 1 || height > 1) {
+    const int outWidth = std::max(width / 2, 1);
+    const int outHeight = std::max(height / 2, 1);
+    const AxisFilter horizontal =
+      BuildAxisFilter(width, outWidth, settings.wrap);
+    const AxisFilter vertical =
+      BuildAxisFilter(height, outHeight, settings.wrap);
+
+    // Vertical first: it streams whole rows, which vectorizes best, and
+    // halves the rows the horizontal pass has to filter
+    const size_t rowFloats = static_cast<size_t>(width) * 4;
+    verticalPass.resize(outHeight * rowFloats);
+    rows.resize(vertical.tapCount);
+    for (int y = 0; y < outHeight; ++y) {
+      for (size_t k = 0; k < vertical.tapCount; ++k) {
+        rows[k] =
+          current.data() + vertical.indices[y * vertical.tapCount + k] *
+                             rowFloats;
+      }
+      FilterRows(
+        rows.data(),
+        &vertical.weights[y * vertical.tapCount],
+        vertical.tapCount,
+        rowFloats,
+        &verticalPass[y * rowFloats],
+        level
+      );
+    }
+
+    std::vector<float> next(static_cast<size_t>(outWidth) * outHeight * 4);
+    for (int y = 0; y < outHeight; ++y) {
+      FilterPixels(
+        &verticalPass[y * rowFloats],
+        horizontal,
+        &next[static_cast<size_t>(y) * outWidth * 4],
+        level
+      );
+    }
+
+    levels.push_back({outWidth, outHeight, Encode(next, settings)});
+    current = std::move(next);
+    width = outWidth;
+    height = outHeight;
+  }
+  return levels;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Simd.h"
+
+// One RGBA8 mip level
+struct MipLevel {
+  int width;
+  int height;
+  std::vector<uint8_t> pixels;
+};
+
+struct MipSettings {
+  // Filter in linear light and re-encode, for color textures. Data textures
+  // (normals, masks) should turn this off.
+  bool srgb = true;
+  // Filter taps that fall off an edge wrap around, matching GL_REPEAT.
+  // Otherwise they clamp to the edge.
+  bool wrap = true;
+};
+
+// Builds a full mip chain of an RGBA8 image, level 0 being a copy of it. Each
+// level is a 2:1 reduction of the previous one with a Lanczos-3 filter, much
+// sharper than the box filter drivers use for glGenerateMipmap. Color is
+// weighted by alpha, so transparent texels don't bleed into their neighbours.
+// Intermediate levels are kept in float, so rounding doesn't accumulate.
+std::vector<MipLevel> GenerateMipChain(
+  std::span<const uint8_t> pixels,
+  int width,
+  int height,
+  const MipSettings& settings = {},
+  SimdLevel level = GetSupportedSimdLevel()
+);
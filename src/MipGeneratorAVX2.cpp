@@ -0,0 +1,91 @@
+// Built with AVX2 and FMA enabled (see CMakeLists.txt). Only called after
+// GetSupportedSimdLevel() has checked that the CPU supports them. Must not
+// include glm or other headers with inline functions shared with the rest of
+// the program.
+#include "MipGeneratorKernels.h"
+#include "Simd.h"
+
+#if LIZUAL_AVX2_KERNELS
+#include <immintrin.h>
+
+namespace mip_kernels {
+
+void FilterRowsAVX2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      const __m256 weight = _mm256_set1_ps(weights[k]);
+      sum0 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(rows[k] + i), sum0);
+      sum1 = _mm256_fmadd_ps(weight, _mm256_loadu_ps(rows[k] + i + 8), sum1);
+    }
+    _mm256_storeu_ps(out + i, sum0);
+    _mm256_storeu_ps(out + i + 8, sum1);
+  }
+  for (; i + 4 <= count; i += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      sum = _mm_fmadd_ps(
+        _mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i), sum
+      );
+    }
+    _mm_storeu_ps(out + i, sum);
+  }
+  for (; i < count; ++i) {
+    float sum = 0.0f;
+    for (size_t k = 0; k < tapCount; ++k) { sum += weights[k] * rows[k][i]; }
+    out[i] = sum;
+  }
+}
+
+void FilterPixelsAVX2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+) {
+  // Two output pixels per register, one in each 128-bit half
+  size_t x = 0;
+  for (; x + 2 <= outWidth; x += 2, out += 8) {
+    const uint32_t* indices0 = indices + x * tapCount;
+    const uint32_t* indices1 = indices0 + tapCount;
+    const float* weights0 = weights + x * tapCount;
+    const float* weights1 = weights0 + tapCount;
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      const __m256 pixels = _mm256_setr_m128(
+        _mm_loadu_ps(row + indices0[k] * 4),
+        _mm_loadu_ps(row + indices1[k] * 4)
+      );
+      const __m256 weight = _mm256_setr_m128(
+        _mm_set1_ps(weights0[k]), _mm_set1_ps(weights1[k])
+      );
+      sum = _mm256_fmadd_ps(weight, pixels, sum);
+    }
+    _mm256_storeu_ps(out, sum);
+  }
+  if (x < outWidth) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t k = 0; k < tapCount; ++k) {
+      sum = _mm_fmadd_ps(
+        _mm_set1_ps(weights[x * tapCount + k]),
+        _mm_loadu_ps(row + indices[x * tapCount + k] * 4),
+        sum
+      );
+    }
+    _mm_storeu_ps(out, sum);
+  }
+}
+
+}  // namespace mip_kernels
+
+#endif  // LIZUAL_AVX2_KERNELS
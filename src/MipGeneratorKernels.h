@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels behind GenerateMipChain. Like TransformBatchKernels.h, this is kept
+// free of glm so the AVX2 translation unit can include it.
+namespace mip_kernels {
+
+// Vertical pass: out[i] = sum over k of weights[k] * rows[k][i], for i below
+// count. Rows are tapCount rows of float RGBA pixels.
+void FilterRowsScalar(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+);
+void FilterRowsSSE2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+);
+void FilterRowsAVX2(
+  const float* const* rows,
+  const float* weights,
+  size_t tapCount,
+  size_t count,
+  float* out
+);
+
+// Horizontal pass over one row of float RGBA pixels: output pixel x is the sum
+// over k of weights[x * tapCount + k] times input pixel
+// indices[x * tapCount + k]
+void FilterPixelsScalar(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+);
+void FilterPixelsSSE2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+);
+void FilterPixelsAVX2(
+  const float* row,
+  const uint32_t* indices,
+  const float* weights,
+  size_t tapCount,
+  size_t outWidth,
+  float* out
+);
+
+}  // namespace mip_kernels
@@ -0,0 +1,254 @@
+#include "Profiler.h"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace {
+// Ring buffer of one thread's events. Only the owning thread writes events and
+// advances writeIndex; readers copy events and then re-check writeIndex to
+// drop any that were overwritten while copying.
+struct ThreadBuffer {
+  explicit ThreadBuffer(uint32_t id)
+      : id(id), events(Profiler::kEventsPerThread) {}
+
+  const uint32_t id;
+  // Guarded by the registry mutex
+  std::string name;
+  std::vector<ProfileEvent> events;
+  // Total number of events written. The next event goes to
+  // events[writeIndex % kEventsPerThread].
+  std::atomic<uint64_t> writeIndex = 0;
+  // Current zone nesting depth, only touched by the owning thread
+  uint32_t depth = 0;
+  // Cleared when the owning thread exits, so the buffer can be reused by a
+  // new thread instead of growing the registry with every std::async
+  std::atomic<bool> inUse = true;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+};
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+// Releases the thread's buffer when the thread exits
+struct ThreadBufferLease {
+  ThreadBuffer* buffer = nullptr;
+
+  ~ThreadBufferLease() {
+    if (buffer != nullptr) { buffer->inUse.store(false); }
+  }
+};
+
+ThreadBuffer& GetThreadBuffer() {
+  thread_local ThreadBufferLease lease;
+  if (lease.buffer != nullptr) { return *lease.buffer; }
+
+  Registry& registry = GetRegistry();
+  std::lock_guard lock(registry.mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry.threads) {
+    if (!buffer->inUse.load()) {
+      buffer->inUse.store(true);
+      buffer->name.clear();
+      buffer->depth = 0;
+      lease.buffer = buffer.get();
+      return *lease.buffer;
+    }
+  }
+  const uint32_t id = static_cast<uint32_t>(registry.threads.size()) + 1;
+  registry.threads.push_back(std::make_unique<ThreadBuffer>(id));
+  lease.buffer = registry.threads.back().get();
+  return *lease.buffer;
+}
+
+// Frame start times, written and read by the frame thread only
+std::array<uint64_t, Profiler::kFrameHistory + 1> frameStarts;
+uint64_t frameCount = 0;
+
+void WriteJsonString(std::ofstream& out, std::string_view string) {
+  out << '"';
+  for (const char c : string) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+}  // namespace
+
+uint64_t Profiler::Now() {
+  static const uint64_t frequency = SDL_GetPerformanceFrequency();
+  const uint64_t counter = SDL_GetPerformanceCounter();
+  // Split to avoid overflowing counter * 1e9
+  return counter / frequency * SDL_NS_PER_SECOND +
+         counter % frequency * SDL_NS_PER_SECOND / frequency;
+}
+
+void Profiler::SetThreadName(const char* name) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard lock(GetRegistry().mutex);
+  buffer.name = name;
+}
+
+void Profiler::BeginFrame() {
+  frameStarts[frameCount % frameStarts.size()] = Now();
+  ++frameCount;
+}
+
+void Profiler::GetFrames(std::vector<Frame>& out) {
+  if (frameCount < 2) { return; }
+  const uint64_t completed = std::min<uint64_t>(frameCount - 1, kFrameHistory);
+  for (uint64_t i = frameCount - 1 - completed; i < frameCount - 1; ++i) {
+    out.push_back(
+      {frameStarts[i % frameStarts.size()],
+       frameStarts[(i + 1) % frameStarts.size()]}
+    );
+  }
+}
+
+void Profiler::CollectEvents(
+  uint64_t startNs, uint64_t endNs, std::vector<ProfileThreadEvents>& out
+) {
+  Registry& registry = GetRegistry();
+  std::lock_guard lock(registry.mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : registry.threads) {
+    const uint64_t writeIndex =
+      buffer->writeIndex.load(std::memory_order_acquire);
+    const uint64_t oldest =
+      writeIndex > kEventsPerThread ? writeIndex - kEventsPerThread : 0;
+
+    // Events are written as zones end, so end times only grow. Walk back from
+    // the newest event until they end before the range.
+    ProfileThreadEvents thread{
+      buffer->id,
+      buffer->name.empty() ? "Thread " + std::to_string(buffer->id)
+                           : buffer->name,
+      {}
+    };
+    // Ring index of each copied event, newest first
+    std::vector<uint64_t> copiedIndices;
+    for (uint64_t index = writeIndex; index > oldest; --index) {
+      const ProfileEvent& event =
+        buffer->events[(index - 1) % kEventsPerThread];
+      if (event.endNs <= startNs) { break; }
+      if (event.startNs < endNs) {
+        thread.events.push_back(event);
+        copiedIndices.push_back(index - 1);
+      }
+    }
+
+    // Drop events the writer may have overwritten while they were copied. It
+    // can be writing the slot of writeIndex - kEventsPerThread at any time.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t writeIndexAfter =
+      buffer->writeIndex.load(std::memory_order_relaxed);
+    const uint64_t firstValid = writeIndexAfter >= kEventsPerThread
+                                  ? writeIndexAfter - kEventsPerThread + 1
+                                  : 0;
+    while (!copiedIndices.empty() && copiedIndices.back() < firstValid) {
+      copiedIndices.pop_back();
+      thread.events.pop_back();
+    }
+    if (thread.events.empty()) { continue; }
+
+    // Oldest first
+    std::reverse(thread.events.begin(), thread.events.end());
+    out.push_back(std::move(thread));
+  }
+}
+
+bool Profiler::WriteChromeTrace(const std::filesystem::path& path) {
+  std::vector<ProfileThreadEvents> threads;
+  CollectEvents(0, std::numeric_limits<uint64_t>::max(), threads);
+
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    SDL_Log(
+      "Profiler: Failed to open trace file for writing: %s",
+      path.string().c_str()
+    );
+    return false;
+  }
+
+  // Timestamps are relative to the oldest event to keep them short
+  uint64_t originNs = std::numeric_limits<uint64_t>::max();
+  size_t eventCount = 0;
+  for (const ProfileThreadEvents& thread : threads) {
+    for (const ProfileEvent& event : thread.events) {
+      originNs = std::min(originNs, event.startNs);
+    }
+    eventCount += thread.events.size();
+  }
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  bool first = true;
+  for (const ProfileThreadEvents& thread : threads) {
+    out << (first ? "" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << thread.threadId << ",\"args\":{\"name\":";
+    WriteJsonString(out, thread.threadName);
+    out << "}}";
+    first = false;
+
+    for (const ProfileEvent& event : thread.events) {
+      // Microseconds with nanosecond precision
+      char times[64];
+      std::snprintf(
+        times,
+        sizeof(times),
+        "\"ts\":%.3f,\"dur\":%.3f",
+        (event.startNs - originNs) / 1000.0,
+        (event.endNs - event.startNs) / 1000.0
+      );
+      out << ",\n{\"name\":";
+      WriteJsonString(out, event.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId << ","
+          << times << "}";
+    }
+  }
+  out << "\n]}\n";
+  if (!out) {
+    SDL_Log(
+      "Profiler: Failed to write trace file: %s", path.string().c_str()
+    );
+    return false;
+  }
+
+  SDL_Log(
+    "Profiler: Wrote %zu events from %zu threads to %s",
+    eventCount,
+    threads.size(),
+    path.string().c_str()
+  );
+  return true;
+}
+
+uint32_t Profiler::EnterZone() { return GetThreadBuffer().depth++; }
+
+void Profiler::LeaveZone(const char* name, uint64_t startNs, uint32_t depth) {
+  const uint64_t endNs = Now();
+  ThreadBuffer& buffer = GetThreadBuffer();
+  buffer.depth = depth;
+  const uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+  buffer.events[index % kEventsPerThread] = {name, startNs, endNs, depth};
+  buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile the profiling macros out
+#ifndef LIZUAL_PROFILER
+#define LIZUAL_PROFILER 1
+#endif
+
+// A completed profiling zone. Names are string literals, so only the pointer
+// is stored.
+struct ProfileEvent {
+  const char* name;
+  uint64_t startNs;
+  uint64_t endNs;
+  // Nesting depth on its thread, 0 for outermost zones
+  uint32_t depth;
+};
+
+// Events of one thread, as returned by Profiler::CollectEvents
+struct ProfileThreadEvents {
+  uint32_t threadId;
+  std::string threadName;
+  std::vector<ProfileEvent> events;
+};
+
+// Hierarchical CPU profiler. Zones are recorded with LIZUAL_PROFILE_SCOPE into
+// a fixed-size ring buffer per thread, which the owning thread writes without
+// locks; the oldest events are overwritten once a ring is full. Readers take
+// consistent snapshots while threads keep recording.
+//
+// Timestamps are nanoseconds derived from SDL_GetPerformanceCounter.
+class Profiler {
+ public:
+  // Events kept per thread
+  static constexpr size_t kEventsPerThread = 1 << 16;
+  // Frame boundaries kept for GetFrames
+  static constexpr size_t kFrameHistory = 240;
+
+  struct Frame {
+    uint64_t startNs;
+    uint64_t endNs;
+  };
+
+  static uint64_t Now();
+
+  // Names the calling thread in the flame graph and trace. Threads that are
+  // never named show up as "Thread <id>".
+  static void SetThreadName(const char* name);
+
+  // Marks the start of a frame (and the end of the previous one). Must be
+  // called from one thread only, normally the main thread.
+  static void BeginFrame();
+
+  // Appends the completed frames, oldest first. Same thread as BeginFrame.
+  static void GetFrames(std::vector<Frame>& out);
+
+  // Appends, per thread, the recorded events that overlap [startNs, endNs).
+  // Safe to call from any thread while others record.
+  static void CollectEvents(
+    uint64_t startNs, uint64_t endNs, std::vector<ProfileThreadEvents>& out
+  );
+
+  // Writes every event still in the rings as Chrome trace_event JSON, which
+  // can be opened in chrome://tracing or https://ui.perfetto.dev. Returns
+  // false if the file could not be written.
+  static bool WriteChromeTrace(const std::filesystem::path& path);
+
+  // Called by ProfileScope
+  static uint32_t EnterZone();
+  static void LeaveZone(const char* name, uint64_t startNs, uint32_t depth);
+};
+
+// Records the enclosing scope as a zone
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name)
+      : name_(name), depth_(Profiler::EnterZone()), startNs_(Profiler::Now()) {}
+  ~ProfileScope() { Profiler::LeaveZone(name_, startNs_, depth_); }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  const char* name_;
+  uint32_t depth_;
+  uint64_t startNs_;
+};
+
+#define LIZUAL_PROFILE_CONCAT_INNER(a, b) a##b
+#define LIZUAL_PROFILE_CONCAT(a, b) LIZUAL_PROFILE_CONCAT_INNER(a, b)
+
+#if LIZUAL_PROFILER
+// Profiles the rest of the enclosing scope. name must be a string literal.
+#define LIZUAL_PROFILE_SCOPE(name) \
+  ProfileScope LIZUAL_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define LIZUAL_PROFILE_FUNCTION() LIZUAL_PROFILE_SCOPE(__func__)
+#else
+#define LIZUAL_PROFILE_SCOPE(name) ((void)0)
+#define LIZUAL_PROFILE_FUNCTION() ((void)0)
+#endif
@@ -0,0 +1,130 @@
+#include "ProfilerWindow.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <string_view>
+
+#include "Hash.h"
+
+namespace {
+constexpr float kFrameGraphHeight = 60.0f;
+
+// Stable pastel color per zone name
+ImU32 GetZoneColor(const char* name) {
+  const uint64_t hash = HashFnv1a64(name);
+  return IM_COL32(
+    128 + (hash & 0x7f),
+    128 + ((hash >> 8) & 0x7f),
+    128 + ((hash >> 16) & 0x7f),
+    255
+  );
+}
+}  // namespace
+
+void ProfilerWindow::Draw() {
+  if (!open) { return; }
+
+  ImGui::SetNextWindowSize(ImVec2(720, 360), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler", &open)) {
+    ImGui::End();
+    return;
+  }
+
+  if (!paused_) {
+    frames_.clear();
+    Profiler::GetFrames(frames_);
+  }
+  if (frames_.empty()) {
+    ImGui::TextDisabled("Waiting for frames");
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Checkbox("Pause", &paused_);
+  ImGui::SameLine();
+  const int frameCount = static_cast<int>(frames_.size());
+  frameOffset_ = std::clamp(frameOffset_, -(frameCount - 1), 0);
+  ImGui::SliderInt("Frame", &frameOffset_, -(frameCount - 1), 0);
+
+  frameTimesMs_.clear();
+  for (const Profiler::Frame& frame : frames_) {
+    frameTimesMs_.push_back((frame.endNs - frame.startNs) / 1e6f);
+  }
+  const Profiler::Frame& frame = frames_[frameCount - 1 + frameOffset_];
+  char overlay[64];
+  std::snprintf(
+    overlay,
+    sizeof(overlay),
+    "selected: %.3f ms",
+    (frame.endNs - frame.startNs) / 1e6f
+  );
+  ImGui::PlotHistogram(
+    "##FrameTimes",
+    frameTimesMs_.data(),
+    frameCount,
+    0,
+    overlay,
+    0.0f,
+    FLT_MAX,
+    ImVec2(ImGui::GetContentRegionAvail().x, kFrameGraphHeight)
+  );
+
+  if (!paused_ || threads_.empty()) {
+    threads_.clear();
+    Profiler::CollectEvents(frame.startNs, frame.endNs, threads_);
+  }
+  DrawFlameGraph(frame);
+
+  ImGui::End();
+}
+
+void ProfilerWindow::DrawFlameGraph(const Profiler::Frame& frame) {
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+  const float barHeight = ImGui::GetTextLineHeightWithSpacing();
+  const uint64_t frameNs = std::max<uint64_t>(frame.endNs - frame.startNs, 1);
+  const double pixelsPerNs = width / static_cast<double>(frameNs);
+
+  for (const ProfileThreadEvents& thread : threads_) {
+    ImGui::TextDisabled("%s", thread.threadName.c_str());
+    uint32_t maxDepth = 0;
+    for (const ProfileEvent& event : thread.events) {
+      maxDepth = std::max(maxDepth, event.depth);
+    }
+
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    for (const ProfileEvent& event : thread.events) {
+      // Zones that straddle the frame boundaries are clipped to the frame
+      const uint64_t startNs = std::max(event.startNs, frame.startNs);
+      const uint64_t endNs = std::min(event.endNs, frame.endNs);
+      const float x0 =
+        origin.x + static_cast<float>((startNs - frame.startNs) * pixelsPerNs);
+      const float x1 = std::max(
+        origin.x + static_cast<float>((endNs - frame.startNs) * pixelsPerNs),
+        x0 + 1.0f
+      );
+      const float y0 = origin.y + event.depth * barHeight;
+      const ImVec2 min(x0, y0);
+      const ImVec2 max(x1, y0 + barHeight - 1.0f);
+      drawList->AddRectFilled(min, max, GetZoneColor(event.name));
+
+      // Label the bar if at least a few characters fit
+      if (x1 - x0 > ImGui::CalcTextSize("...").x) {
+        drawList->PushClipRect(min, max, true);
+        drawList->AddText(
+          ImVec2(x0 + 2.0f, y0), IM_COL32(0, 0, 0, 255), event.name
+        );
+        drawList->PopClipRect();
+      }
+      if (ImGui::IsMouseHoveringRect(min, max)) {
+        ImGui::SetTooltip(
+          "%s\n%.3f ms", event.name, (event.endNs - event.startNs) / 1e6
+        );
+      }
+    }
+    ImGui::Dummy(ImVec2(width, (maxDepth + 1) * barHeight));
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "Profiler.h"
+
+// ImGui window with a flame graph of one of the last Profiler::kFrameHistory
+// frames: a bar per zone, one lane per thread, stacked by nesting depth.
+class ProfilerWindow {
+ public:
+  // Draws the window if open. Call between ImGui::NewFrame and ImGui::Render.
+  void Draw();
+
+  bool open = false;
+
+ private:
+  void DrawFlameGraph(const Profiler::Frame& frame);
+
+  // Frames and events stay frozen while paused
+  bool paused_ = false;
+  // Selected frame relative to the newest, so 0 follows the latest frame
+  int frameOffset_ = 0;
+  std::vector<Profiler::Frame> frames_;
+  std::vector<float> frameTimesMs_;
+  std::vector<ProfileThreadEvents> threads_;
+};
@@ -0,0 +1,150 @@
+#include "ProgramBinaryCache.h"
+
+#include <SDL3/SDL_log.h>
+
+#include <format>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <vector>
+
+#include "Hash.h"
+
+namespace {
+constexpr uint32_t kMagic = 0x4250'5a4c;  // "LZPB"
+constexpr uint32_t kVersion = 1;
+
+struct EntryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t binaryFormat;
+  uint32_t binaryLength;
+};
+
+std::string_view GetGLString(GLenum name) {
+  const GLubyte* value = glGetString(name);
+  if (value == nullptr) { return {}; }
+  return reinterpret_cast<const char*>(value);
+}
+}  // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path directory)
+    : directory_(std::move(directory)) {
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  supported_ = numFormats > 0;
+
+  uint64_t key = ExtendKey(kFnv1a64Seed, GetGLString(GL_VENDOR));
+  key = ExtendKey(key, GetGLString(GL_RENDERER));
+  key = ExtendKey(key, GetGLString(GL_VERSION));
+  driverKey_ = key;
+
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    SDL_Log(
+      "ProgramBinaryCache: Failed to create directory %s: %s",
+      directory_.string().c_str(),
+      error.message().c_str()
+    );
+    supported_ = false;
+  }
+}
+
+uint64_t ProgramBinaryCache::ExtendKey(uint64_t key, std::string_view input) {
+  // Hash the length too so ("ab", "c") and ("a", "bc") differ
+  key = HashFnv1a64(std::to_string(input.size()), key);
+  return HashFnv1a64(input, key);
+}
+
+std::filesystem::path ProgramBinaryCache::GetEntryPath(uint64_t key) const {
+  return directory_ / std::format("{:016x}.bin", key);
+}
+
+bool ProgramBinaryCache::Load(uint64_t key, GLuint program) const {
+  if (!supported_) { return false; }
+
+  const std::filesystem::path path = GetEntryPath(key);
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) { return false; }
+
+  EntryHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != kMagic || header.version != kVersion ||
+      header.key != key) {
+    return false;
+  }
+  // Store writes the header and then exactly the binary, so a length that
+  // disagrees with the file size means a damaged entry. Checked before
+  // allocating, as a damaged length can be anything up to 4 GB.
+  std::error_code error;
+  const uintmax_t fileSize = std::filesystem::file_size(path, error);
+  if (error || fileSize != sizeof(header) + uintmax_t{header.binaryLength} ||
+      header.binaryLength >
+        static_cast<uint32_t>(std::numeric_limits<GLsizei>::max())) {
+    return false;
+  }
+  std::vector<char> binary(header.binaryLength);
+  if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+    return false;
+  }
+
+  // The driver rejects binaries from other versions or hardware by failing the
+  // link, in which case the caller falls back to compiling from source.
+  glProgramBinary(
+    program,
+    header.binaryFormat,
+    binary.data(),
+    static_cast<GLsizei>(binary.size())
+  );
+  GLint success = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  return success == GL_TRUE;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, GLuint program) const {
+  if (!supported_) { return; }
+
+  GLint binaryLength = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+  if (binaryLength <= 0) { return; }
+
+  std::vector<char> binary(binaryLength);
+  GLenum binaryFormat = GL_NONE;
+  glGetProgramBinary(
+    program, binaryLength, &binaryLength, &binaryFormat, binary.data()
+  );
+
+  EntryHeader header{
+    kMagic,
+    kVersion,
+    key,
+    binaryFormat,
+    static_cast<uint32_t>(binaryLength),
+  };
+  // Write to a temporary file first so a crash never leaves a torn entry
+  const std::filesystem::path path = GetEntryPath(key);
+  std::filesystem::path tempPath = path;
+  tempPath += ".tmp";
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), binaryLength);
+    if (!file) {
+      SDL_Log(
+        "ProgramBinaryCache: Failed to write %s", tempPath.string().c_str()
+      );
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error) {
+    SDL_Log(
+      "ProgramBinaryCache: Failed to store %s: %s",
+      path.string().c_str(),
+      error.message().c_str()
+    );
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Persists linked program binaries (glGetProgramBinary) on disk so later
+// launches can skip compiling and linking GLSL.
+//
+// Entries are keyed by a hash of the program sources and the driver's vendor,
+// renderer and version strings, so a driver update invalidates them. Must be
+// constructed with a current GL context.
+class ProgramBinaryCache {
+ public:
+  explicit ProgramBinaryCache(std::filesystem::path directory);
+
+  // Whether the driver supports any program binary format. If not, Load always
+  // misses and Store does nothing.
+  bool IsSupported() const { return supported_; }
+
+  // Folds a piece of program input (a stage source, a define) into a key.
+  // Start from ProgramBinaryCache::BaseKey().
+  static uint64_t ExtendKey(uint64_t key, std::string_view input);
+  uint64_t BaseKey() const { return driverKey_; }
+
+  // Loads the binary stored under key into program. Returns false, leaving
+  // program unlinked, if there is no entry or the driver rejects it.
+  bool Load(uint64_t key, GLuint program) const;
+  // Stores the binary of a linked program under key. Failures are logged and
+  // otherwise ignored.
+  void Store(uint64_t key, GLuint program) const;
+
+ private:
+  std::filesystem::path GetEntryPath(uint64_t key) const;
+
+  std::filesystem::path directory_;
+  uint64_t driverKey_;
+  bool supported_;
+};
@@ -0,0 +1,72 @@
+#include "RenderPacket.h"
+
+#include <imgui_impl_opengl3.h>
+
+#include <cstring>
+
+namespace {
+// Copies the elements without freeing the destination's buffer first, which
+// ImVector's assignment does
+template <typename T>
+void CopyElements(const ImVector<T>& source, ImVector<T>& destination) {
+  destination.resize(source.Size);
+  if (source.Size > 0) {
+    std::memcpy(destination.Data, source.Data, source.size_in_bytes());
+  }
+}
+}  // namespace
+
+UiDrawData::~UiDrawData() {
+  for (ImDrawList* list : lists_) { IM_DELETE(list); }
+}
+
+void UiDrawData::Copy(const ImDrawData& drawData) {
+  listCount_ = static_cast<size_t>(drawData.CmdListsCount);
+  while (lists_.size() < listCount_) {
+    lists_.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+  }
+  for (size_t i = 0; i < listCount_; ++i) {
+    const ImDrawList& source = *drawData.CmdLists[static_cast<int>(i)];
+    ImDrawList& copy = *lists_[i];
+    CopyElements(source.CmdBuffer, copy.CmdBuffer);
+    CopyElements(source.IdxBuffer, copy.IdxBuffer);
+    CopyElements(source.VtxBuffer, copy.VtxBuffer);
+    copy.Flags = source.Flags;
+  }
+  displayPos_ = drawData.DisplayPos;
+  displaySize_ = drawData.DisplaySize;
+  framebufferScale_ = drawData.FramebufferScale;
+#if IMGUI_VERSION_NUM >= 19200
+  // Only hand the textures over when the backend has work to do on them
+  textures_ = nullptr;
+  if (drawData.Textures != nullptr) {
+    for (const ImTextureData* texture : *drawData.Textures) {
+      if (texture->Status != ImTextureStatus_OK) {
+        textures_ = drawData.Textures;
+        break;
+      }
+    }
+  }
+#endif
+}
+
+void UiDrawData::Render() {
+  drawData_.Clear();
+  for (size_t i = 0; i < listCount_; ++i) { drawData_.AddDrawList(lists_[i]); }
+  drawData_.Valid = true;
+  drawData_.DisplayPos = displayPos_;
+  drawData_.DisplaySize = displaySize_;
+  drawData_.FramebufferScale = framebufferScale_;
+#if IMGUI_VERSION_NUM >= 19200
+  drawData_.Textures = textures_;
+#endif
+  ImGui_ImplOpenGL3_RenderDrawData(&drawData_);
+}
+
+bool UiDrawData::HasTextureUpdates() const {
+#if IMGUI_VERSION_NUM >= 19200
+  return textures_ != nullptr;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <imgui.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DrawCommands.h"
+#include "GLStats.h"
+#include "GpuTimer.h"
+
+// Copy of the UI's draw lists for one frame, so the UI can be built for the
+// next frame while this one is rendered. The copies are reused from frame to
+// frame, keeping their buffers.
+class UiDrawData {
+ public:
+  UiDrawData() = default;
+  ~UiDrawData();
+  UiDrawData(const UiDrawData&) = delete;
+  UiDrawData& operator=(const UiDrawData&) = delete;
+
+  // Copies the output of ImGui::Render
+  void Copy(const ImDrawData& drawData);
+  // Draws the copy with the OpenGL backend
+  void Render();
+
+  // Whether the backend has font textures to create or update while drawing
+  // this copy. The UI must not build another frame until it has, as those
+  // textures are shared with it.
+  bool HasTextureUpdates() const;
+
+ private:
+  std::vector<ImDrawList*> lists_;
+  size_t listCount_ = 0;
+  ImVec2 displayPos_;
+  ImVec2 displaySize_;
+  ImVec2 framebufferScale_;
+#if IMGUI_VERSION_NUM >= 19200
+  ImVector<ImTextureData*>* textures_ = nullptr;
+#endif
+  ImDrawData drawData_;
+};
+
+// What the render thread reports back about a frame it rendered
+struct RenderFeedback {
+  GpuTimer::Results gpu;
+  size_t textureResidentBytes = 0;
+  size_t textureResidencyBudget = 0;
+  size_t texturesLoading = 0;
+  // CPU time the render thread spent on the frame
+  double renderCpuMs = 0.0;
+  // GL work the frame issued, apart from the UI's
+  GLStats::Frame glStats;
+};
+
+// Everything the render thread needs to draw one frame, built by the
+// simulation. Once submitted, the render thread only reads it, apart from
+// writing feedback.
+struct RenderPacket {
+  float timeSeconds = 0.0f;
+  glm::mat4 view{1.0f};
+  glm::mat4 projection{1.0f};
+  int viewportWidth = 0;
+  int viewportHeight = 0;
+  // Per-instance data in sorted draw command order
+  std::vector<glm::mat4> modelMatrices;
+  std::vector<uint32_t> instanceTextureLayers;
+  std::vector<DrawCall> drawCalls;
+  // Largest size on screen of the objects of each draw call, in pixels
+  // across, for streaming their textures
+  std::vector<float> drawScreenSizes;
+  UiDrawData ui;
+  RenderFeedback feedback;
+};
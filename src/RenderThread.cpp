@@ -0,0 +1,96 @@
+#include "RenderThread.h"
+
+#include <SDL3/SDL_log.h>
+
+#include "Profiler.h"
+
+RenderThread::RenderThread(
+  SDL_Window* window,
+  SDL_GLContext context,
+  unsigned framesInFlight,
+  RenderFunction render
+)
+    : window_(window),
+      context_(context),
+      framesInFlight_(framesInFlight),
+      render_(std::move(render)),
+      // One more slot for the stop signal
+      submitted_(framesInFlight + 1),
+      rendered_(framesInFlight) {
+  packets_.push_back(std::make_unique<RenderPacket>());
+  if (framesInFlight_ == 0) { return; }
+
+  for (unsigned i = 1; i < framesInFlight_; ++i) {
+    packets_.push_back(std::make_unique<RenderPacket>());
+  }
+  for (const std::unique_ptr<RenderPacket>& packet : packets_) {
+    rendered_.Push(packet.get());
+  }
+  // A context can only be current on one thread
+  SDL_GL_MakeCurrent(window_, nullptr);
+  thread_ = std::thread(&RenderThread::ThreadMain, this);
+}
+
+RenderThread::~RenderThread() { Stop(); }
+
+RenderPacket& RenderThread::BeginPacket() {
+  if (framesInFlight_ == 0) {
+    current_ = packets_.front().get();
+  } else {
+    LIZUAL_PROFILE_SCOPE("Wait for render thread");
+    current_ = rendered_.Pop();
+  }
+  return *current_;
+}
+
+void RenderThread::Submit() {
+  ++submittedCount_;
+  if (framesInFlight_ == 0) {
+    render_(*current_);
+    renderedCount_.store(submittedCount_, std::memory_order_relaxed);
+  } else {
+    submitted_.Push(current_);
+  }
+  current_ = nullptr;
+}
+
+void RenderThread::Finish() {
+  LIZUAL_PROFILE_SCOPE("Wait for render thread");
+  for (;;) {
+    const uint64_t rendered = renderedCount_.load(std::memory_order_acquire);
+    if (rendered == submittedCount_) { return; }
+    renderedCount_.wait(rendered, std::memory_order_acquire);
+  }
+}
+
+bool RenderThread::Stop() {
+  if (!thread_.joinable()) { return hasContext_; }
+  submitted_.Push(nullptr);
+  thread_.join();
+  hasContext_ = SDL_GL_MakeCurrent(window_, context_);
+  if (!hasContext_) {
+    SDL_Log(
+      "RenderThread: Failed to take the context back: %s", SDL_GetError()
+    );
+  }
+  return hasContext_;
+}
+
+void RenderThread::ThreadMain() {
+  Profiler::SetThreadName("Render");
+  // Every GL call without a current context is undefined
+  const bool hasContext = SDL_GL_MakeCurrent(window_, context_);
+  if (!hasContext) {
+    SDL_Log(
+      "RenderThread: Failed to make the context current: %s", SDL_GetError()
+    );
+    failed_.store(true, std::memory_order_release);
+  }
+  while (RenderPacket* packet = submitted_.Pop()) {
+    if (hasContext) { render_(*packet); }
+    renderedCount_.fetch_add(1, std::memory_order_release);
+    renderedCount_.notify_all();
+    rendered_.Push(packet);
+  }
+  if (hasContext) { SDL_GL_MakeCurrent(window_, nullptr); }
+}
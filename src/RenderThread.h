@@ -0,0 +1,82 @@
+#pragma once
+
+#include <SDL3/SDL_video.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "RenderPacket.h"
+#include "SpscQueue.h"
+
+// Thread that owns the GL context and renders the packets the simulation
+// submits, so building a frame overlaps with the GL work of the frames
+// before it. There are framesInFlight packets: the simulation fills one while
+// the render thread draws the others, and waits for one to come back when all
+// are in flight. Packets go back and forth through lock-free single-producer
+// single-consumer queues.
+//
+// With 0 frames in flight there is no thread, and packets are rendered on the
+// calling thread as they are submitted.
+class RenderThread {
+ public:
+  // Draws a packet and swaps, with the context current. May write the
+  // packet's feedback.
+  using RenderFunction = std::function<void(RenderPacket& packet)>;
+
+  // Takes the context over from the calling thread, which must have it
+  // current
+  RenderThread(
+    SDL_Window* window,
+    SDL_GLContext context,
+    unsigned framesInFlight,
+    RenderFunction render
+  );
+  // Stops the thread if Stop wasn't called
+  ~RenderThread();
+  RenderThread(const RenderThread&) = delete;
+  RenderThread& operator=(const RenderThread&) = delete;
+
+  // The packet to fill for the next frame, waiting while all are in flight.
+  // Its feedback is from the last time it was rendered, if it has been.
+  RenderPacket& BeginPacket();
+  // Queues the packet from BeginPacket for rendering
+  void Submit();
+  // Waits until every submitted packet is rendered
+  void Finish();
+  // Renders the packets submitted so far, stops the thread and makes the
+  // context current on the calling thread again. Returns false if it couldn't,
+  // in which case the calling thread must make no GL calls. Nothing may be
+  // submitted after.
+  bool Stop();
+
+  // Whether the render thread couldn't make the context current. It renders
+  // nothing then, handing packets straight back so the simulation never
+  // blocks on it, and the app should quit.
+  bool HasFailed() const { return failed_.load(std::memory_order_acquire); }
+
+  unsigned GetFramesInFlight() const { return framesInFlight_; }
+
+ private:
+  void ThreadMain();
+
+  SDL_Window* window_;
+  SDL_GLContext context_;
+  unsigned framesInFlight_;
+  RenderFunction render_;
+  std::vector<std::unique_ptr<RenderPacket>> packets_;
+  RenderPacket* current_ = nullptr;
+  // Packets to render, then null to stop
+  SpscQueue<RenderPacket*> submitted_;
+  // Rendered packets, back to the simulation
+  SpscQueue<RenderPacket*> rendered_;
+  uint64_t submittedCount_ = 0;
+  std::atomic<uint64_t> renderedCount_ = 0;
+  std::atomic<bool> failed_ = false;
+  // Whether the calling thread has the context, false after a failed Stop
+  bool hasContext_ = true;
+  std::thread thread_;
+};
@@ -0,0 +1,317 @@
+#include "Scene.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace {
+// clang-format off
+constexpr glm::vec3 kClassicPositions[] = {
+  glm::vec3( 0.0f,  0.0f,  0.0f),
+  glm::vec3( 2.0f,  5.0f, -15.0f),
+  glm::vec3(-1.5f, -2.2f, -2.5f),
+  glm::vec3(-3.8f, -2.0f, -12.3f),
+  glm::vec3( 2.4f, -0.4f, -3.5f),
+  glm::vec3(-1.7f,  3.0f, -7.5f),
+  glm::vec3( 1.3f, -2.0f, -2.5f),
+  glm::vec3( 1.5f,  2.0f, -2.5f),
+  glm::vec3( 1.5f,  0.2f, -1.5f),
+  glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+// clang-format on
+// The classic cubes are spread around this point
+constexpr glm::vec3 kClassicCenter{0.0f, 0.0f, -5.0f};
+
+// Generated objects per cluster of the clustered distribution
+constexpr uint32_t kObjectsPerCluster = 2000;
+constexpr float kMinScale = 0.5f;
+constexpr float kMaxScale = 1.5f;
+constexpr float kMinAngularSpeed = 0.5f;
+constexpr float kMaxAngularSpeed = 2.0f;
+constexpr float kBobAmplitude = 0.5f;
+// Animated objects per job at least; fewer aren't worth the scheduling
+constexpr size_t kAnimateRangeSize = 4096;
+
+constexpr struct {
+  SceneDistribution distribution;
+  const char* name;
+} kDistributionNames[] = {
+  {SceneDistribution::kClassic, "classic"},
+  {SceneDistribution::kUniform, "uniform"},
+  {SceneDistribution::kClustered, "clustered"},
+  {SceneDistribution::kGrid, "grid"},
+};
+
+// SplitMix64. Unlike the <random> distributions, its output is specified
+// exactly, so a seed gives the same sequence with every standard library.
+class Random {
+ public:
+  explicit Random(uint64_t seed) : state_(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [0, 1)
+  float NextFloat() {
+    return static_cast<float>(Next() >> 40) * (1.0f / (1 << 24));
+  }
+
+  float NextFloat(float min, float max) {
+    return min + (max - min) * NextFloat();
+  }
+
+  // Uniform in [0, count)
+  uint32_t NextBelow(uint32_t count) {
+    return static_cast<uint32_t>(((Next() >> 32) * count) >> 32);
+  }
+
+  // Standard normal, with the Box-Muller transform
+  float NextNormal() {
+    const float u1 = 1.0f - NextFloat();
+    const float u2 = NextFloat();
+    return std::sqrt(-2.0f * std::log(u1)) *
+           std::cos(glm::two_pi<float>() * u2);
+  }
+
+  glm::vec3 NextInCube(float halfSize) {
+    const float x = NextFloat(-halfSize, halfSize);
+    const float y = NextFloat(-halfSize, halfSize);
+    const float z = NextFloat(-halfSize, halfSize);
+    return {x, y, z};
+  }
+
+  glm::vec3 NextAxis() {
+    while (true) {
+      const glm::vec3 axis = NextInCube(1.0f);
+      const float lengthSquared = glm::dot(axis, axis);
+      if (lengthSquared > 0.01f && lengthSquared <= 1.0f) {
+        return axis / std::sqrt(lengthSquared);
+      }
+    }
+  }
+
+ private:
+  uint64_t state_;
+};
+
+// Half size of a box that encloses an object of the given scale at any
+// rotation: half the diagonal of the scaled unit cube
+glm::vec3 GetRotationBoundsHalfExtent(const glm::vec3& scale) {
+  return glm::vec3(0.5f * glm::length(scale));
+}
+
+float WrapAngle(float radians) {
+  return glm::mod(radians, glm::two_pi<float>());
+}
+}  // namespace
+
+std::optional<SceneDistribution> ParseSceneDistribution(std::string_view name) {
+  for (const auto& entry : kDistributionNames) {
+    if (name == entry.name) { return entry.distribution; }
+  }
+  return std::nullopt;
+}
+
+const char* GetSceneDistributionName(SceneDistribution distribution) {
+  for (const auto& entry : kDistributionNames) {
+    if (entry.distribution == distribution) { return entry.name; }
+  }
+  return "unknown";
+}
+
+Scene Scene::Generate(const SceneSettings& settings) {
+  LIZUAL_PROFILE_SCOPE("Scene::Generate");
+  Scene scene;
+  scene.settings_ = settings;
+
+  if (settings.distribution == SceneDistribution::kClassic) {
+    // The original cubes: one mesh and texture, all spinning in place
+    const size_t count = std::size(kClassicPositions);
+    scene.settings_.objectCount = static_cast<uint32_t>(count);
+    scene.settings_.animatedFraction = 1.0f;
+    scene.settings_.meshCount = 1;
+    scene.settings_.textureCount = 1;
+    scene.center_ = kClassicCenter;
+    scene.transforms_.Resize(count);
+    scene.bounds_.resize(count);
+    scene.meshIds_.assign(count, 0);
+    scene.textureIds_.assign(count, 0);
+    const glm::vec3 halfExtent = GetRotationBoundsHalfExtent(glm::vec3(1.0f));
+    for (size_t i = 0; i < count; ++i) {
+      const glm::vec3& position = kClassicPositions[i];
+      const float angle = glm::radians(20.0f * i);
+      scene.transforms_.Set(i, position, glm::vec3(1.0f, 0.3f, 0.5f), angle);
+      scene.bounds_[i] = {position - halfExtent, position + halfExtent};
+      scene.animated_.push_back(
+        {static_cast<uint32_t>(i),
+         angle,
+         glm::radians(50.0f),
+         position.y,
+         0.0f,
+         0.0f}
+      );
+    }
+    return scene;
+  }
+
+  // Mesh and texture ids are 16-bit, as are their fields in draw sort keys
+  constexpr uint32_t kMaxGroupIds = std::numeric_limits<uint16_t>::max() + 1;
+  SceneSettings& clamped = scene.settings_;
+  clamped.objectCount = std::max(clamped.objectCount, 1u);
+  clamped.animatedFraction = std::clamp(clamped.animatedFraction, 0.0f, 1.0f);
+  clamped.meshCount = std::clamp(clamped.meshCount, 1u, kMaxGroupIds);
+  clamped.textureCount = std::clamp(clamped.textureCount, 1u, kMaxGroupIds);
+
+  const uint32_t count = clamped.objectCount;
+  const float halfSize =
+    0.5f * kObjectSpacing * std::cbrt(static_cast<float>(count));
+  Random random(clamped.seed);
+
+  // Clustered: centers are drawn first so they don't depend on the count of
+  // objects drawn before them
+  std::vector<glm::vec3> clusterCenters;
+  float clusterSigma = 0.0f;
+  if (clamped.distribution == SceneDistribution::kClustered) {
+    clusterCenters.resize(std::max(count / kObjectsPerCluster, 1u));
+    for (glm::vec3& center : clusterCenters) {
+      center = random.NextInCube(halfSize);
+    }
+    clusterSigma =
+      0.25f * kObjectSpacing *
+      std::cbrt(static_cast<float>(std::min(count, kObjectsPerCluster)));
+  }
+  // Grid: the smallest cube of cells that holds every object
+  uint32_t gridSide =
+    std::max(static_cast<uint32_t>(std::cbrt(static_cast<double>(count))), 1u);
+  while (static_cast<uint64_t>(gridSide) * gridSide * gridSide < count) {
+    ++gridSide;
+  }
+  const float gridOrigin = -0.5f * kObjectSpacing * (gridSide - 1);
+
+  scene.transforms_.Resize(count);
+  scene.bounds_.resize(count);
+  scene.meshIds_.resize(count);
+  scene.textureIds_.resize(count);
+  scene.animated_.reserve(
+    static_cast<size_t>(count * clamped.animatedFraction) + 1
+  );
+  for (uint32_t i = 0; i < count; ++i) {
+    glm::vec3 position;
+    switch (clamped.distribution) {
+      case SceneDistribution::kClustered: {
+        const glm::vec3& center =
+          clusterCenters[random.NextBelow(
+            static_cast<uint32_t>(clusterCenters.size())
+          )];
+        const float x = random.NextNormal();
+        const float y = random.NextNormal();
+        const float z = random.NextNormal();
+        position = center + clusterSigma * glm::vec3(x, y, z);
+        break;
+      }
+      case SceneDistribution::kGrid:
+        position = glm::vec3(
+          gridOrigin + kObjectSpacing * (i % gridSide),
+          gridOrigin + kObjectSpacing * (i / gridSide % gridSide),
+          gridOrigin + kObjectSpacing * (i / gridSide / gridSide)
+        );
+        break;
+      default:
+        position = random.NextInCube(halfSize);
+        break;
+    }
+
+    const float scaleX = random.NextFloat(kMinScale, kMaxScale);
+    const float scaleY = random.NextFloat(kMinScale, kMaxScale);
+    const float scaleZ = random.NextFloat(kMinScale, kMaxScale);
+    const glm::vec3 scale(scaleX, scaleY, scaleZ);
+    const glm::vec3 axis = random.NextAxis();
+    const float angle = random.NextFloat(0.0f, glm::two_pi<float>());
+    scene.transforms_.Set(i, position, axis, angle, scale);
+    const glm::vec3 halfExtent = GetRotationBoundsHalfExtent(scale);
+    scene.bounds_[i] = {position - halfExtent, position + halfExtent};
+    scene.meshIds_[i] =
+      static_cast<uint16_t>(random.NextBelow(clamped.meshCount));
+    scene.textureIds_[i] =
+      static_cast<uint16_t>(random.NextBelow(clamped.textureCount));
+
+    // Always draw the same number of values so the rest of the scene does not
+    // depend on the animated fraction
+    const float animatedRoll = random.NextFloat();
+    const float speed = random.NextFloat(kMinAngularSpeed, kMaxAngularSpeed);
+    const float phase = random.NextFloat(0.0f, glm::two_pi<float>());
+    if (animatedRoll < clamped.animatedFraction) {
+      scene.animated_.push_back(
+        {i,
+         angle,
+         (random.Next() & 1) != 0 ? speed : -speed,
+         position.y,
+         kBobAmplitude,
+         phase}
+      );
+    } else {
+      random.Next();
+    }
+  }
+  scene.moves_ = !scene.animated_.empty();
+  return scene;
+}
+
+bool Scene::Animate(float timeSeconds, JobSystem* jobs) {
+  LIZUAL_PROFILE_SCOPE("Scene::Animate");
+  if (jobs == nullptr) {
+    AnimateRange(timeSeconds, 0, animated_.size());
+  } else {
+    jobs->ParallelFor(
+      animated_.size(), kAnimateRangeSize, [&](size_t begin, size_t end) {
+        AnimateRange(timeSeconds, begin, end);
+      }
+    );
+  }
+  return moves_;
+}
+
+void Scene::AnimateRange(float timeSeconds, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    const AnimatedObject& object = animated_[i];
+    // Wrap to one turn to keep the batch kernels' sine/cosine accurate
+    transforms_.angle[object.index] =
+      WrapAngle(object.baseAngle + object.angularSpeed * timeSeconds);
+    if (!moves_) { continue; }
+
+    const float y =
+      object.baseY +
+      object.bobAmplitude *
+        std::sin(object.angularSpeed * timeSeconds + object.bobPhase);
+    AABB& bounds = bounds_[object.index];
+    const float halfHeight = 0.5f * (bounds.max.y - bounds.min.y);
+    transforms_.positionY[object.index] = y;
+    bounds.min.y = y - halfHeight;
+    bounds.max.y = y + halfHeight;
+  }
+}
+
+size_t Scene::GetMemoryUsage() const {
+  const TransformBatch& t = transforms_;
+  const size_t transformFloats =
+    t.positionX.capacity() + t.positionY.capacity() + t.positionZ.capacity() +
+    t.axisX.capacity() + t.axisY.capacity() + t.axisZ.capacity() +
+    t.angle.capacity() + t.scaleX.capacity() + t.scaleY.capacity() +
+    t.scaleZ.capacity();
+  return transformFloats * sizeof(float) + bounds_.capacity() * sizeof(AABB) +
+         meshIds_.capacity() * sizeof(uint16_t) +
+         textureIds_.capacity() * sizeof(uint16_t) +
+         animated_.capacity() * sizeof(AnimatedObject);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "BVH.h"
+#include "TransformBatch.h"
+
+class JobSystem;
+
+enum class SceneDistribution {
+  // The ten hand-placed cubes, ignoring every other setting
+  kClassic,
+  // Objects scattered evenly through a cube
+  kUniform,
+  // Gaussian clusters at random centers, denser than kUniform inside them
+  kClustered,
+  // A regular lattice
+  kGrid,
+};
+
+std::optional<SceneDistribution> ParseSceneDistribution(std::string_view name);
+const char* GetSceneDistributionName(SceneDistribution distribution);
+
+struct SceneSettings {
+  SceneDistribution distribution;
+  uint32_t objectCount;
+  // Fraction of objects that spin and bob every frame, in [0, 1]
+  float animatedFraction;
+  // Number of distinct meshes and textures objects are spread over
+  uint32_t meshCount;
+  uint32_t textureCount;
+  uint32_t seed;
+};
+
+// The objects to render: transforms, world bounds, and the mesh and texture
+// of each. Generated scenes are deterministic for a given SceneSettings and
+// build, so benchmark runs at different sizes render comparable frames. The
+// random sequence is the same everywhere, but positions go through libm
+// functions such as std::log and std::cbrt whose rounding differs between
+// implementations, so other platforms can place objects slightly apart.
+//
+// Generated objects are spaced so the density stays the same at any object
+// count: the scene grows with the cube root of the count instead of getting
+// more crowded, and the number of visible objects levels off.
+class Scene {
+ public:
+  // Average distance between generated objects
+  static constexpr float kObjectSpacing = 3.0f;
+
+  static Scene Generate(const SceneSettings& settings);
+
+  size_t Size() const { return transforms_.Size(); }
+  const SceneSettings& GetSettings() const { return settings_; }
+  // Point the objects are spread around
+  const glm::vec3& GetCenter() const { return center_; }
+
+  const TransformBatch& GetTransforms() const { return transforms_; }
+  // Bounds that enclose each object at any rotation
+  std::span<const AABB> GetBounds() const { return bounds_; }
+  std::span<const uint16_t> GetMeshIds() const { return meshIds_; }
+  std::span<const uint16_t> GetTextureIds() const { return textureIds_; }
+  size_t GetAnimatedCount() const { return animated_.size(); }
+
+  // Poses the animated objects for a time in seconds, spread over jobs if
+  // given. Returns true if any bounds moved, in which case hierarchies over
+  // GetBounds need a refit.
+  bool Animate(float timeSeconds, JobSystem* jobs = nullptr);
+
+  // Bytes of per-object data held by the scene
+  size_t GetMemoryUsage() const;
+
+ private:
+  struct AnimatedObject {
+    uint32_t index;
+    float baseAngle;
+    // Radians per second
+    float angularSpeed;
+    float baseY;
+    float bobAmplitude;
+    float bobPhase;
+  };
+
+  // Poses animated_[begin, end)
+  void AnimateRange(float timeSeconds, size_t begin, size_t end);
+
+  SceneSettings settings_{};
+  glm::vec3 center_{0.0f};
+  TransformBatch transforms_;
+  std::vector<AABB> bounds_;
+  std::vector<uint16_t> meshIds_;
+  std::vector<uint16_t> textureIds_;
+  std::vector<AnimatedObject> animated_;
+  // Whether any animated object bobs, so Animate moves bounds
+  bool moves_ = false;
+};
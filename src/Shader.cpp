@@ -3,30 +3,128 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <SDL3/SDL_log.h>
 
+#include <algorithm>
+#include <cstring>
+#include <format>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <string>
+
+#include "GLState.h"
+#include "GLStats.h"
+#include "Profiler.h"
+
+namespace {
+// Highest uniform location whose value is remembered
+constexpr GLint kMaxShadowedLocation = 1023;
+
+bool IsSamplerType(GLenum type) {
+  switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
 
 Shader::Shader(
   const std::filesystem::path& vertexShaderPath,
-  const std::filesystem::path& fragmentShaderPath
+  const std::filesystem::path& fragmentShaderPath,
+  const std::vector<std::string>& defines,
+  const ProgramBinaryCache* binaryCache
+)
+    : Shader(
+        ShaderSources{
+          ReadSource(vertexShaderPath), ReadSource(fragmentShaderPath)
+        },
+        defines,
+        binaryCache
+      ) {}
+
+Shader::Shader(
+  const ShaderSources& sources,
+  const std::vector<std::string>& defines,
+  const ProgramBinaryCache* binaryCache
+) {
+  LIZUAL_PROFILE_SCOPE("Shader::Shader");
+  // 1. Insert the defines into the vertex and fragment sources
+  const std::string vertexShaderSource =
+    InjectDefines(std::string(sources.vertex), defines);
+  const std::string fragmentShaderSource =
+    InjectDefines(std::string(sources.fragment), defines);
+
+  shaderProgram_ = glCreateProgram();
+
+  // 2. Try the binary cache first, keyed by the final sources (which include
+  // the defines) and the driver
+  uint64_t cacheKey = 0;
+  bool linked = false;
+  if (binaryCache != nullptr && binaryCache->IsSupported()) {
+    cacheKey = binaryCache->BaseKey();
+    cacheKey = ProgramBinaryCache::ExtendKey(cacheKey, vertexShaderSource);
+    cacheKey = ProgramBinaryCache::ExtendKey(cacheKey, fragmentShaderSource);
+    linked = binaryCache->Load(cacheKey, shaderProgram_);
+  }
+
+  // 3. Fall back to compiling from source
+  if (!linked) {
+    CompileAndLink(vertexShaderSource, fragmentShaderSource);
+    if (binaryCache != nullptr) {
+      binaryCache->Store(cacheKey, shaderProgram_);
+    }
+  }
+
+  ReflectUniforms();
+}
+
+Shader::~Shader() { GLState::DeleteProgram(shaderProgram_); }
+
+std::string Shader::ReadSource(const std::filesystem::path& path) {
+  std::ifstream file;
+  file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+  file.open(path);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+std::string Shader::InjectDefines(
+  std::string source, const std::vector<std::string>& defines
+) {
+  if (defines.empty()) { return source; }
+
+  std::string defineLines;
+  for (const std::string& define : defines) {
+    defineLines += std::format("#define {}\n", define);
+  }
+  // #version must stay the first directive, so insert after its line
+  size_t insertAt = 0;
+  if (source.starts_with("#version")) {
+    size_t lineEnd = source.find('\n');
+    insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+  }
+  source.insert(insertAt, defineLines);
+  return source;
+}
+
+void Shader::CompileAndLink(
+  const std::string& vertexShaderSource,
+  const std::string& fragmentShaderSource
 ) {
-  // 1. Retrieve the vertex and fragment source from the file paths
-  std::string vertexShaderSource;
-  std::string fragmentShaderSource;
-  std::ifstream vertexShaderFile;
-  std::ifstream fragmentShaderFile;
-  vertexShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  fragmentShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-  vertexShaderFile.open(vertexShaderPath);
-  fragmentShaderFile.open(fragmentShaderPath);
-  std::stringstream vertexShaderStream, fragmentShaderStream;
-  vertexShaderStream << vertexShaderFile.rdbuf();
-  fragmentShaderStream << fragmentShaderFile.rdbuf();
-  vertexShaderFile.close();
-  fragmentShaderFile.close();
-  vertexShaderSource = vertexShaderStream.str();
-  fragmentShaderSource = fragmentShaderStream.str();
   const char* vertexShaderSourceCString = vertexShaderSource.c_str();
   const char* fragmentShaderSourceCString = fragmentShaderSource.c_str();
 
@@ -60,8 +158,11 @@ Shader::Shader(
     );
   }
 
-  // Create the shader program
-  shaderProgram_ = glCreateProgram();
+  // Link the shader program. Ask the driver to keep the binary retrievable so
+  // it can be stored in the binary cache.
+  glProgramParameteri(
+    shaderProgram_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE
+  );
   glAttachShader(shaderProgram_, vertexShader);
   glAttachShader(shaderProgram_, fragmentShader);
   glLinkProgram(shaderProgram_);
@@ -75,50 +176,202 @@ Shader::Shader(
     );
   }
 
-  // Delete the shaders as they're linked into the program now
+  // Detach and delete the shaders as they're linked into the program now
+  glDetachShader(shaderProgram_, vertexShader);
+  glDetachShader(shaderProgram_, fragmentShader);
   glDeleteShader(vertexShader);
   glDeleteShader(fragmentShader);
 }
 
-void Shader::Use() { glUseProgram(shaderProgram_); }
+void Shader::Use() { GLState::UseProgram(shaderProgram_); }
+
+void Shader::ReflectUniforms() {
+  uniforms_.clear();
+  uniformValues_.clear();
+  GLint numUniforms = 0;
+  GLint maxNameLength = 0;
+  glGetProgramiv(shaderProgram_, GL_ACTIVE_UNIFORMS, &numUniforms);
+  glGetProgramiv(shaderProgram_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+  uniforms_.reserve(numUniforms);
+
+  std::string name(std::max(maxNameLength, 1), '\0');
+  for (GLint i = 0; i < numUniforms; ++i) {
+    GLsizei nameLength = 0;
+    GLint size = 0;
+    GLenum type = GL_NONE;
+    glGetActiveUniform(
+      shaderProgram_,
+      static_cast<GLuint>(i),
+      static_cast<GLsizei>(name.size()),
+      &nameLength,
+      &size,
+      &type,
+      name.data()
+    );
+    GLint location = glGetUniformLocation(shaderProgram_, name.c_str());
+    // Uniform block members have no location
+    if (location == -1) { continue; }
+
+    // Arrays are reported as "name[0]", but are looked up by their base name
+    std::string_view baseName(name.data(), nameLength);
+    if (baseName.ends_with("[0]")) { baseName.remove_suffix(3); }
+    uniforms_.push_back({HashUniformName(baseName), location, type});
+    if (location <= kMaxShadowedLocation) {
+      uniformValues_.resize(
+        std::max(uniformValues_.size(), static_cast<size_t>(location) + 1)
+      );
+    }
+  }
+
+  std::sort(
+    uniforms_.begin(),
+    uniforms_.end(),
+    [](const UniformInfo& a, const UniformInfo& b) { return a.hash < b.hash; }
+  );
+  auto collision = std::adjacent_find(
+    uniforms_.begin(),
+    uniforms_.end(),
+    [](const UniformInfo& a, const UniformInfo& b) { return a.hash == b.hash; }
+  );
+  if (collision != uniforms_.end()) {
+    throw std::runtime_error(std::format(
+      "GL: Uniform name hash collision at locations {} and {}",
+      collision->location,
+      (collision + 1)->location
+    ));
+  }
+}
+
+const Shader::UniformInfo* Shader::FindUniform(uint32_t hash) const {
+  auto it = std::lower_bound(
+    uniforms_.begin(),
+    uniforms_.end(),
+    hash,
+    [](const UniformInfo& info, uint32_t hash) { return info.hash < hash; }
+  );
+  if (it == uniforms_.end() || it->hash != hash) { return nullptr; }
+  return &*it;
+}
+
+GLint Shader::GetUniformLocation(UniformName name) const {
+  const UniformInfo* info = FindUniform(name.hash);
+  return info != nullptr ? info->location : -1;
+}
+
+GLint Shader::GetUniformLocation(UniformName name, GLenum expectedType) const {
+  const UniformInfo* info = FindUniform(name.hash);
+  if (info == nullptr) { return -1; }
+
+  bool typeMatches = info->type == expectedType;
+  if (expectedType == GL_INT) {
+    typeMatches = typeMatches || IsSamplerType(info->type);
+  } else if (expectedType == GL_BOOL) {
+    typeMatches = typeMatches || info->type == GL_INT;
+  }
+  if (!typeMatches) {
+    throw std::runtime_error(std::format(
+      "GL: Uniform {} has type 0x{:x}, expected 0x{:x}",
+      name.name,
+      info->type,
+      expectedType
+    ));
+  }
+  return info->location;
+}
+
+template <typename T>
+bool Shader::UpdateUniformValue(GLint location, const T& value) const {
+  static_assert(sizeof(T) <= sizeof(UniformValue::bytes));
+  // GL ignores sets of location -1 anyway
+  if (location < 0) {
+    GLStats::RecordUniformUpdate(false);
+    return false;
+  }
+  if (static_cast<size_t>(location) >= uniformValues_.size()) {
+    GLStats::RecordUniformUpdate(true);
+    return true;
+  }
+  UniformValue& shadow = uniformValues_[location];
+  if (shadow.known &&
+      std::memcmp(shadow.bytes.data(), &value, sizeof(T)) == 0) {
+    GLStats::RecordUniformUpdate(false);
+    return false;
+  }
+  std::memcpy(shadow.bytes.data(), &value, sizeof(T));
+  shadow.known = true;
+  GLStats::RecordUniformUpdate(true);
+  return true;
+}
+
+void Shader::Set(UniformHandle<bool> uniform, bool value) const {
+  SetIntAtLocation(uniform.location, static_cast<int>(value));
+}
+
+void Shader::Set(UniformHandle<int> uniform, int value) const {
+  SetIntAtLocation(uniform.location, value);
+}
+
+void Shader::Set(UniformHandle<float> uniform, float value) const {
+  if (UpdateUniformValue(uniform.location, value)) {
+    glProgramUniform1f(shaderProgram_, uniform.location, value);
+  }
+}
+
+void Shader::Set(UniformHandle<glm::vec4> uniform, const glm::vec4& value)
+  const {
+  if (UpdateUniformValue(uniform.location, value)) {
+    glProgramUniform4fv(
+      shaderProgram_, uniform.location, 1, glm::value_ptr(value)
+    );
+  }
+}
 
-void Shader::SetBool(const std::string& name, bool value) const {
-  glUniform1i(glGetUniformLocation(shaderProgram_, name.c_str()), (int)value);
+void Shader::Set(UniformHandle<glm::mat4> uniform, const glm::mat4& value)
+  const {
+  if (UpdateUniformValue(uniform.location, value)) {
+    glProgramUniformMatrix4fv(
+      shaderProgram_, uniform.location, 1, GL_FALSE, glm::value_ptr(value)
+    );
+  }
 }
 
-void Shader::SetInt(const std::string& name, int value) const {
-  glUniform1i(glGetUniformLocation(shaderProgram_, name.c_str()), value);
+void Shader::SetBool(UniformName name, bool value) const {
+  SetIntAtLocation(GetUniformLocation(name), static_cast<int>(value));
 }
 
-float Shader::GetFloat(const std::string& name) const {
-  GLint location = glGetUniformLocation(shaderProgram_, name.c_str());
+void Shader::SetInt(UniformName name, int value) const {
+  SetIntAtLocation(GetUniformLocation(name), value);
+}
+
+float Shader::GetFloat(UniformName name) const {
+  GLint location = GetUniformLocation(name);
   if (location == -1) {
-    throw std::runtime_error(std::format("GL: Uniform {} not found", name));
+    throw std::runtime_error(
+      std::format("GL: Uniform {} not found", name.name)
+    );
   }
   float value;
   glGetUniformfv(shaderProgram_, location, &value);
   return value;
 }
 
-void Shader::SetFloat(const std::string& name, float value) const {
-  glUniform1f(glGetUniformLocation(shaderProgram_, name.c_str()), value);
+void Shader::SetFloat(UniformName name, float value) const {
+  Set(UniformHandle<float>{GetUniformLocation(name)}, value);
 }
 
 void Shader::SetUniform4f(
-  const std::string& name, float v0, float v1, float v2, float v3
+  UniformName name, float v0, float v1, float v2, float v3
 ) const {
-  glUniform4f(
-    glGetUniformLocation(shaderProgram_, name.c_str()), v0, v1, v2, v3
-  );
+  Set(UniformHandle<glm::vec4>{GetUniformLocation(name)}, {v0, v1, v2, v3});
 }
 
-void Shader::SetUniformMatrix4fv(
-  const std::string& name, const glm::mat4& value
-) {
-  glUniformMatrix4fv(
-    glGetUniformLocation(shaderProgram_, name.c_str()),
-    1,
-    GL_FALSE,
-    glm::value_ptr(value)
-  );
+void Shader::SetUniformMatrix4fv(UniformName name, const glm::mat4& value)
+  const {
+  Set(UniformHandle<glm::mat4>{GetUniformLocation(name)}, value);
+}
+
+void Shader::SetIntAtLocation(GLint location, int value) const {
+  if (UpdateUniformValue(location, value)) {
+    glProgramUniform1i(shaderProgram_, location, value);
+  }
 }
@@ -2,26 +2,157 @@
 
 #include <glad/gl.h>
 #include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "Hash.h"
+#include "ProgramBinaryCache.h"
+
+// Hash of a uniform name. constexpr so names written in code are hashed at
+// compile time.
+constexpr uint32_t HashUniformName(std::string_view name) {
+  return HashFnv1a32(name);
+}
+
+// A uniform name that was hashed at compile time. Implicitly constructible from
+// a string literal, so `shader.SetInt("uTexture", 0)` never builds a string.
+struct UniformName {
+  consteval UniformName(const char* name)
+      : name(name), hash(HashUniformName(name)) {}
+
+  const char* name;
+  uint32_t hash;
+};
+
+// Typed handle to a uniform location, resolved once through
+// Shader::GetUniform. Setting a uniform through a handle is at most one
+// glProgramUniform* call on the handle's program, whichever program is bound.
+template <typename T>
+struct UniformHandle {
+  GLint location = -1;
+
+  bool IsValid() const { return location != -1; }
+};
+
+// Vertex and fragment sources already in memory, e.g. read from an
+// AssetArchive
+struct ShaderSources {
+  std::string_view vertex;
+  std::string_view fragment;
+};
 
 class Shader {
  public:
+  // defines are "NAME" or "NAME value" strings inserted after #version in both
+  // stages. If binaryCache is given, the linked program is loaded from and
+  // stored to it.
   Shader(
     const std::filesystem::path& vertexShaderPath,
-    const std::filesystem::path& fragmentShaderPath
+    const std::filesystem::path& fragmentShaderPath,
+    const std::vector<std::string>& defines = {},
+    const ProgramBinaryCache* binaryCache = nullptr
+  );
+  explicit Shader(
+    const ShaderSources& sources,
+    const std::vector<std::string>& defines = {},
+    const ProgramBinaryCache* binaryCache = nullptr
   );
+  ~Shader();
+  Shader(const Shader&) = delete;
+  Shader& operator=(const Shader&) = delete;
+
+  // Binds the program, unless it already is
   void Use();
-  void SetBool(const std::string& name, bool value) const;
-  void SetInt(const std::string& name, int value) const;
-  float GetFloat(const std::string& name) const;
-  void SetFloat(const std::string& name, float value) const;
+
+  // Resolves a typed handle from the uniform cache. Returns an invalid handle
+  // (which GL ignores on set) if the uniform is not active in the program, and
+  // throws if the uniform's GL type does not match T.
+  template <typename T>
+  UniformHandle<T> GetUniform(UniformName name) const;
+
+  // Setters skip the GL call when the uniform already has the value, as
+  // uniforms are program state and keep their values between draws
+  void Set(UniformHandle<bool> uniform, bool value) const;
+  void Set(UniformHandle<int> uniform, int value) const;
+  void Set(UniformHandle<float> uniform, float value) const;
+  void Set(UniformHandle<glm::vec4> uniform, const glm::vec4& value) const;
+  void Set(UniformHandle<glm::mat4> uniform, const glm::mat4& value) const;
+
+  void SetBool(UniformName name, bool value) const;
+  void SetInt(UniformName name, int value) const;
+  float GetFloat(UniformName name) const;
+  void SetFloat(UniformName name, float value) const;
   void SetUniform4f(
-    const std::string& name, float v0, float v1, float v2, float v3
+    UniformName name, float v0, float v1, float v2, float v3
   ) const;
-  void SetUniformMatrix4fv(const std::string& name, const glm::mat4& value);
+  void SetUniformMatrix4fv(UniformName name, const glm::mat4& value) const;
 
  private:
+  // An active uniform reflected from the linked program
+  struct UniformInfo {
+    uint32_t hash;
+    GLint location;
+    GLenum type;
+  };
+
+  // Last value set at a location, as the bytes of the value's type
+  struct UniformValue {
+    bool known = false;
+    std::array<uint8_t, sizeof(glm::mat4)> bytes;
+  };
+
+  // Throws std::ifstream::failure if the file can't be read
+  static std::string ReadSource(const std::filesystem::path& path);
+  static std::string InjectDefines(
+    std::string source, const std::vector<std::string>& defines
+  );
+  void CompileAndLink(
+    const std::string& vertexShaderSource,
+    const std::string& fragmentShaderSource
+  );
+  // Fills uniforms_ with every active uniform of the linked program, sorted by
+  // name hash.
+  void ReflectUniforms();
+  const UniformInfo* FindUniform(uint32_t hash) const;
+  GLint GetUniformLocation(UniformName name) const;
+  GLint GetUniformLocation(UniformName name, GLenum expectedType) const;
+  // Sets int and bool uniforms, and samplers
+  void SetIntAtLocation(GLint location, int value) const;
+  // Whether a uniform must be set to value, i.e. it has another value or none
+  // yet. Remembers value if so.
+  template <typename T>
+  bool UpdateUniformValue(GLint location, const T& value) const;
+
   GLuint shaderProgram_;
+  std::vector<UniformInfo> uniforms_;
+  // Indexed by location. Locations beyond it, rare as drivers number them
+  // from 0, are always set.
+  mutable std::vector<UniformValue> uniformValues_;
 };
+
+// GL uniform type expected for each handle type. Samplers are set through int
+// handles, so they are matched separately in GetUniformLocation.
+template <typename T>
+constexpr GLenum kUniformGLType = GL_NONE;
+template <>
+constexpr GLenum kUniformGLType<bool> = GL_BOOL;
+template <>
+constexpr GLenum kUniformGLType<int> = GL_INT;
+template <>
+constexpr GLenum kUniformGLType<float> = GL_FLOAT;
+template <>
+constexpr GLenum kUniformGLType<glm::vec4> = GL_FLOAT_VEC4;
+template <>
+constexpr GLenum kUniformGLType<glm::mat4> = GL_FLOAT_MAT4;
+
+template <typename T>
+UniformHandle<T> Shader::GetUniform(UniformName name) const {
+  static_assert(kUniformGLType<T> != GL_NONE, "Unsupported uniform type");
+  return UniformHandle<T>{GetUniformLocation(name, kUniformGLType<T>)};
+}
@@ -0,0 +1,27 @@
+#include "Simd.h"
+
+#include <SDL3/SDL_cpuinfo.h>
+
+const char* GetSimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return "scalar";
+    case SimdLevel::kSSE2:
+      return "SSE2";
+    case SimdLevel::kAVX2:
+      return "AVX2";
+  }
+  return "unknown";
+}
+
+SimdLevel GetSupportedSimdLevel() {
+  static const SimdLevel level = []() {
+#if LIZUAL_SIMD_X86
+    // SDL also checks that the OS saves AVX state
+    if (LIZUAL_AVX2_KERNELS && SDL_HasAVX2()) { return SimdLevel::kAVX2; }
+    if (SDL_HasSSE2()) { return SimdLevel::kSSE2; }
+#endif
+    return SimdLevel::kScalar;
+  }();
+  return level;
+}
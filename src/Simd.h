@@ -0,0 +1,31 @@
+#pragma once
+
+// Instruction set levels that batch kernels are specialized for. Kernels are
+// selected at runtime, so a single build runs on any x86-64 CPU.
+enum class SimdLevel {
+  kScalar,
+  // Baseline on x86-64
+  kSSE2,
+  // AVX2 + FMA
+  kAVX2,
+};
+
+const char* GetSimdLevelName(SimdLevel level);
+
+// Highest level that both the CPU supports and this build has kernels for.
+// Detected once and cached.
+SimdLevel GetSupportedSimdLevel();
+
+// x86 builds carry SSE2 kernels. AVX2 kernels live in *AVX2.cpp translation
+// units, which CMake builds with AVX2 flags and LIZUAL_AVX2_KERNELS=1 when the
+// compiler supports them.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+  defined(_M_IX86)
+#define LIZUAL_SIMD_X86 1
+#else
+#define LIZUAL_SIMD_X86 0
+#endif
+
+#ifndef LIZUAL_AVX2_KERNELS
+#define LIZUAL_AVX2_KERNELS 0
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded queue between one producer thread and one consumer thread. Neither
+// side takes a lock: each owns one index and only reads the other's. Push and
+// Pop block on the other side's index while the queue is full or empty.
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) : slots_(capacity > 0 ? capacity : 1) {}
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer only. Returns false if the queue is full.
+  bool TryPush(T value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail % slots_.size()] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+    return true;
+  }
+
+  // Producer only. Waits for the consumer while the queue is full.
+  void Push(T value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      const size_t head = head_.load(std::memory_order_acquire);
+      if (tail - head < slots_.size()) { break; }
+      head_.wait(head, std::memory_order_acquire);
+    }
+    slots_[tail % slots_.size()] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+  }
+
+  // Consumer only. Returns false if the queue is empty.
+  bool TryPop(T& out) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) { return false; }
+    out = std::move(slots_[head % slots_.size()]);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+    return true;
+  }
+
+  // Consumer only. Waits for the producer while the queue is empty.
+  T Pop() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      const size_t tail = tail_.load(std::memory_order_acquire);
+      if (tail != head) { break; }
+      tail_.wait(tail, std::memory_order_acquire);
+    }
+    T value = std::move(slots_[head % slots_.size()]);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+    return value;
+  }
+
+  size_t GetCapacity() const { return slots_.size(); }
+
+ private:
+  std::vector<T> slots_;
+  // Count of values popped, written by the consumer
+  alignas(64) std::atomic<size_t> head_ = 0;
+  // Count of values pushed, written by the producer
+  alignas(64) std::atomic<size_t> tail_ = 0;
+};
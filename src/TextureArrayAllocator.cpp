@@ -0,0 +1,51 @@
+#include "TextureArrayAllocator.h"
+
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <utility>
+
+TextureArrayAllocator::TextureArrayAllocator(uint32_t maxLayers)
+    : maxLayers_(std::clamp(maxLayers, 1u, uint32_t{UINT16_MAX} + 1)) {}
+
+std::optional<TextureArrayAllocator::Slot> TextureArrayAllocator::Add(
+  int width, int height, std::vector<uint8_t> rgba
+) {
+  // The upload reads a full layer, so a short one would be read past its end
+  if (width <= 0 || height <= 0 ||
+      rgba.size() != size_t{4} * width * height) {
+    SDL_Log(
+      "TextureArrayAllocator: %zu bytes of pixels for a %dx%d RGBA8 layer",
+      rgba.size(),
+      width,
+      height
+    );
+    return std::nullopt;
+  }
+  // Only the last array of a size can have free layers
+  auto it = std::find_if(arrays_.rbegin(), arrays_.rend(), [&](const Array& a) {
+    return a.width == width && a.height == height;
+  });
+  if (it == arrays_.rend() || it->layers.size() == maxLayers_) {
+    arrays_.push_back({width, height, {}});
+    it = arrays_.rbegin();
+  }
+  it->layers.push_back(std::move(rgba));
+  return Slot{
+    static_cast<uint16_t>(arrays_.rend() - it - 1),
+    static_cast<uint16_t>(it->layers.size() - 1),
+  };
+}
+
+std::vector<TextureLoader::Handle> TextureArrayAllocator::Load(
+  TextureLoader& loader
+) {
+  std::vector<TextureLoader::Handle> handles;
+  for (Array& array : arrays_) {
+    handles.push_back(loader.LoadPixelLayers(
+      array.width, array.height, std::move(array.layers)
+    ));
+  }
+  arrays_.clear();
+  return handles;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "TextureLoader.h"
+
+// Packs RGBA8 textures of the same size into the layers of shared texture
+// arrays, so objects with different textures can be drawn with one bind and
+// one instanced draw that picks a layer per instance. Textures are added up
+// front, as array storage can't grow, then Load queues one array per size,
+// starting another where the driver's layer limit is reached.
+class TextureArrayAllocator {
+ public:
+  // Where an added texture ends up: the array, indexing the handles Load
+  // returns, and the layer in it
+  struct Slot {
+    uint16_t array;
+    uint16_t layer;
+  };
+
+  // maxLayers is the driver's GL_MAX_ARRAY_TEXTURE_LAYERS
+  explicit TextureArrayAllocator(uint32_t maxLayers);
+
+  // rgba must be width * height * 4 bytes. Returns nothing, and logs why, if
+  // it isn't.
+  std::optional<Slot> Add(int width, int height, std::vector<uint8_t> rgba);
+
+  // Queues every array on the loader and returns their handles. Leaves the
+  // allocator empty.
+  std::vector<TextureLoader::Handle> Load(TextureLoader& loader);
+
+ private:
+  struct Array {
+    int width;
+    int height;
+    std::vector<std::vector<uint8_t>> layers;
+  };
+
+  uint32_t maxLayers_;
+  std::vector<Array> arrays_;
+};
@@ -0,0 +1,239 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace {
+constexpr uint32_t kMagic = 0x5845'544c;  // "LTEX"
+constexpr uint32_t kVersion = 1;
+// Largest dimension accepted, as a sanity check on corrupt headers
+constexpr int kMaxSize = 1 << 15;
+// Level data starts at a multiple of this, so SIMD readers of the mapping get
+// aligned loads
+constexpr size_t kDataAlignment = 16;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levelCount;
+};
+
+struct FileLevel {
+  uint64_t offset;
+  uint64_t size;
+};
+
+const struct {
+  TextureFormat format;
+  const char* name;
+} kFormatNames[] = {
+  {TextureFormat::kRGBA8, "rgba8"},
+  {TextureFormat::kBC1, "bc1"},
+  {TextureFormat::kBC3, "bc3"},
+  {TextureFormat::kBC7, "bc7"},
+};
+
+bool IsKnownFormat(uint32_t format) {
+  for (const auto& entry : kFormatNames) {
+    if (format == static_cast<uint32_t>(entry.format)) { return true; }
+  }
+  return false;
+}
+
+size_t GetDataOffset(size_t levelCount) {
+  const size_t tableEnd = sizeof(FileHeader) + levelCount * sizeof(FileLevel);
+  return (tableEnd + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+}  // namespace
+
+std::optional<TextureFormat> ParseTextureFormat(std::string_view name) {
+  for (const auto& entry : kFormatNames) {
+    if (name == entry.name) { return entry.format; }
+  }
+  return std::nullopt;
+}
+
+const char* GetTextureFormatName(TextureFormat format) {
+  for (const auto& entry : kFormatNames) {
+    if (entry.format == format) { return entry.name; }
+  }
+  return "unknown";
+}
+
+bool IsBlockCompressed(TextureFormat format) {
+  return format != TextureFormat::kRGBA8;
+}
+
+size_t GetTextureLevelSize(TextureFormat format, int width, int height) {
+  // Partial blocks at the edges still take a whole block
+  const size_t blockCount =
+    static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+  switch (format) {
+    case TextureFormat::kRGBA8:
+      return static_cast<size_t>(width) * height * 4;
+    case TextureFormat::kBC1:
+      return blockCount * 8;
+    case TextureFormat::kBC3:
+    case TextureFormat::kBC7:
+      return blockCount * 16;
+  }
+  return 0;
+}
+
+int GetFullMipLevelCount(int width, int height) {
+  return std::bit_width(static_cast<unsigned>(std::max(width, height)));
+}
+
+std::optional<TextureFile> TextureFile::Open(
+  const std::filesystem::path& path, std::string& error
+) {
+  std::optional<MappedFile> file = MappedFile::Open(path, error);
+  if (!file) { return std::nullopt; }
+  // Moving the file keeps its mapping, so the parsed levels stay valid
+  std::optional<TextureFile> texture =
+    Parse(file->GetData(), path.string(), error);
+  if (texture) { texture->file_ = std::move(file); }
+  return texture;
+}
+
+std::optional<TextureFile> TextureFile::Parse(
+  std::span<const uint8_t> bytes, std::string_view name, std::string& error
+) {
+  auto fail = [&](const std::string& problem) {
+    error = std::string(name) + ": " + problem;
+    return std::nullopt;
+  };
+
+  FileHeader header;
+  if (bytes.size() < sizeof(header)) { return fail("truncated header"); }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) { return fail("not a texture file"); }
+  if (header.version != kVersion) {
+    return fail("unsupported version " + std::to_string(header.version));
+  }
+  if (!IsKnownFormat(header.format)) {
+    return fail("unknown format " + std::to_string(header.format));
+  }
+  const int width = static_cast<int>(header.width);
+  const int height = static_cast<int>(header.height);
+  if (header.width == 0 || header.height == 0 || header.width > kMaxSize ||
+      header.height > kMaxSize) {
+    return fail("invalid size");
+  }
+  if (header.levelCount == 0 ||
+      header.levelCount >
+        static_cast<uint32_t>(GetFullMipLevelCount(width, height))) {
+    return fail("invalid level count");
+  }
+  if (bytes.size() < GetDataOffset(header.levelCount)) {
+    return fail("truncated level table");
+  }
+
+  const TextureFormat format = static_cast<TextureFormat>(header.format);
+  TextureFile texture(format);
+  const uint8_t* data = bytes.data();
+  uint64_t expectedOffset = GetDataOffset(header.levelCount);
+  for (uint32_t i = 0; i < header.levelCount; ++i) {
+    FileLevel level;
+    std::memcpy(
+      &level,
+      data + sizeof(FileHeader) + i * sizeof(FileLevel),
+      sizeof(level)
+    );
+    const int levelWidth = std::max(width >> i, 1);
+    const int levelHeight = std::max(height >> i, 1);
+    if (level.offset != expectedOffset ||
+        level.size != GetTextureLevelSize(format, levelWidth, levelHeight) ||
+        level.offset + level.size > bytes.size()) {
+      return fail("invalid level " + std::to_string(i));
+    }
+    texture.levels_.push_back(
+      {levelWidth,
+       levelHeight,
+       {data + level.offset, static_cast<size_t>(level.size)}}
+    );
+    expectedOffset += level.size;
+  }
+  return texture;
+}
+
+bool TextureFile::Write(
+  const std::filesystem::path& path,
+  TextureFormat format,
+  std::span<const TextureLevel> levels,
+  std::string& error
+) {
+  if (levels.empty()) {
+    error = "no levels to write";
+    return false;
+  }
+  const int width = levels[0].width;
+  const int height = levels[0].height;
+  const int fullLevelCount = GetFullMipLevelCount(width, height);
+  if (levels.size() > static_cast<size_t>(fullLevelCount)) {
+    error = "more levels than a full mip chain";
+    return false;
+  }
+
+  const FileHeader header{
+    kMagic,
+    kVersion,
+    static_cast<uint32_t>(format),
+    static_cast<uint32_t>(width),
+    static_cast<uint32_t>(height),
+    static_cast<uint32_t>(levels.size()),
+  };
+  std::vector<FileLevel> table;
+  uint64_t offset = GetDataOffset(levels.size());
+  for (size_t i = 0; i < levels.size(); ++i) {
+    const TextureLevel& level = levels[i];
+    if (level.width != std::max(width >> i, 1) ||
+        level.height != std::max(height >> i, 1) ||
+        level.data.size() !=
+          GetTextureLevelSize(format, level.width, level.height)) {
+      error = "level " + std::to_string(i) + " has the wrong size";
+      return false;
+    }
+    table.push_back({offset, level.data.size()});
+    offset += level.data.size();
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    error = "failed to open " + path.string() + " for writing";
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(
+    reinterpret_cast<const char*>(table.data()),
+    static_cast<std::streamsize>(table.size() * sizeof(FileLevel))
+  );
+  const size_t padding = GetDataOffset(levels.size()) - sizeof(header) -
+                         table.size() * sizeof(FileLevel);
+  const char zeros[kDataAlignment] = {};
+  file.write(zeros, static_cast<std::streamsize>(padding));
+  for (const TextureLevel& level : levels) {
+    file.write(
+      reinterpret_cast<const char*>(level.data.data()),
+      static_cast<std::streamsize>(level.data.size())
+    );
+  }
+  if (!file) {
+    error = "failed to write " + path.string();
+    return false;
+  }
+  return true;
+}
+
+std::span<const uint8_t> TextureFile::GetLevelData() const {
+  const uint8_t* begin = levels_.front().data.data();
+  const uint8_t* end = levels_.back().data.data() + levels_.back().data.size();
+  return {begin, end};
+}
+
+void TextureFile::Prefetch() const { MappedFile::Prefetch(GetLevelData()); }
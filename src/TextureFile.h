@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Pixel formats of cooked textures. The values are stored in files, so never
+// renumber them.
+enum class TextureFormat : uint32_t {
+  kRGBA8 = 0,
+  // Block compressed: 4x4 texel blocks of 8 (BC1) or 16 bytes. BC1 is opaque
+  // RGB, BC3 adds a separately coded alpha, and BC7 codes RGBA together at
+  // higher quality.
+  kBC1 = 1,
+  kBC3 = 2,
+  kBC7 = 3,
+};
+
+std::optional<TextureFormat> ParseTextureFormat(std::string_view name);
+const char* GetTextureFormatName(TextureFormat format);
+bool IsBlockCompressed(TextureFormat format);
+// Bytes of one mip level in the given format
+size_t GetTextureLevelSize(TextureFormat format, int width, int height);
+// Levels of a full mip chain, down to 1x1
+int GetFullMipLevelCount(int width, int height);
+
+// One mip level. Level i of a texture is max(size >> i, 1) in each dimension.
+struct TextureLevel {
+  int width;
+  int height;
+  std::span<const uint8_t> data;
+};
+
+// A cooked texture (.ltex), made offline by lizual_cook: a mip chain already in
+// the format the GL texture stores, so loading is just mapping the file and
+// uploading each level, with no decoding or mipmap generation.
+//
+// Layout, little endian: a header, a table with the offset and size of every
+// level, then the level data, largest first and tightly packed.
+class TextureFile {
+ public:
+  static constexpr const char* kExtension = ".ltex";
+
+  // Maps and validates a file. On failure returns std::nullopt and describes
+  // the problem in error.
+  static std::optional<TextureFile> Open(
+    const std::filesystem::path& path, std::string& error
+  );
+  // Validates a texture in memory owned by the caller, e.g. an AssetArchive
+  // entry, which must outlive the TextureFile. name prefixes errors.
+  static std::optional<TextureFile> Parse(
+    std::span<const uint8_t> bytes, std::string_view name, std::string& error
+  );
+  // Writes levels, which must be consecutive mip levels starting at level 0.
+  // Returns false and describes the problem in error on failure.
+  static bool Write(
+    const std::filesystem::path& path,
+    TextureFormat format,
+    std::span<const TextureLevel> levels,
+    std::string& error
+  );
+
+  TextureFormat GetFormat() const { return format_; }
+  int GetWidth() const { return levels_[0].width; }
+  int GetHeight() const { return levels_[0].height; }
+  size_t GetLevelCount() const { return levels_.size(); }
+  const TextureLevel& GetLevel(size_t index) const { return levels_[index]; }
+  // Data of all levels, which are contiguous in the file
+  std::span<const uint8_t> GetLevelData() const;
+
+  // Starts reading the level data from disk in the background
+  void Prefetch() const;
+
+ private:
+  explicit TextureFile(TextureFormat format) : format_(format) {}
+
+  // The mapping the levels point into, if the texture was opened from a file
+  std::optional<MappedFile> file_;
+  TextureFormat format_;
+  std::vector<TextureLevel> levels_;
+};
@@ -0,0 +1,753 @@
+#include "TextureLoader.h"
+
+#include <SDL3/SDL_log.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <string_view>
+#include <utility>
+
+#include "BlockCompression.h"
+#include "GLState.h"
+#include "GLStats.h"
+#include "MipGenerator.h"
+#include "Profiler.h"
+
+namespace {
+constexpr int kPlaceholderSize = 8;
+constexpr int kPlaceholderTileSize = 4;
+constexpr size_t kPageSize = 4096;
+// Textures keep their levels of this size and smaller resident, so there is
+// always something to sample
+constexpr int kMinResidentSize = 32;
+
+// From EXT_texture_compression_s3tc, which the GLAD loader wasn't generated
+// with. BC1 is uploaded as RGB, as the encoder drops its alpha.
+constexpr GLenum kCompressedRgbS3tcDxt1 = 0x83F0;
+constexpr GLenum kCompressedRgbaS3tcDxt5 = 0x83F3;
+
+GLenum GetInternalFormat(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::kRGBA8:
+      return GL_RGBA8;
+    case TextureFormat::kBC1:
+      return kCompressedRgbS3tcDxt1;
+    case TextureFormat::kBC3:
+      return kCompressedRgbaS3tcDxt5;
+    case TextureFormat::kBC7:
+      return GL_COMPRESSED_RGBA_BPTC_UNORM;
+  }
+  return GL_RGBA8;
+}
+
+// Creates a texture array with storage for the given mip levels and layers,
+// and leaves it bound. Storage is immutable where glTexStorage3D is available
+// (GL 4.2); the 4.1 contexts of macOS get the same levels allocated one by
+// one. No pixel unpack buffer may be bound, as the levels are allocated from
+// null.
+GLuint CreateTextureStorage(
+  TextureFormat format, int width, int height, int layers, GLsizei levels
+) {
+  const GLenum internalFormat = GetInternalFormat(format);
+  GLuint texture;
+  glGenTextures(1, &texture);
+  GLState::BindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  if (GLAD_GL_VERSION_4_2) {
+    glTexStorage3D(
+      GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, layers
+    );
+    return texture;
+  }
+  for (GLsizei level = 0; level < levels; ++level) {
+    const int levelWidth = std::max(width >> level, 1);
+    const int levelHeight = std::max(height >> level, 1);
+    if (IsBlockCompressed(format)) {
+      glCompressedTexImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        level,
+        internalFormat,
+        levelWidth,
+        levelHeight,
+        layers,
+        0,
+        static_cast<GLsizei>(
+          GetTextureLevelSize(format, levelWidth, levelHeight) * layers
+        ),
+        nullptr
+      );
+    } else {
+      glTexImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        level,
+        internalFormat,
+        levelWidth,
+        levelHeight,
+        layers,
+        0,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        nullptr
+      );
+    }
+  }
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  return texture;
+}
+
+// Faults in the pages of a mapped range, so a later copy doesn't wait for the
+// disk
+void ReadIn(std::span<const uint8_t> data) {
+  MappedFile::Prefetch(data);
+  uint8_t touched = 0;
+  for (size_t i = 0; i < data.size(); i += kPageSize) { touched ^= data[i]; }
+  volatile uint8_t sink = touched;
+  (void)sink;
+}
+
+// The contiguous data of levels from level down
+std::span<const uint8_t> GetLevelRangeData(
+  std::span<const TextureLevel> levels, int level
+) {
+  const uint8_t* begin = levels[level].data.data();
+  const uint8_t* end = levels.back().data.data() + levels.back().data.size();
+  return {begin, end};
+}
+}  // namespace
+
+TextureLoader::TextureLoader(
+  JobSystem& jobs, size_t residencyBudgetBytes
+)
+    : jobs_(jobs), residencyBudget_(residencyBudgetBytes) {
+  // BPTC is core since 4.2
+  bptcSupported_ = GLAD_GL_VERSION_4_2;
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (GLint i = 0; i < extensionCount; ++i) {
+    const std::string_view extension = reinterpret_cast<const char*>(
+      glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))
+    );
+    if (extension == "GL_EXT_texture_compression_s3tc") {
+      s3tcSupported_ = true;
+    } else if (extension == "GL_ARB_texture_compression_bptc") {
+      bptcSupported_ = true;
+    }
+  }
+  if (!s3tcSupported_ || !bptcSupported_) {
+    SDL_Log(
+      "TextureLoader: Decompressing%s%s textures, the driver doesn't have them",
+      s3tcSupported_ ? "" : " BC1/BC3",
+      bptcSupported_ ? "" : " BC7"
+    );
+  }
+
+  // A grey checkerboard, visibly not a real texture
+  std::vector<uint8_t> pixels(kPlaceholderSize * kPlaceholderSize * 4);
+  for (int y = 0; y < kPlaceholderSize; ++y) {
+    for (int x = 0; x < kPlaceholderSize; ++x) {
+      const bool light =
+        (x / kPlaceholderTileSize + y / kPlaceholderTileSize) % 2 == 0;
+      uint8_t* texel = &pixels[(y * kPlaceholderSize + x) * 4];
+      std::memset(texel, light ? 160 : 96, 3);
+      texel[3] = 255;
+    }
+  }
+  placeholder_ = CreateTextureStorage(
+    TextureFormat::kRGBA8,
+    kPlaceholderSize,
+    kPlaceholderSize,
+    1,
+    GetFullMipLevelCount(kPlaceholderSize, kPlaceholderSize)
+  );
+  glTexSubImage3D(
+    GL_TEXTURE_2D_ARRAY,
+    0,
+    0,
+    0,
+    0,
+    kPlaceholderSize,
+    kPlaceholderSize,
+    1,
+    GL_RGBA,
+    GL_UNSIGNED_BYTE,
+    pixels.data()
+  );
+  GLStats::RecordTextureUpload(pixels.size());
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+  glGenBuffers(1, &uploadBuffer_);
+}
+
+TextureLoader::~TextureLoader() {
+  {
+    // Workers reference this loader until they finish
+    std::unique_lock lock(mutex_);
+    taskFinished_.wait(lock, [this] { return tasksInFlight_ == 0; });
+  }
+  for (const Entry& entry : entries_) {
+    if (entry.texture != 0) { GLState::DeleteTextures(1, &entry.texture); }
+  }
+  GLState::DeleteTextures(1, &placeholder_);
+  GLState::DeleteBuffers(1, &uploadBuffer_);
+}
+
+TextureLoader::Handle TextureLoader::AddEntry(std::string name) {
+  Entry& entry = entries_.emplace_back();
+  entry.name = std::move(name);
+  ++pendingCount_;
+  return static_cast<Handle>(entries_.size() - 1);
+}
+
+TextureLoader::Handle TextureLoader::Load(
+  const std::filesystem::path& path, bool flipVertically
+) {
+  const Handle handle = AddEntry(path.string());
+  SubmitDecode(handle, [this, path, flipVertically](DecodedImage& image) {
+    if (path.extension() == TextureFile::kExtension) {
+      LIZUAL_PROFILE_SCOPE("Read cooked texture");
+      image.cooked = TextureFile::Open(path, image.error);
+      PrepareCooked(image);
+    } else {
+      LIZUAL_PROFILE_SCOPE("Decode texture");
+      stbi_set_flip_vertically_on_load_thread(flipVertically);
+      int channels;
+      // Always RGBA, so rows are 4-byte aligned and there is one upload path
+      TakeDecodedPixels(
+        image,
+        stbi_load(
+          path.string().c_str(), &image.width, &image.height, &channels, 4
+        )
+      );
+    }
+  });
+  return handle;
+}
+
+TextureLoader::Handle TextureLoader::Load(
+  const AssetArchive& archive, std::string name, bool flipVertically
+) {
+  const Handle handle = AddEntry(name);
+  SubmitDecode(
+    handle,
+    [this, &archive, name, flipVertically](DecodedImage& image) {
+      const std::optional<std::span<const uint8_t>> data =
+        archive.Read(name, image.storage);
+      if (!data) {
+        image.error = "not in the asset archive";
+        return;
+      }
+      if (name.ends_with(TextureFile::kExtension)) {
+        LIZUAL_PROFILE_SCOPE("Read cooked texture");
+        image.cooked = TextureFile::Parse(*data, name, image.error);
+        PrepareCooked(image);
+      } else {
+        LIZUAL_PROFILE_SCOPE("Decode texture");
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
+        int channels;
+        TakeDecodedPixels(
+          image,
+          stbi_load_from_memory(
+            data->data(),
+            static_cast<int>(data->size()),
+            &image.width,
+            &image.height,
+            &channels,
+            4
+          )
+        );
+      }
+    }
+  );
+  return handle;
+}
+
+TextureLoader::Handle TextureLoader::LoadPixels(
+  int width, int height, std::vector<uint8_t> rgba
+) {
+  std::vector<std::vector<uint8_t>> layers;
+  layers.push_back(std::move(rgba));
+  return LoadPixelLayers(width, height, std::move(layers));
+}
+
+TextureLoader::Handle TextureLoader::LoadPixelLayers(
+  int width, int height, std::vector<std::vector<uint8_t>> layers
+) {
+  const Handle handle = AddEntry(
+    layers.size() == 1 ? "<pixels>"
+                       : "<pixels x" + std::to_string(layers.size()) + ">"
+  );
+  // Only the mip chains are generated on the worker
+  SubmitDecode(
+    handle,
+    [width, height, layers = std::move(layers)](DecodedImage& image) {
+      // A short layer would be read past its end by the upload
+      const size_t layerBytes =
+        width > 0 && height > 0 ? size_t{4} * width * height : 0;
+      for (size_t i = 0; i < layers.size(); ++i) {
+        if (layerBytes == 0 || layers[i].size() != layerBytes) {
+          image.error = std::format(
+            "layer {} is {} bytes, expected {} for {}x{} RGBA8",
+            i,
+            layers[i].size(),
+            layerBytes,
+            width,
+            height
+          );
+          return;
+        }
+      }
+      image.width = width;
+      image.height = height;
+      image.layerCount = static_cast<int>(layers.size());
+      for (const std::vector<uint8_t>& layer : layers) {
+        image.pixels.insert(image.pixels.end(), layer.begin(), layer.end());
+      }
+      GenerateLevels(image);
+    }
+  );
+  return handle;
+}
+
+void TextureLoader::SubmitDecode(
+  Handle handle, std::function<void(DecodedImage&)> decode
+) {
+  {
+    std::lock_guard lock(mutex_);
+    ++tasksInFlight_;
+  }
+  jobs_.SubmitBackground([this, handle, decode = std::move(decode)] {
+    DecodedImage image;
+    image.handle = handle;
+    decode(image);
+    {
+      std::lock_guard lock(mutex_);
+      decoded_.push_back(std::move(image));
+      --tasksInFlight_;
+    }
+    taskFinished_.notify_all();
+  });
+}
+
+void TextureLoader::TakeDecodedPixels(DecodedImage& image, uint8_t* data) {
+  if (data == nullptr) {
+    image.error = stbi_failure_reason();
+    return;
+  }
+  image.pixels.assign(
+    data, data + static_cast<size_t>(image.width) * image.height * 4
+  );
+  stbi_image_free(data);
+  GenerateLevels(image);
+}
+
+void TextureLoader::GenerateLevels(DecodedImage& image) {
+  LIZUAL_PROFILE_SCOPE("Generate mip chain");
+  const size_t layerSize = static_cast<size_t>(image.width) * image.height * 4;
+  std::vector<std::vector<MipLevel>> chains;
+  size_t totalBytes = 0;
+  for (int layer = 0; layer < image.layerCount; ++layer) {
+    chains.push_back(GenerateMipChain(
+      std::span(image.pixels).subspan(layer * layerSize, layerSize),
+      image.width,
+      image.height
+    ));
+    for (const MipLevel& level : chains.back()) {
+      totalBytes += level.pixels.size();
+    }
+  }
+  // Sized up front, so the levels can point into it. Moving it into the image
+  // keeps the buffer.
+  std::vector<uint8_t> pixels;
+  pixels.reserve(totalBytes);
+  image.levels.clear();
+  for (size_t level = 0; level < chains.front().size(); ++level) {
+    const size_t levelStart = pixels.size();
+    for (const std::vector<MipLevel>& chain : chains) {
+      pixels.insert(
+        pixels.end(), chain[level].pixels.begin(), chain[level].pixels.end()
+      );
+    }
+    image.levels.push_back(
+      {chains.front()[level].width,
+       chains.front()[level].height,
+       std::span(pixels).subspan(levelStart)}
+    );
+  }
+  image.pixels = std::move(pixels);
+}
+
+void TextureLoader::PrepareCooked(DecodedImage& image) const {
+  if (!image.cooked) { return; }
+  image.format = image.cooked->GetFormat();
+  image.width = image.cooked->GetWidth();
+  image.height = image.cooked->GetHeight();
+  for (size_t i = 0; i < image.cooked->GetLevelCount(); ++i) {
+    image.levels.push_back(image.cooked->GetLevel(i));
+  }
+  if (!IsFormatSupported(image.format)) {
+    Decompress(image);
+    return;
+  }
+  // Fault in the levels uploaded first here, so the copy on the GL thread
+  // doesn't wait for the disk. Finer levels are read in when they are wanted.
+  ReadIn(GetLevelRangeData(image.levels, GetSmallestResidentLevel(image)));
+}
+
+void TextureLoader::Decompress(DecodedImage& image) {
+  LIZUAL_PROFILE_SCOPE("Decompress texture");
+  size_t totalBytes = 0;
+  for (const TextureLevel& level : image.levels) {
+    totalBytes += static_cast<size_t>(level.width) * level.height * 4;
+  }
+  // Sized up front, so the levels can point into it
+  image.pixels.reserve(totalBytes);
+  std::vector<TextureLevel> levels;
+  for (const TextureLevel& level : image.levels) {
+    const std::vector<uint8_t> rgba =
+      DecompressImage(level.data, level.width, level.height, image.format);
+    image.pixels.insert(image.pixels.end(), rgba.begin(), rgba.end());
+    levels.push_back(
+      {level.width,
+       level.height,
+       std::span(image.pixels).subspan(image.pixels.size() - rgba.size())}
+    );
+  }
+  image.levels = std::move(levels);
+  image.format = TextureFormat::kRGBA8;
+  image.cooked.reset();
+}
+
+void TextureLoader::RequestSize(Handle handle, float screenSize) {
+  Entry& entry = entries_[handle];
+  entry.requestedSize = std::max(entry.requestedSize, screenSize);
+  entry.lastUsedFrame = frame_;
+}
+
+void TextureLoader::Update() {
+  const size_t uploadedBytes = Upload(kUploadBudgetBytes);
+  if (uploadedBytes < kUploadBudgetBytes) {
+    Stream(kUploadBudgetBytes - uploadedBytes);
+  }
+  ++frame_;
+}
+
+void TextureLoader::Finish() {
+  LIZUAL_PROFILE_SCOPE("TextureLoader::Finish");
+  while (pendingCount_ > 0) {
+    {
+      std::unique_lock lock(mutex_);
+      taskFinished_.wait(lock, [this] { return !decoded_.empty(); });
+    }
+    Upload(SIZE_MAX);
+  }
+}
+
+size_t TextureLoader::Upload(size_t budgetBytes) {
+  LIZUAL_PROFILE_SCOPE("TextureLoader::Upload");
+  size_t uploadedBytes = 0;
+  while (uploadedBytes < budgetBytes) {
+    DecodedImage image;
+    {
+      std::lock_guard lock(mutex_);
+      if (decoded_.empty()) { break; }
+      image = std::move(decoded_.front());
+      decoded_.pop_front();
+    }
+    --pendingCount_;
+    Entry& entry = entries_[image.handle];
+    if (image.levels.empty()) {
+      SDL_Log(
+        "TextureLoader: Failed to load %s: %s",
+        entry.name.c_str(),
+        image.error.empty() ? "no pixels" : image.error.c_str()
+      );
+      entry.state = State::kFailed;
+      continue;
+    }
+    // Start with the smallest levels; Stream brings in the ones requested
+    const int level = GetSmallestResidentLevel(image);
+    entry.source = std::move(image);
+    entry.loadedLevel = entry.source.cooked ? level : 0;
+    entry.wantedLevel = level;
+    if (SetResidentLevel(entry, level)) {
+      entry.state = State::kReady;
+      uploadedBytes += entry.residentBytes;
+    }
+  }
+  return uploadedBytes;
+}
+
+void TextureLoader::Stream(size_t budgetBytes) {
+  LIZUAL_PROFILE_SCOPE("TextureLoader::Stream");
+  {
+    std::lock_guard lock(mutex_);
+    for (const LevelsRead& read : levelsRead_) {
+      Entry& entry = entries_[read.handle];
+      entry.loadedLevel = std::min(entry.loadedLevel, read.level);
+      entry.reading = false;
+    }
+    levelsRead_.clear();
+  }
+
+  // Turn this frame's requests into wanted levels, and read in the levels
+  // that aren't in memory yet
+  std::vector<Handle> upgrades;
+  for (Handle handle = 0; handle < entries_.size(); ++handle) {
+    Entry& entry = entries_[handle];
+    if (entry.state != State::kReady) {
+      entry.requestedSize = 0.0f;
+      continue;
+    }
+    if (entry.requestedSize > 0.0f) {
+      entry.wantedLevel = GetLevelForSize(entry.source, entry.requestedSize);
+      entry.requestedSize = 0.0f;
+    }
+    if (entry.wantedLevel >= entry.residentLevel) { continue; }
+    if (entry.wantedLevel < entry.loadedLevel && !entry.reading) {
+      entry.reading = true;
+      const std::span<const uint8_t> data = GetLevelRangeData(
+        entry.source.levels, entry.wantedLevel
+      ).first(
+        GetLevelRangeSize(entry.source, entry.wantedLevel) -
+        GetLevelRangeSize(entry.source, entry.loadedLevel)
+      );
+      {
+        std::lock_guard lock(mutex_);
+        ++tasksInFlight_;
+      }
+      jobs_.SubmitBackground([this, handle, level = entry.wantedLevel, data] {
+        {
+          LIZUAL_PROFILE_SCOPE("Read texture levels");
+          ReadIn(data);
+        }
+        {
+          std::lock_guard lock(mutex_);
+          levelsRead_.push_back({handle, level});
+          --tasksInFlight_;
+        }
+        taskFinished_.notify_all();
+      });
+    }
+    if (entry.loadedLevel < entry.residentLevel) { upgrades.push_back(handle); }
+  }
+
+  // Most recently used first, so they get the budget when there isn't enough
+  // for all
+  std::stable_sort(upgrades.begin(), upgrades.end(), [&](Handle a, Handle b) {
+    return entries_[a].lastUsedFrame > entries_[b].lastUsedFrame;
+  });
+  size_t uploadedBytes = 0;
+  for (const Handle handle : upgrades) {
+    Entry& entry = entries_[handle];
+    int level = std::max(entry.wantedLevel, entry.loadedLevel);
+    while (!IsValidBaseLevel(entry.source, level)) { ++level; }
+    auto getGrowth = [&](int newLevel) {
+      return GetLevelRangeSize(entry.source, newLevel) - entry.residentBytes;
+    };
+    while (residentBytes_ + getGrowth(level) > residencyBudget_ &&
+           Evict(handle, entry.lastUsedFrame, uploadedBytes)) {
+    }
+    // Take as many of the levels as fit
+    while (level < entry.residentLevel &&
+           residentBytes_ + getGrowth(level) > residencyBudget_) {
+      ++level;
+    }
+    while (level < entry.residentLevel &&
+           !IsValidBaseLevel(entry.source, level)) {
+      ++level;
+    }
+    if (level >= entry.residentLevel) { continue; }
+    const size_t size = GetLevelRangeSize(entry.source, level);
+    if (uploadedBytes > 0 && uploadedBytes + size > budgetBytes) { break; }
+    if (SetResidentLevel(entry, level)) { uploadedBytes += size; }
+  }
+
+  // Get back within a budget that was lowered
+  while (residentBytes_ > residencyBudget_ &&
+         Evict(kNoHandle, UINT64_MAX, uploadedBytes)) {
+  }
+}
+
+bool TextureLoader::Evict(
+  Handle keep, uint64_t usedBefore, size_t& uploadedBytes
+) {
+  // Levels nobody wants go first, then the least recently used
+  Handle victim = kNoHandle;
+  bool victimHasSurplus = false;
+  for (Handle handle = 0; handle < entries_.size(); ++handle) {
+    const Entry& entry = entries_[handle];
+    if (handle == keep || entry.state != State::kReady ||
+        entry.residentLevel >= GetSmallestResidentLevel(entry.source)) {
+      continue;
+    }
+    const bool hasSurplus = entry.residentLevel < entry.wantedLevel;
+    if (!hasSurplus && entry.lastUsedFrame >= usedBefore) { continue; }
+    if (victim == kNoHandle || (hasSurplus && !victimHasSurplus) ||
+        (hasSurplus == victimHasSurplus &&
+         entry.lastUsedFrame < entries_[victim].lastUsedFrame)) {
+      victim = handle;
+      victimHasSurplus = hasSurplus;
+    }
+  }
+  if (victim == kNoHandle) { return false; }
+
+  Entry& entry = entries_[victim];
+  int level = entry.residentLevel + 1;
+  if (victimHasSurplus) { level = entry.wantedLevel; }
+  while (!IsValidBaseLevel(entry.source, level)) { ++level; }
+  // Read in again before it comes back, in case the pages were dropped
+  if (entry.source.cooked) { entry.loadedLevel = level; }
+  if (!SetResidentLevel(entry, level)) { return false; }
+  uploadedBytes += entry.residentBytes;
+  return true;
+}
+
+bool TextureLoader::SetResidentLevel(Entry& entry, int level) {
+  const DecodedImage& image = entry.source;
+  const TextureLevel& base = image.levels[level];
+  const std::span<const uint8_t> data = GetLevelRangeData(image.levels, level);
+  const size_t size = data.size();
+  const GLuint texture = CreateTextureStorage(
+    image.format,
+    base.width,
+    base.height,
+    image.layerCount,
+    static_cast<GLsizei>(image.levels.size() - level)
+  );
+
+  // Stage the pixels in the PBO. Orphaning gives fresh storage, so this never
+  // waits for the previous upload to be consumed.
+  GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer_);
+  glBufferData(
+    GL_PIXEL_UNPACK_BUFFER,
+    static_cast<GLsizeiptr>(size),
+    nullptr,
+    GL_STREAM_DRAW
+  );
+  void* staging = glMapBufferRange(
+    GL_PIXEL_UNPACK_BUFFER,
+    0,
+    static_cast<GLsizeiptr>(size),
+    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+  );
+  if (staging == nullptr) {
+    SDL_Log(
+      "TextureLoader: Failed to map upload buffer for %s",
+      entry.name.c_str()
+    );
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    GLState::DeleteTextures(1, &texture);
+    if (entry.texture == 0) { entry.state = State::kFailed; }
+    return false;
+  }
+  std::memcpy(staging, data.data(), size);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  GLStats::RecordTextureUpload(size);
+
+  // With a PBO bound the pixel pointer is an offset into it, and the copy
+  // into the texture happens asynchronously
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  for (size_t i = level; i < image.levels.size(); ++i) {
+    const TextureLevel& source = image.levels[i];
+    const GLint target = static_cast<GLint>(i - level);
+    const void* offset =
+      reinterpret_cast<const void*>(source.data.data() - data.data());
+    // The layers of a level are consecutive, as the depth slices of an upload
+    if (IsBlockCompressed(image.format)) {
+      glCompressedTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        target,
+        0,
+        0,
+        0,
+        source.width,
+        source.height,
+        image.layerCount,
+        GetInternalFormat(image.format),
+        static_cast<GLsizei>(source.data.size()),
+        offset
+      );
+    } else {
+      glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY,
+        target,
+        0,
+        0,
+        0,
+        source.width,
+        source.height,
+        image.layerCount,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        offset
+      );
+    }
+  }
+  GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  // Draws already issued with the old texture still complete, as GL only
+  // deletes it once they are done
+  if (entry.texture != 0) { GLState::DeleteTextures(1, &entry.texture); }
+  entry.texture = texture;
+  residentBytes_ = residentBytes_ - entry.residentBytes + size;
+  entry.residentBytes = size;
+  entry.residentLevel = level;
+  return true;
+}
+
+size_t TextureLoader::GetLevelRangeSize(const DecodedImage& image, int level) {
+  return GetLevelRangeData(image.levels, level).size();
+}
+
+int TextureLoader::GetSmallestResidentLevel(const DecodedImage& image) {
+  int smallest = 0;
+  for (int level = 1; level < static_cast<int>(image.levels.size()); ++level) {
+    const TextureLevel& data = image.levels[level];
+    if (std::max(data.width, data.height) < kMinResidentSize) { break; }
+    if (IsValidBaseLevel(image, level)) { smallest = level; }
+  }
+  return smallest;
+}
+
+bool TextureLoader::IsValidBaseLevel(const DecodedImage& image, int level) {
+  if (level == 0 || !IsBlockCompressed(image.format)) { return true; }
+  const TextureLevel& data = image.levels[level];
+  return data.width % 4 == 0 && data.height % 4 == 0;
+}
+
+int TextureLoader::GetLevelForSize(
+  const DecodedImage& image, float screenSize
+) {
+  const int smallest = GetSmallestResidentLevel(image);
+  const float ratio =
+    static_cast<float>(std::max(image.width, image.height)) / screenSize;
+  int level = ratio > 1.0f ? static_cast<int>(std::log2(ratio)) : 0;
+  level = std::min(level, smallest);
+  // Round to the next finer level that can be a base level
+  while (!IsValidBaseLevel(image, level)) { --level; }
+  return level;
+}
+
+GLuint TextureLoader::GetTexture(Handle handle) const {
+  const Entry& entry = entries_[handle];
+  return entry.state == State::kReady ? entry.texture : placeholder_;
+}
+
+bool TextureLoader::IsReady(Handle handle) const {
+  return entries_[handle].state == State::kReady;
+}
+
+bool TextureLoader::IsFormatSupported(TextureFormat format) const {
+  switch (format) {
+    case TextureFormat::kRGBA8:
+      return true;
+    case TextureFormat::kBC1:
+    case TextureFormat::kBC3:
+      return s3tcSupported_;
+    case TextureFormat::kBC7:
+      return bptcSupported_;
+  }
+  return false;
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include "TextureFile.h"
+
+// Loads textures without stalling frames, and streams their mip levels in and
+// out. Images are decoded to RGBA8 and given a mip chain in background jobs,
+// and cooked textures (.ltex) are mapped. Block compressed textures are
+// uploaded as they are where the driver supports their format (S3TC for
+// BC1/BC3, BPTC for BC7), and decompressed to RGBA8 on the worker otherwise.
+// Until a texture is uploaded, and if it fails to load, its handle resolves to
+// a placeholder.
+//
+// Every texture is a GL_TEXTURE_2D_ARRAY: images have one layer, and
+// LoadPixelLayers packs several same-size images into one texture, so draws
+// can pick a layer per instance instead of binding another texture.
+//
+// The whole chain stays in memory (or mapped), but the GL texture only holds
+// the levels from a resident level down. A texture starts with its smallest
+// levels, and RequestSize asks for the detail it needs on screen: finer levels
+// are read in on a worker, then uploaded through a pixel buffer object into a
+// new texture with the finer base level. When that would go over the
+// residency budget, levels are evicted from the least recently used textures
+// first, and a texture gets only as many finer levels as fit.
+//
+// Apart from the worker side of decoding, everything must be called on the
+// thread that owns the GL context.
+class TextureLoader {
+ public:
+  using Handle = uint32_t;
+
+  // Bytes uploaded per Update at most, so a burst of finished decodes is
+  // spread over a few frames instead of causing one long hitch. A single
+  // larger texture is still uploaded whole.
+  static constexpr size_t kUploadBudgetBytes = 32 << 20;
+
+  // residencyBudgetBytes caps the memory of the resident levels of all
+  // textures, except that the smallest levels of each always stay resident
+  TextureLoader(JobSystem& jobs, size_t residencyBudgetBytes);
+  // Waits for decodes and reads in flight and deletes every texture
+  ~TextureLoader();
+  TextureLoader(const TextureLoader&) = delete;
+  TextureLoader& operator=(const TextureLoader&) = delete;
+
+  // Queues an image file for decoding, or a cooked texture for reading.
+  // Flipping is for images stored top row first, as GL expects the bottom row
+  // first; cooked textures are flipped when they are cooked.
+  Handle Load(const std::filesystem::path& path, bool flipVertically = false);
+  // The same for a file in an archive, which must outlive the loader. Files
+  // stored uncompressed are decoded or uploaded straight from the mapping.
+  Handle Load(
+    const AssetArchive& archive, std::string name, bool flipVertically = false
+  );
+  // Queues pixels that are already RGBA8 for upload, e.g. generated textures
+  Handle LoadPixels(int width, int height, std::vector<uint8_t> rgba);
+  // The same for images of one size, as the layers of one texture. Levels
+  // stream in and out for all of its layers at once.
+  Handle LoadPixelLayers(
+    int width, int height, std::vector<std::vector<uint8_t>> layers
+  );
+
+  // Asks for the detail of a texture drawn at most screenSize pixels across
+  // since the last Update, which streams in the level closest to that size.
+  // Textures asked for most recently are the last to lose levels.
+  void RequestSize(Handle handle, float screenSize);
+
+  // Uploads decoded images and streams levels in and out within the budgets.
+  // Call once per frame.
+  void Update();
+  // Blocks until every queued texture is uploaded or has failed
+  void Finish();
+
+  // The texture, or the placeholder while it is loading or if it failed
+  GLuint GetTexture(Handle handle) const;
+  bool IsReady(Handle handle) const;
+  // Whether textures of the format are uploaded without decompressing them
+  bool IsFormatSupported(TextureFormat format) const;
+  // Textures queued but not uploaded yet
+  size_t GetPendingCount() const { return pendingCount_; }
+  // Bytes of all resident levels
+  size_t GetResidentBytes() const { return residentBytes_; }
+  size_t GetResidencyBudget() const { return residencyBudget_; }
+  void SetResidencyBudget(size_t bytes) { residencyBudget_ = bytes; }
+
+ private:
+  enum class State { kLoading, kReady, kFailed };
+
+  // Output of a worker: either pixels (decoded, or decompressed from a cooked
+  // texture) or a cooked texture, with levels pointing into them. Levels are
+  // contiguous and form a chain down to 1x1, unless the texture was cooked
+  // with fewer. Each level holds every layer in turn. No levels means loading
+  // failed, and why is in error; stb_image keeps its failure reason per
+  // thread.
+  struct DecodedImage {
+    Handle handle = 0;
+    TextureFormat format = TextureFormat::kRGBA8;
+    int width = 0;
+    int height = 0;
+    int layerCount = 1;
+    std::vector<uint8_t> pixels;
+    std::optional<TextureFile> cooked;
+    // Holds an archive file that had to be decompressed, which cooked may
+    // point into
+    std::vector<uint8_t> storage;
+    std::vector<TextureLevel> levels;
+    std::string error;
+  };
+
+  struct Entry {
+    std::string name;
+    State state = State::kLoading;
+    GLuint texture = 0;
+    // The uploaded image, kept for uploading levels again. Its levels stay
+    // valid when entries move.
+    DecodedImage source;
+    // Level of source that is the base level of texture. Levels from here
+    // down are resident.
+    int residentLevel = 0;
+    // Finest level known to be read into memory, so uploading it doesn't
+    // fault on the GL thread. Always 0 for pixels.
+    int loadedLevel = 0;
+    // Whether a worker is reading levels in
+    bool reading = false;
+    // Level the texture should have resident, from its requested size
+    int wantedLevel = 0;
+    // Largest size requested since the last Update
+    float requestedSize = 0.0f;
+    // Update count when the texture was last requested
+    uint64_t lastUsedFrame = 0;
+    size_t residentBytes = 0;
+  };
+
+  // Levels down to level were read in by a worker
+  struct LevelsRead {
+    Handle handle;
+    int level;
+  };
+
+  static constexpr Handle kNoHandle = UINT32_MAX;
+
+  Handle AddEntry(std::string name);
+  // Runs decode on a worker and queues its output for upload
+  void SubmitDecode(Handle handle, std::function<void(DecodedImage&)> decode);
+  // Takes pixels from stbi_load, or its failure reason if there are none, and
+  // generates their mip chain
+  static void TakeDecodedPixels(DecodedImage& image, uint8_t* data);
+  // Replaces the levels of image by full chains generated from the base level
+  // of each layer, which are all that pixels holds
+  static void GenerateLevels(DecodedImage& image);
+  // Fills in the levels of a cooked texture and gets its smallest levels
+  // ready for upload
+  void PrepareCooked(DecodedImage& image) const;
+  // Replaces the cooked texture of image by its levels decompressed to RGBA8
+  static void Decompress(DecodedImage& image);
+  // Uploads new images within the budget and returns the bytes uploaded
+  size_t Upload(size_t budgetBytes);
+  // Reads wanted levels in and swaps them into textures within the budgets
+  void Stream(size_t budgetBytes);
+  // Drops levels of the least recently used texture other than keep: first
+  // one that has levels finer than it wants, then one last used before
+  // usedBefore. Adds the bytes uploaded for the levels that stay to
+  // uploadedBytes. Returns false if no texture has levels to drop.
+  bool Evict(Handle keep, uint64_t usedBefore, size_t& uploadedBytes);
+  // Recreates the texture of entry with source levels from level down, and
+  // returns false if the upload failed. The previous texture is kept then, or
+  // the entry fails if it had none.
+  bool SetResidentLevel(Entry& entry, int level);
+
+  // Bytes of the levels of image from level down
+  static size_t GetLevelRangeSize(const DecodedImage& image, int level);
+  // Coarsest level that may be resident, so a texture is never less than
+  // this
+  static int GetSmallestResidentLevel(const DecodedImage& image);
+  // Whether level can be the base level of a texture. Block compressed
+  // levels can only be if they are whole blocks.
+  static bool IsValidBaseLevel(const DecodedImage& image, int level);
+  // Level that is at least screenSize across, or the smallest resident one
+  static int GetLevelForSize(const DecodedImage& image, float screenSize);
+
+  JobSystem& jobs_;
+  // Indexed by handle. GL thread only.
+  std::vector<Entry> entries_;
+  size_t pendingCount_ = 0;
+  size_t residentBytes_ = 0;
+  size_t residencyBudget_;
+  // Update count, for least recently used order
+  uint64_t frame_ = 0;
+  GLuint placeholder_;
+  // Compressed formats the driver has. Set on construction, then read by the
+  // workers too.
+  bool s3tcSupported_ = false;
+  bool bptcSupported_ = false;
+  // Pixel buffer object the uploads are staged in, orphaned before each one
+  GLuint uploadBuffer_;
+
+  // Shared with the workers
+  std::mutex mutex_;
+  std::condition_variable taskFinished_;
+  std::deque<DecodedImage> decoded_;
+  std::deque<LevelsRead> levelsRead_;
+  // Decodes and reads submitted and not yet finished
+  size_t tasksInFlight_ = 0;
+};
@@ -0,0 +1,354 @@
+#include "TransformBatch.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "TransformBatchKernels.h"
+
+#if LIZUAL_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+void TransformBatch::Resize(size_t size) {
+  for (std::vector<float>* stream :
+       {&positionX, &positionY, &positionZ, &axisX, &axisZ, &angle}) {
+    stream->resize(size, 0.0f);
+  }
+  // Default to the identity rotation around +Y and unit scale
+  axisY.resize(size, 1.0f);
+  for (std::vector<float>* stream : {&scaleX, &scaleY, &scaleZ}) {
+    stream->resize(size, 1.0f);
+  }
+}
+
+void TransformBatch::Set(
+  size_t index,
+  const glm::vec3& position,
+  const glm::vec3& axis,
+  float angleRadians,
+  const glm::vec3& scale
+) {
+  positionX[index] = position.x;
+  positionY[index] = position.y;
+  positionZ[index] = position.z;
+  axisX[index] = axis.x;
+  axisY[index] = axis.y;
+  axisZ[index] = axis.z;
+  angle[index] = angleRadians;
+  scaleX[index] = scale.x;
+  scaleY[index] = scale.y;
+  scaleZ[index] = scale.z;
+}
+
+void TransformBatch::Gather(
+  const TransformBatch& source, std::span<const uint32_t> indices
+) {
+  Resize(indices.size());
+  Gather(source, indices, 0, indices.size());
+}
+
+void TransformBatch::Gather(
+  const TransformBatch& source,
+  std::span<const uint32_t> indices,
+  size_t begin,
+  size_t end
+) {
+  auto gatherStream = [&](std::vector<float>& destination,
+                          const std::vector<float>& sourceStream) {
+    for (size_t i = begin; i < end; ++i) {
+      destination[i] = sourceStream[indices[i]];
+    }
+  };
+  gatherStream(positionX, source.positionX);
+  gatherStream(positionY, source.positionY);
+  gatherStream(positionZ, source.positionZ);
+  gatherStream(axisX, source.axisX);
+  gatherStream(axisY, source.axisY);
+  gatherStream(axisZ, source.axisZ);
+  gatherStream(angle, source.angle);
+  gatherStream(scaleX, source.scaleX);
+  gatherStream(scaleY, source.scaleY);
+  gatherStream(scaleZ, source.scaleZ);
+}
+
+namespace transform_kernels {
+
+Streams Advance(const Streams& streams, size_t index) {
+  return Streams{
+    streams.positionX + index,
+    streams.positionY + index,
+    streams.positionZ + index,
+    streams.axisX + index,
+    streams.axisY + index,
+    streams.axisZ + index,
+    streams.angle + index,
+    streams.scaleX + index,
+    streams.scaleY + index,
+    streams.scaleZ + index,
+  };
+}
+
+void BuildScalar(const Streams& streams, size_t count, float* out) {
+  for (size_t i = 0; i < count; ++i, out += 16) {
+    float x = streams.axisX[i];
+    float y = streams.axisY[i];
+    float z = streams.axisZ[i];
+    const float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+    x *= inverseLength;
+    y *= inverseLength;
+    z *= inverseLength;
+    const float c = std::cos(streams.angle[i]);
+    const float s = std::sin(streams.angle[i]);
+    const float t = 1.0f - c;
+    const float sx = streams.scaleX[i];
+    const float sy = streams.scaleY[i];
+    const float sz = streams.scaleZ[i];
+
+    // Columns of rotate(angle, axis), each scaled by its axis' scale
+    out[0] = (c + t * x * x) * sx;
+    out[1] = (t * x * y + s * z) * sx;
+    out[2] = (t * x * z - s * y) * sx;
+    out[3] = 0.0f;
+    out[4] = (t * y * x - s * z) * sy;
+    out[5] = (c + t * y * y) * sy;
+    out[6] = (t * y * z + s * x) * sy;
+    out[7] = 0.0f;
+    out[8] = (t * z * x + s * y) * sz;
+    out[9] = (t * z * y - s * x) * sz;
+    out[10] = (c + t * z * z) * sz;
+    out[11] = 0.0f;
+    out[12] = streams.positionX[i];
+    out[13] = streams.positionY[i];
+    out[14] = streams.positionZ[i];
+    out[15] = 1.0f;
+  }
+}
+
+#if LIZUAL_SIMD_X86
+namespace {
+// sin and cos of 4 lanes at once (Cephes sincosf): reduce to [-pi/4, pi/4]
+// around the nearest multiple of pi/2, evaluate both minimax polynomials and
+// pick/negate by quadrant.
+void SinCos(__m128 x, __m128* sinOut, __m128* cosOut) {
+  const __m128i quadrant =
+    _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772367581343f)));
+  const __m128 j = _mm_cvtepi32_ps(quadrant);
+  // Extended precision subtraction of j * pi/2
+  __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(1.5703125f)));
+  r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(4.837512969970703125e-4f)));
+  r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(7.54978995489188216e-8f)));
+  const __m128 z = _mm_mul_ps(r, r);
+
+  __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+  sinPoly =
+    _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+  sinPoly =
+    _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+  sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), r), r);
+
+  __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+  cosPoly =
+    _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+  cosPoly =
+    _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+  cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+  cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+  // Odd quadrants swap sin and cos. Quadrants 2 and 3 negate sin, quadrants 1
+  // and 2 negate cos.
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128 swap = _mm_castsi128_ps(
+    _mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one)
+  );
+  const __m128 sinSign =
+    _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+  const __m128 cosSign = _mm_castsi128_ps(
+    _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30)
+  );
+  const __m128 sinValue = _mm_or_ps(
+    _mm_and_ps(swap, cosPoly), _mm_andnot_ps(swap, sinPoly)
+  );
+  const __m128 cosValue = _mm_or_ps(
+    _mm_and_ps(swap, sinPoly), _mm_andnot_ps(swap, cosPoly)
+  );
+  *sinOut = _mm_xor_ps(sinValue, sinSign);
+  *cosOut = _mm_xor_ps(cosValue, cosSign);
+}
+
+// Transposes four lanes of (x, y, z, w) into one matrix column per object and
+// stores them to the four consecutive matrices starting at out
+void StoreColumn(__m128 x, __m128 y, __m128 z, __m128 w, float* out) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(out, x);
+  _mm_storeu_ps(out + 16, y);
+  _mm_storeu_ps(out + 32, z);
+  _mm_storeu_ps(out + 48, w);
+}
+}  // namespace
+
+void BuildSSE2(const Streams& streams, size_t count, float* out) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4, out += 64) {
+    __m128 x = _mm_loadu_ps(streams.axisX + i);
+    __m128 y = _mm_loadu_ps(streams.axisY + i);
+    __m128 z = _mm_loadu_ps(streams.axisZ + i);
+    const __m128 lengthSquared = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)
+    );
+    const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+    x = _mm_mul_ps(x, inverseLength);
+    y = _mm_mul_ps(y, inverseLength);
+    z = _mm_mul_ps(z, inverseLength);
+
+    __m128 s;
+    __m128 c;
+    SinCos(_mm_loadu_ps(streams.angle + i), &s, &c);
+    const __m128 t = _mm_sub_ps(one, c);
+    const __m128 sx = _mm_loadu_ps(streams.scaleX + i);
+    const __m128 sy = _mm_loadu_ps(streams.scaleY + i);
+    const __m128 sz = _mm_loadu_ps(streams.scaleZ + i);
+
+    const __m128 tx = _mm_mul_ps(t, x);
+    const __m128 ty = _mm_mul_ps(t, y);
+    const __m128 tz = _mm_mul_ps(t, z);
+    const __m128 txy = _mm_mul_ps(tx, y);
+    const __m128 txz = _mm_mul_ps(tx, z);
+    const __m128 tyz = _mm_mul_ps(ty, z);
+    const __m128 sxAxis = _mm_mul_ps(s, x);
+    const __m128 syAxis = _mm_mul_ps(s, y);
+    const __m128 szAxis = _mm_mul_ps(s, z);
+
+    StoreColumn(
+      _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(tx, x)), sx),
+      _mm_mul_ps(_mm_add_ps(txy, szAxis), sx),
+      _mm_mul_ps(_mm_sub_ps(txz, syAxis), sx),
+      zero,
+      out
+    );
+    StoreColumn(
+      _mm_mul_ps(_mm_sub_ps(txy, szAxis), sy),
+      _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(ty, y)), sy),
+      _mm_mul_ps(_mm_add_ps(tyz, sxAxis), sy),
+      zero,
+      out + 4
+    );
+    StoreColumn(
+      _mm_mul_ps(_mm_add_ps(txz, syAxis), sz),
+      _mm_mul_ps(_mm_sub_ps(tyz, sxAxis), sz),
+      _mm_mul_ps(_mm_add_ps(c, _mm_mul_ps(tz, z)), sz),
+      zero,
+      out + 8
+    );
+    StoreColumn(
+      _mm_loadu_ps(streams.positionX + i),
+      _mm_loadu_ps(streams.positionY + i),
+      _mm_loadu_ps(streams.positionZ + i),
+      one,
+      out + 12
+    );
+  }
+  BuildScalar(Advance(streams, i), count - i, out);
+}
+
+#if !LIZUAL_AVX2_KERNELS
+// This build has no AVX2 kernels (see CMakeLists.txt), so the AVX2
+// translation unit is empty and AVX2 requests fall back to SSE2.
+void BuildAVX2(const Streams& streams, size_t count, float* out) {
+  BuildSSE2(streams, count, out);
+}
+#endif
+
+#else
+
+void BuildSSE2(const Streams& streams, size_t count, float* out) {
+  BuildScalar(streams, count, out);
+}
+
+void BuildAVX2(const Streams& streams, size_t count, float* out) {
+  BuildScalar(streams, count, out);
+}
+
+#endif  // LIZUAL_SIMD_X86
+
+}  // namespace transform_kernels
+
+void BuildModelMatrices(
+  const TransformBatch& batch,
+  size_t begin,
+  size_t end,
+  glm::mat4* out,
+  SimdLevel level
+) {
+  const transform_kernels::Streams streams{
+    batch.positionX.data() + begin,
+    batch.positionY.data() + begin,
+    batch.positionZ.data() + begin,
+    batch.axisX.data() + begin,
+    batch.axisY.data() + begin,
+    batch.axisZ.data() + begin,
+    batch.angle.data() + begin,
+    batch.scaleX.data() + begin,
+    batch.scaleY.data() + begin,
+    batch.scaleZ.data() + begin,
+  };
+  float* outFloats = glm::value_ptr(*out);
+  switch (level) {
+    case SimdLevel::kScalar:
+      transform_kernels::BuildScalar(streams, end - begin, outFloats);
+      break;
+    case SimdLevel::kSSE2:
+      transform_kernels::BuildSSE2(streams, end - begin, outFloats);
+      break;
+    case SimdLevel::kAVX2:
+      transform_kernels::BuildAVX2(streams, end - begin, outFloats);
+      break;
+  }
+}
+
+void BuildModelMatricesReference(
+  const TransformBatch& batch, size_t begin, size_t end, glm::mat4* out
+) {
+  for (size_t i = begin; i < end; ++i) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(
+      model,
+      glm::vec3(batch.positionX[i], batch.positionY[i], batch.positionZ[i])
+    );
+    model = glm::rotate(
+      model,
+      batch.angle[i],
+      glm::vec3(batch.axisX[i], batch.axisY[i], batch.axisZ[i])
+    );
+    model = glm::scale(
+      model, glm::vec3(batch.scaleX[i], batch.scaleY[i], batch.scaleZ[i])
+    );
+    out[i - begin] = model;
+  }
+}
+
+float MeasureModelMatrixError(const TransformBatch& batch, SimdLevel level) {
+  std::vector<glm::mat4> expected(batch.Size());
+  std::vector<glm::mat4> actual(batch.Size());
+  BuildModelMatricesReference(batch, 0, batch.Size(), expected.data());
+  BuildModelMatrices(batch, 0, batch.Size(), actual.data(), level);
+
+  float maxError = 0.0f;
+  for (size_t i = 0; i < batch.Size(); ++i) {
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        maxError = std::max(
+          maxError, std::abs(expected[i][column][row] - actual[i][column][row])
+        );
+      }
+    }
+  }
+  return maxError;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Simd.h"
+
+// Object transforms in structure-of-arrays layout, so batch kernels can load
+// the same component of 4 or 8 objects at once.
+//
+// Each transform is translate(position) * rotate(angle, axis) * scale(scale),
+// matching the glm calls it replaces.
+struct TransformBatch {
+  std::vector<float> positionX;
+  std::vector<float> positionY;
+  std::vector<float> positionZ;
+  // Rotation axis, normalized by the kernels like glm::rotate does
+  std::vector<float> axisX;
+  std::vector<float> axisY;
+  std::vector<float> axisZ;
+  // Rotation angle in radians. Keep it within a few turns of zero: the SIMD
+  // sine/cosine lose precision for very large arguments.
+  std::vector<float> angle;
+  std::vector<float> scaleX;
+  std::vector<float> scaleY;
+  std::vector<float> scaleZ;
+
+  size_t Size() const { return positionX.size(); }
+  void Resize(size_t size);
+  void Set(
+    size_t index,
+    const glm::vec3& position,
+    const glm::vec3& axis,
+    float angleRadians,
+    const glm::vec3& scale = glm::vec3(1.0f)
+  );
+  // Replaces this batch with the transforms of source at the given indices,
+  // e.g. to build matrices for only the visible objects.
+  void Gather(const TransformBatch& source, std::span<const uint32_t> indices);
+  // Gathers only the transforms at indices [begin, end), into a batch already
+  // resized to indices.size(), so threads can gather disjoint ranges
+  void Gather(
+    const TransformBatch& source,
+    std::span<const uint32_t> indices,
+    size_t begin,
+    size_t end
+  );
+};
+
+// Writes the model matrices of transforms [begin, end) to out[0, end - begin)
+// using the kernel for the given level.
+void BuildModelMatrices(
+  const TransformBatch& batch,
+  size_t begin,
+  size_t end,
+  glm::mat4* out,
+  SimdLevel level = GetSupportedSimdLevel()
+);
+
+// Reference implementation with plain glm calls, one object at a time
+void BuildModelMatricesReference(
+  const TransformBatch& batch, size_t begin, size_t end, glm::mat4* out
+);
+
+// Largest absolute difference between any matrix element produced by the
+// kernel for level and by the reference implementation.
+float MeasureModelMatrixError(const TransformBatch& batch, SimdLevel level);
@@ -0,0 +1,146 @@
+// Built with AVX2 and FMA enabled (see CMakeLists.txt). Only called after
+// GetSupportedSimdLevel() has checked that the CPU supports them. Must not
+// include glm or other headers with inline functions shared with the rest of
+// the program.
+#include "Simd.h"
+#include "TransformBatchKernels.h"
+
+#if LIZUAL_AVX2_KERNELS
+#include <immintrin.h>
+
+namespace transform_kernels {
+
+namespace {
+// 8-lane version of the Cephes sincosf in TransformBatch.cpp
+void SinCos(__m256 x, __m256* sinOut, __m256* cosOut) {
+  const __m256i quadrant = _mm256_cvtps_epi32(
+    _mm256_mul_ps(x, _mm256_set1_ps(0.636619772367581343f))
+  );
+  const __m256 j = _mm256_cvtepi32_ps(quadrant);
+  __m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(1.5703125f), x);
+  r = _mm256_fnmadd_ps(j, _mm256_set1_ps(4.837512969970703125e-4f), r);
+  r = _mm256_fnmadd_ps(j, _mm256_set1_ps(7.54978995489188216e-8f), r);
+  const __m256 z = _mm256_mul_ps(r, r);
+
+  __m256 sinPoly = _mm256_set1_ps(-1.9515295891e-4f);
+  sinPoly = _mm256_fmadd_ps(sinPoly, z, _mm256_set1_ps(8.3321608736e-3f));
+  sinPoly = _mm256_fmadd_ps(sinPoly, z, _mm256_set1_ps(-1.6666654611e-1f));
+  sinPoly = _mm256_fmadd_ps(_mm256_mul_ps(sinPoly, z), r, r);
+
+  __m256 cosPoly = _mm256_set1_ps(2.443315711809948e-5f);
+  cosPoly =
+    _mm256_fmadd_ps(cosPoly, z, _mm256_set1_ps(-1.388731625493765e-3f));
+  cosPoly =
+    _mm256_fmadd_ps(cosPoly, z, _mm256_set1_ps(4.166664568298827e-2f));
+  cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+  cosPoly = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cosPoly);
+  cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256 swap = _mm256_castsi256_ps(
+    _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one)
+  );
+  const __m256 sinSign = _mm256_castsi256_ps(
+    _mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30)
+  );
+  const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+    _mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30
+  ));
+  *sinOut = _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, swap), sinSign);
+  *cosOut = _mm256_xor_ps(_mm256_blendv_ps(cosPoly, sinPoly, swap), cosSign);
+}
+
+// Transposes eight lanes of (x, y, z, w) into one matrix column per object and
+// stores them to out[0..7]. Works on the two 128-bit halves independently:
+// the low half holds objects 0-3 and the high half objects 4-7.
+void StoreColumn(__m256 x, __m256 y, __m256 z, __m256 w, float* out) {
+  const __m256 xy0 = _mm256_unpacklo_ps(x, y);
+  const __m256 xy1 = _mm256_unpackhi_ps(x, y);
+  const __m256 zw0 = _mm256_unpacklo_ps(z, w);
+  const __m256 zw1 = _mm256_unpackhi_ps(z, w);
+  const __m256 objects[4] = {
+    _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0)),
+    _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2)),
+    _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0)),
+    _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2)),
+  };
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_ps(out + i * 16, _mm256_castps256_ps128(objects[i]));
+    _mm_storeu_ps(out + (i + 4) * 16, _mm256_extractf128_ps(objects[i], 1));
+  }
+}
+}  // namespace
+
+void BuildAVX2(const Streams& streams, size_t count, float* out) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8, out += 128) {
+    __m256 x = _mm256_loadu_ps(streams.axisX + i);
+    __m256 y = _mm256_loadu_ps(streams.axisY + i);
+    __m256 z = _mm256_loadu_ps(streams.axisZ + i);
+    const __m256 lengthSquared = _mm256_fmadd_ps(
+      z, z, _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x))
+    );
+    const __m256 inverseLength =
+      _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+    x = _mm256_mul_ps(x, inverseLength);
+    y = _mm256_mul_ps(y, inverseLength);
+    z = _mm256_mul_ps(z, inverseLength);
+
+    __m256 s;
+    __m256 c;
+    SinCos(_mm256_loadu_ps(streams.angle + i), &s, &c);
+    const __m256 t = _mm256_sub_ps(one, c);
+    const __m256 sx = _mm256_loadu_ps(streams.scaleX + i);
+    const __m256 sy = _mm256_loadu_ps(streams.scaleY + i);
+    const __m256 sz = _mm256_loadu_ps(streams.scaleZ + i);
+
+    const __m256 tx = _mm256_mul_ps(t, x);
+    const __m256 ty = _mm256_mul_ps(t, y);
+    const __m256 tz = _mm256_mul_ps(t, z);
+    const __m256 txy = _mm256_mul_ps(tx, y);
+    const __m256 txz = _mm256_mul_ps(tx, z);
+    const __m256 tyz = _mm256_mul_ps(ty, z);
+    const __m256 sxAxis = _mm256_mul_ps(s, x);
+    const __m256 syAxis = _mm256_mul_ps(s, y);
+    const __m256 szAxis = _mm256_mul_ps(s, z);
+
+    StoreColumn(
+      _mm256_mul_ps(_mm256_fmadd_ps(tx, x, c), sx),
+      _mm256_mul_ps(_mm256_add_ps(txy, szAxis), sx),
+      _mm256_mul_ps(_mm256_sub_ps(txz, syAxis), sx),
+      zero,
+      out
+    );
+    StoreColumn(
+      _mm256_mul_ps(_mm256_sub_ps(txy, szAxis), sy),
+      _mm256_mul_ps(_mm256_fmadd_ps(ty, y, c), sy),
+      _mm256_mul_ps(_mm256_add_ps(tyz, sxAxis), sy),
+      zero,
+      out + 4
+    );
+    StoreColumn(
+      _mm256_mul_ps(_mm256_add_ps(txz, syAxis), sz),
+      _mm256_mul_ps(_mm256_sub_ps(tyz, sxAxis), sz),
+      _mm256_mul_ps(_mm256_fmadd_ps(tz, z, c), sz),
+      zero,
+      out + 8
+    );
+    StoreColumn(
+      _mm256_loadu_ps(streams.positionX + i),
+      _mm256_loadu_ps(streams.positionY + i),
+      _mm256_loadu_ps(streams.positionZ + i),
+      one,
+      out + 12
+    );
+  }
+  // The tail is shorter than a full AVX2 batch, so at most one SSE2 batch plus
+  // scalar remains
+  BuildSSE2(Advance(streams, i), count - i, out);
+}
+
+}  // namespace transform_kernels
+
+#endif  // LIZUAL_AVX2_KERNELS
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// Kernels behind BuildModelMatrices. Separate from TransformBatch.h so the
+// AVX2 translation unit doesn't include glm: inline functions instantiated
+// there would be compiled with AVX2 enabled, and the linker may pick them for
+// callers on CPUs without AVX2.
+namespace transform_kernels {
+
+// Pointers to the first transform of each component stream
+struct Streams {
+  const float* positionX;
+  const float* positionY;
+  const float* positionZ;
+  const float* axisX;
+  const float* axisY;
+  const float* axisZ;
+  const float* angle;
+  const float* scaleX;
+  const float* scaleY;
+  const float* scaleZ;
+};
+
+// Each kernel writes count column-major 4x4 matrices to out
+void BuildScalar(const Streams& streams, size_t count, float* out);
+void BuildSSE2(const Streams& streams, size_t count, float* out);
+void BuildAVX2(const Streams& streams, size_t count, float* out);
+
+// Offsets every stream by index, for kernels that finish a tail with another
+// kernel
+Streams Advance(const Streams& streams, size_t index);
+
+}  // namespace transform_kernels
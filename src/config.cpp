@@ -2,19 +2,166 @@
 
 #include <SDL3/SDL_log.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
-void load_config_from_file(const std::filesystem::path& path) {
-  std::ifstream config_file(path);
-  if (!config_file.is_open() || config_file.fail()) {
+namespace {
+uint32_t parse_uint32(const std::string& value) {
+  // std::stoull alone would skip whitespace, wrap a leading minus and ignore
+  // what follows the digits
+  if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0]))) {
+    throw std::invalid_argument("not an unsigned integer");
+  }
+  size_t end = 0;
+  const unsigned long long parsed = std::stoull(value, &end);
+  if (end != value.size()) {
+    throw std::invalid_argument("not an unsigned integer");
+  }
+  if (parsed > std::numeric_limits<uint32_t>::max()) {
+    throw std::out_of_range("larger than 4294967295");
+  }
+  return static_cast<uint32_t>(parsed);
+}
+
+bool parse_bool(const std::string& value) {
+  if (value == "1" || value == "true" || value == "yes" || value == "on") {
+    return true;
+  }
+  if (value == "0" || value == "false" || value == "no" || value == "off") {
+    return false;
+  }
+  throw std::invalid_argument("not a boolean");
+}
+
+struct config_field {
+  std::string_view name;
+  bool is_bool;
+  // Parses value into the field, throwing std::exception if it is invalid
+  void (*apply)(const std::string& value);
+};
+
+constexpr config_field config_fields[] = {
+  {"update_rate",
+   false,
+   [](const std::string& value) {
+     config::update_rate = parse_uint32(value);
+   }},
+  {"frame_budget_ms",
+   false,
+   [](const std::string& value) {
+     config::frame_budget_ms = std::stof(value);
+   }},
+  {"benchmark",
+   true,
+   [](const std::string& value) { config::benchmark = parse_bool(value); }},
+  {"benchmark_frames",
+   false,
+   [](const std::string& value) {
+     config::benchmark_frames = parse_uint32(value);
+   }},
+  {"benchmark_warmup_frames",
+   false,
+   [](const std::string& value) {
+     config::benchmark_warmup_frames = parse_uint32(value);
+   }},
+  {"benchmark_width",
+   false,
+   [](const std::string& value) {
+     config::benchmark_width = parse_uint32(value);
+   }},
+  {"benchmark_height",
+   false,
+   [](const std::string& value) {
+     config::benchmark_height = parse_uint32(value);
+   }},
+  {"benchmark_output",
+   false,
+   [](const std::string& value) { config::benchmark_output = value; }},
+  {"scene_distribution",
+   false,
+   [](const std::string& value) { config::scene_distribution = value; }},
+  {"scene_object_count",
+   false,
+   [](const std::string& value) {
+     config::scene_object_count = parse_uint32(value);
+   }},
+  {"scene_animated_fraction",
+   false,
+   [](const std::string& value) {
+     config::scene_animated_fraction = std::stof(value);
+   }},
+  {"scene_mesh_count",
+   false,
+   [](const std::string& value) {
+     config::scene_mesh_count = parse_uint32(value);
+   }},
+  {"scene_texture_count",
+   false,
+   [](const std::string& value) {
+     config::scene_texture_count = parse_uint32(value);
+   }},
+  {"scene_seed",
+   false,
+   [](const std::string& value) { config::scene_seed = parse_uint32(value); }},
+  {"texture_budget_mb",
+   false,
+   [](const std::string& value) {
+     config::texture_budget_mb = parse_uint32(value);
+   }},
+  {"job_worker_count",
+   false,
+   [](const std::string& value) {
+     config::job_worker_count = parse_uint32(value);
+   }},
+  {"job_pin_threads",
+   true,
+   [](const std::string& value) {
+     config::job_pin_threads = parse_bool(value);
+   }},
+  {"job_first_core",
+   false,
+   [](const std::string& value) {
+     config::job_first_core = parse_uint32(value);
+   }},
+  {"render_frames_in_flight",
+   false,
+   [](const std::string& value) {
+     config::render_frames_in_flight = parse_uint32(value);
+   }},
+};
+
+const config_field* find_config_field(std::string_view name) {
+  for (const config_field& field : config_fields) {
+    if (field.name == name) { return &field; }
+  }
+  return nullptr;
+}
+
+// Sets a field from its text value. source names where it came from, for
+// logging.
+void apply_config_field(
+  const config_field& field, const std::string& value, const char* source
+) {
+  try {
+    field.apply(value);
+  } catch (const std::exception& e) {
     SDL_Log(
-      "config: Failed to open config file at path: %s", path.string().c_str()
+      "config: Invalid value (%s) for field (%s) in %s",
+      value.c_str(),
+      std::string(field.name).c_str(),
+      source
     );
-    return;
   }
+}
 
+void load_config_from_stream(std::istream& config_file, const char* source) {
   size_t line_number = 0;
   static constexpr size_t LINE_BUFFER_LENGTH = 512;
   char line[LINE_BUFFER_LENGTH] = {};
@@ -27,7 +174,7 @@ void load_config_from_file(const std::filesystem::path& path) {
       SDL_Log(
         "config: Failed to read line %zu of config file: %s",
         line_number,
-        path.string().c_str()
+        source
       );
       return;
     }
@@ -60,27 +207,71 @@ void load_config_from_file(const std::filesystem::path& path) {
     if (i >= LINE_BUFFER_LENGTH) { continue; }
     line[i] = '\0';
 
-    // Switch on field name, set value
-    if (strncmp(line + field_start, "update_rate", field_length) == 0) {
-      try {
-        config::update_rate = static_cast<uint32_t>(std::stoi(value));
-      } catch (const std::exception& e) {
-        SDL_Log(
-          "config: Invalid value (%s) for field (%s) in config file: %s",
-          value,
-          std::string(line + field_start, field_length),
-          path.string().c_str()
-        );
-        continue;
-      }
+    // Look up the field by name, set value
+    const std::string_view field_name(line + field_start, field_length);
+    if (const config_field* field = find_config_field(field_name)) {
+      apply_config_field(*field, value, source);
     } else {
       SDL_Log(
         "config: Found invalid field name (%s) in config file: %s",
-        std::string(line + field_start, field_length),
-        path.string().c_str()
+        std::string(field_name).c_str(),
+        source
       );
     }
 
     ++line_number;
   }
-}
\ No newline at end of file
+}
+}  // namespace
+
+void load_config_from_file(const std::filesystem::path& path) {
+  std::ifstream config_file(path);
+  if (!config_file.is_open() || config_file.fail()) {
+    SDL_Log(
+      "config: Failed to open config file at path: %s", path.string().c_str()
+    );
+    return;
+  }
+  load_config_from_stream(config_file, path.string().c_str());
+}
+
+void load_config_from_memory(std::string_view text, const char* source) {
+  std::istringstream config_stream{std::string(text)};
+  load_config_from_stream(config_stream, source);
+}
+
+void load_config_from_args(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument = argv[i];
+    if (!argument.starts_with("--")) {
+      SDL_Log("config: Ignoring unexpected argument: %s", argv[i]);
+      continue;
+    }
+    argument.remove_prefix(2);
+
+    // Split off an inline value
+    const size_t equals = argument.find('=');
+    std::string name(argument.substr(0, equals));
+    std::replace(name.begin(), name.end(), '-', '_');
+    const config_field* field = find_config_field(name);
+    if (field == nullptr) {
+      SDL_Log("config: Found invalid argument: %s", argv[i]);
+      continue;
+    }
+
+    std::string value;
+    if (equals != std::string_view::npos) {
+      value = argument.substr(equals + 1);
+    } else if (field->is_bool &&
+               (i + 1 >= argc || std::strncmp(argv[i + 1], "--", 2) == 0)) {
+      // Bare flag
+      value = "true";
+    } else if (i + 1 < argc) {
+      value = argv[++i];
+    } else {
+      SDL_Log("config: Missing value for argument: %s", argv[i]);
+      continue;
+    }
+    apply_config_field(*field, value, "command line");
+  }
+}
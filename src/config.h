@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <string>
+#include <string_view>
 
 /**
  * Config is for values that should be loaded at start time, not compile time,
@@ -13,10 +15,66 @@
  */
 struct config {
   static inline uint32_t update_rate = 60;
+  // Frame time target in milliseconds. Frames over it count against the
+  // frame time statistics.
+  static inline float frame_budget_ms = 1000.0f / 60.0f;
+
+  // Headless benchmark mode: renders benchmark_frames frames along a fixed
+  // camera path into an offscreen context as fast as possible, writes a
+  // report to benchmark_output and exits
+  static inline bool benchmark = false;
+  static inline uint32_t benchmark_frames = 1000;
+  // Frames rendered before measuring starts
+  static inline uint32_t benchmark_warmup_frames = 100;
+  static inline uint32_t benchmark_width = 1280;
+  static inline uint32_t benchmark_height = 720;
+  static inline std::string benchmark_output = "benchmark_report.json";
+
+  // Scene to render: "classic" for the ten hand-placed cubes, or a generated
+  // "uniform", "clustered" or "grid" scene of scene_object_count objects.
+  // Generated scenes only depend on these fields.
+  static inline std::string scene_distribution = "classic";
+  static inline uint32_t scene_object_count = 10000;
+  // Fraction of objects animated every frame, from 0 to 1
+  static inline float scene_animated_fraction = 0.1f;
+  static inline uint32_t scene_mesh_count = 1;
+  static inline uint32_t scene_texture_count = 1;
+  static inline uint32_t scene_seed = 1;
+
+  // Memory for the mip levels of textures on the GPU, in megabytes. Levels
+  // finer than that fits are streamed out, least recently used first.
+  static inline uint32_t texture_budget_mb = 256;
+
+  // Worker threads of the job system, 0 for one less than the cores. The main
+  // thread runs jobs too while it waits on them.
+  static inline uint32_t job_worker_count = 0;
+  // Pins the main thread and each worker to their own core (Linux, Windows)
+  static inline bool job_pin_threads = false;
+  // Core the main thread is pinned to. Workers take the cores after it,
+  // wrapping around, so other processes can keep the first few.
+  static inline uint32_t job_first_core = 0;
+
+  // Frames the simulation may build ahead of the render thread, which owns the
+  // GL context. 0 renders on the main thread instead, for platforms where GL
+  // has to stay there.
+  static inline uint32_t render_frames_in_flight = 2;
 };
 
 /**
  * Reads a file that contains "field=value" lines and writes to the static
  * config.
  */
-void load_config_from_file(const std::filesystem::path& path);
\ No newline at end of file
+void load_config_from_file(const std::filesystem::path& path);
+
+/**
+ * The same for config text already in memory, e.g. read from an asset
+ * archive. source names it in messages.
+ */
+void load_config_from_memory(std::string_view text, const char* source);
+
+/**
+ * Reads "--field=value" or "--field value" arguments and writes to the static
+ * config, so they override the config file. Field names may use dashes in
+ * place of underscores, and boolean fields may omit the value ("--benchmark").
+ */
+void load_config_from_args(int argc, char** argv);
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
@@ -11,94 +12,242 @@
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL_video.h>
-#include <stb_image.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <memory>
-
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "BVH.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "config.h"
+#include "DrawCommands.h"
+#include "FrameStats.h"
+#include "FrameStatsWindow.h"
+#include "GLState.h"
+#include "GLStats.h"
+#include "GpuTimer.h"
+#include "InstanceBuffer.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ProfilerWindow.h"
+#include "RenderPacket.h"
+#include "RenderThread.h"
+#include "Scene.h"
 #include "Shader.h"
+#include "Simd.h"
+#include "TextureArrayAllocator.h"
+#include "TextureFile.h"
+#include "TextureLoader.h"
+#include "TransformBatch.h"
 
 namespace {
 constexpr int kDefaultWindowWidth = 640;
 constexpr int kDefaultWindowHeight = 480;
 const std::filesystem::path kAssetsDir = LIZUAL_ASSETS_DIR;
-const std::filesystem::path kConfigPath = kAssetsDir / "config.txt";
-const std::filesystem::path kVertexShaderPath =
-  kAssetsDir / "shaders/default.vert";
-const std::filesystem::path kFragmentShaderPath =
-  kAssetsDir / "shaders/default.frag";
-const std::filesystem::path kContainerTexturePath =
-  kAssetsDir / "textures/container.jpg";
-const std::filesystem::path kAwesomeFaceTexturePath =
-  kAssetsDir / "textures/awesomeface.png";
+// Assets by their path relative to kAssetsDir, which is also their name in
+// the asset archive
+constexpr const char* kConfigName = "config.txt";
+constexpr const char* kVertexShaderName = "shaders/default.vert";
+constexpr const char* kFragmentShaderName = "shaders/default.frag";
+constexpr const char* kContainerTextureName = "textures/container.jpg";
+constexpr const char* kAwesomeFaceTextureName = "textures/awesomeface.png";
+// Textures cooked at build time, see CMakeLists.txt
+const std::filesystem::path kCookedDir = LIZUAL_COOKED_DIR;
+// The assets and cooked textures packed into one file at build time. Cooked
+// textures are named with this prefix.
+const std::filesystem::path kAssetArchivePath = LIZUAL_ASSET_ARCHIVE;
+constexpr std::string_view kArchiveCookedPrefix = "cooked/";
 
 // clang-format off
-// Vertices for a cube
-constexpr float kVertices[] = {
-  // positions          // texcoords
-  -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-   0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-   0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-   0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-  -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-  -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-  -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-   0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-   0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-   0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-  -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-  -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-  -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-  -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-  -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-  -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-  -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-  -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-   0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-   0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-   0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-   0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-   0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-   0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-  -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-   0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-   0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-   0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-  -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-  -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-  -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-   0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-   0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-   0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-  -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-  -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
+// Vertices for a cube, as a triangle list with every corner expanded. Built
+// into an indexed mesh at startup.
+constexpr Vertex kCubeVertices[] = {
+  // position               texcoord
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f}},
+  {{ 0.5f, -0.5f, -0.5f}, {1.0f, 0.0f}},
+  {{ 0.5f,  0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{ 0.5f,  0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{-0.5f,  0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f}},
+
+  {{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f}},
+  {{ 0.5f, -0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 1.0f}},
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 1.0f}},
+  {{-0.5f,  0.5f,  0.5f}, {0.0f, 1.0f}},
+  {{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f}},
+
+  {{-0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{-0.5f,  0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f}},
+  {{-0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{ 0.5f,  0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{ 0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{ 0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{ 0.5f, -0.5f,  0.5f}, {0.0f, 0.0f}},
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{ 0.5f, -0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{ 0.5f, -0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{ 0.5f, -0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{-0.5f, -0.5f,  0.5f}, {0.0f, 0.0f}},
+  {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}},
+
+  {{-0.5f,  0.5f, -0.5f}, {0.0f, 1.0f}},
+  {{ 0.5f,  0.5f, -0.5f}, {1.0f, 1.0f}},
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{ 0.5f,  0.5f,  0.5f}, {1.0f, 0.0f}},
+  {{-0.5f,  0.5f,  0.5f}, {0.0f, 0.0f}},
+  {{-0.5f,  0.5f, -0.5f}, {0.0f, 1.0f}}
 };
 
-constexpr glm::vec3 kCubePositions[] = {
-  glm::vec3( 0.0f,  0.0f,  0.0f), 
-  glm::vec3( 2.0f,  5.0f, -15.0f), 
-  glm::vec3(-1.5f, -2.2f, -2.5f),  
-  glm::vec3(-3.8f, -2.0f, -12.3f),  
-  glm::vec3( 2.4f, -0.4f, -3.5f),  
-  glm::vec3(-1.7f,  3.0f, -7.5f),  
-  glm::vec3( 1.3f, -2.0f, -2.5f),  
-  glm::vec3( 1.5f,  2.0f, -2.5f), 
-  glm::vec3( 1.5f,  0.2f, -1.5f), 
-  glm::vec3(-1.3f,  1.0f, -1.5f)  
-};
 // clang-format on
+
+// Size of the generated checkerboard textures, in texels
+constexpr int kCheckerTextureSize = 64;
+constexpr int kCheckerTileSize = 8;
+// Transforms sampled to measure the batch kernels' error at startup
+constexpr size_t kKernelErrorSampleCount = 1024;
+// Default transforms checked to build identity matrices, enough to cover a
+// full AVX2 batch and the scalar tail
+constexpr size_t kDefaultTransformCheckCount = 9;
+// Visible instances per job at least when building instance data, as smaller
+// ranges cost more to schedule than they save
+constexpr size_t kInstanceRangeSize = 2048;
+// Draw sort key fields of the scene's objects. There is one pass and one
+// program so far.
+constexpr uint8_t kScenePass = 0;
+constexpr uint8_t kDefaultProgram = 0;
+
+// Builds mesh variant index of a generated scene: the cube, then UV spheres of
+// increasing detail, so each variant is a distinct vertex and index buffer
+MeshData BuildMeshVariant(uint32_t index) {
+  if (index == 0) { return BuildIndexedMesh(kCubeVertices); }
+  const uint32_t segments = std::min(4 + 2 * index, 64u);
+  return BuildIndexedMesh(BuildSphereTriangles(segments, segments / 2));
+}
+
+// The text of an asset in the archive, if there is an archive and it has the
+// asset. Compressed assets are decompressed into buffer.
+std::optional<std::string_view> ReadArchivedText(
+  const AssetArchive* archive,
+  std::string_view name,
+  std::vector<uint8_t>& buffer
+) {
+  if (archive == nullptr) { return std::nullopt; }
+  const std::optional<std::span<const uint8_t>> data =
+    archive->Read(name, buffer);
+  if (!data) { return std::nullopt; }
+  return std::string_view(
+    reinterpret_cast<const char*>(data->data()), data->size()
+  );
+}
+
+// Loads the cooked version of an image if the build made one, otherwise
+// decodes the image itself. Either comes from the asset archive if it has
+// them, or else from loose files.
+TextureLoader::Handle LoadTexture(
+  TextureLoader& loader,
+  const AssetArchive* archive,
+  std::string_view imageName,
+  bool flipVertically = false
+) {
+  const std::string cookedName =
+    std::filesystem::path(imageName).stem().string() + TextureFile::kExtension;
+  if (archive != nullptr) {
+    const std::string archivedCookedName =
+      std::string(kArchiveCookedPrefix) + cookedName;
+    if (archive->Contains(archivedCookedName)) {
+      return loader.Load(*archive, archivedCookedName);
+    }
+    if (archive->Contains(imageName)) {
+      SDL_Log(
+        "No cooked texture for %s in the asset archive, decoding it",
+        std::string(imageName).c_str()
+      );
+      return loader.Load(*archive, std::string(imageName), flipVertically);
+    }
+  }
+
+  const std::filesystem::path cookedPath = kCookedDir / cookedName;
+  const std::filesystem::path imagePath = kAssetsDir / imageName;
+  std::error_code error;
+  if (std::filesystem::exists(cookedPath, error)) {
+    return loader.Load(cookedPath);
+  }
+  SDL_Log(
+    "No cooked texture at %s, decoding %s",
+    cookedPath.string().c_str(),
+    imagePath.string().c_str()
+  );
+  return loader.Load(imagePath, flipVertically);
+}
+
+// Builds the RGBA pixels of texture variant index of a generated scene: a
+// checkerboard of white and a color picked from the index
+std::vector<uint8_t> BuildCheckerPixels(uint32_t index) {
+  // Spread hues by the golden angle so neighbouring indices differ
+  const float hue = glm::fract(index * 0.381966f);
+  const glm::vec3 color = glm::clamp(
+    glm::abs(glm::mod(hue * 6.0f + glm::vec3(0.0f, 4.0f, 2.0f), 6.0f) - 3.0f) -
+      1.0f,
+    0.0f,
+    1.0f
+  );
+  std::vector<uint8_t> texels(kCheckerTextureSize * kCheckerTextureSize * 4);
+  for (int y = 0; y < kCheckerTextureSize; ++y) {
+    for (int x = 0; x < kCheckerTextureSize; ++x) {
+      const bool white = (x / kCheckerTileSize + y / kCheckerTileSize) % 2 == 0;
+      const glm::vec3 texel = white ? glm::vec3(1.0f) : color;
+      uint8_t* out = &texels[(y * kCheckerTextureSize + x) * 4];
+      for (int channel = 0; channel < 3; ++channel) {
+        out[channel] = static_cast<uint8_t>(texel[channel] * 255.0f);
+      }
+      out[3] = 255;
+    }
+  }
+  return texels;
+}
+
+// Estimated size in pixels across of an object on screen, which its textures
+// span. Errs large, towards sharper textures.
+float GetScreenSize(
+  const AABB& bounds, const Camera& camera, float pixelsPerUnitAtOne
+) {
+  const glm::vec3 extent = bounds.max - bounds.min;
+  const float size = std::max({extent.x, extent.y, extent.z});
+  const float distance = std::max(
+    glm::distance(bounds.GetCenter(), camera.position), camera.nearPlane
+  );
+  return size / distance * pixelsPerUnitAtOne;
+}
 }  // namespace
 
+// Uniform handles of the default shader, resolved once after it is linked
+struct DefaultShaderUniforms {
+  UniformHandle<float> time;
+  UniformHandle<glm::mat4> view;
+  UniformHandle<glm::mat4> projection;
+};
+
 struct AppState {
   SDL_Window* window;
   // Previous tick (Nanoseconds since SDL was initialized) that was processed by
@@ -106,11 +255,196 @@ struct AppState {
   uint64_t previousTickNs;
   uint64_t previousFrameTimeNs;
   SDL_GLContext glContext;
+  // The shader, meshes, textures, instance buffer, GPU timer and texture
+  // loader are GL resources, used only by the render thread once it runs
   Shader* shader;
+  DefaultShaderUniforms uniforms;
   std::unique_ptr<Camera> camera;
+  // Indexed by the scene's mesh ids
+  std::vector<std::unique_ptr<Mesh>> meshes;
+  // Texture arrays the scene's textures are layers of. Indexed by texture id,
+  // textureBatches holds the array and textureLayers the layer.
+  std::vector<TextureLoader::Handle> textureArrays;
+  std::vector<uint16_t> textureBatches;
+  std::vector<uint32_t> textureLayers;
+  std::unique_ptr<InstanceBuffer> instanceBuffer;
+  std::unique_ptr<GpuTimer> gpuTimer;
+  // Objects to render, animated in place each frame
+  Scene scene;
+  // Hierarchy over the scene's bounds for culling and picking
+  BVH sceneBVH;
+  // Per-frame culling output: indices of the objects in the view frustum, a
+  // draw command per visible object, recorded by the jobs and sorted by key,
+  // the objects in that order and their transforms, and the draw calls the
+  // sorted commands collapse into
+  std::vector<uint32_t> visibleObjects;
+  DrawCommandList drawCommands;
+  std::vector<uint32_t> sortedVisibleObjects;
+  TransformBatch visibleTransforms;
+  std::vector<DrawCall> drawCalls;
+  // Scratch storage for the size of each visible object on screen
+  std::vector<float> instanceScreenSizes;
+  // Object under the cursor at the last left click
+  std::optional<BVH::RayHit> pickedObject;
+  // Toggled with F1
+  ProfilerWindow profilerWindow;
+  // Interval between consecutive frames, written out on exit
+  FrameStats frameStats;
+  // Toggled with F3
+  FrameStatsWindow frameStatsWindow;
+  // Only set in benchmark mode
+  std::unique_ptr<Benchmark> benchmark;
+  // Null if the archive failed to open and assets are loose files. Declared
+  // before the loader, which reads it from its workers.
+  std::unique_ptr<AssetArchive> assetArchive;
+  // Runs the frame's CPU work and decodes textures off the main thread. The
+  // loader is declared after it so it is destroyed first, while its decodes
+  // can still finish.
+  std::unique_ptr<JobSystem> jobSystem;
+  std::unique_ptr<TextureLoader> textureLoader;
+  // Bound to unit 1, blended over the scene's textures
+  TextureLoader::Handle awesomeFaceTexture;
+  // Renders the packets the frames build. Started last, as it takes the GL
+  // context.
+  std::unique_ptr<RenderThread> renderThread;
 };
 
+namespace {
+// Draws a frame the simulation built. Runs on the render thread, or on the
+// main thread with 0 frames in flight.
+void RenderFrame(AppState& state, RenderPacket& packet) {
+  LIZUAL_PROFILE_SCOPE("RenderFrame");
+  const uint64_t startNs = Profiler::Now();
+  GLStats::BeginFrame();
+  state.gpuTimer->BeginFrame();
+  GLState::Viewport(0, 0, packet.viewportWidth, packet.viewportHeight);
+
+  // Ask for the texture detail each draw call needs. The face texture is
+  // blended over every object.
+  TextureLoader& textureLoader = *state.textureLoader;
+  textureLoader.Update();
+  float largestSize = 0.0f;
+  for (size_t i = 0; i < packet.drawCalls.size(); ++i) {
+    textureLoader.RequestSize(
+      state.textureArrays[packet.drawCalls[i].texture],
+      packet.drawScreenSizes[i]
+    );
+    largestSize = std::max(largestSize, packet.drawScreenSizes[i]);
+  }
+  textureLoader.RequestSize(state.awesomeFaceTexture, largestSize);
+
+  // Time is seconds since the start of the program
+  state.shader->Set(state.uniforms.time, packet.timeSeconds);
+  state.shader->Set(state.uniforms.view, packet.view);
+  state.shader->Set(state.uniforms.projection, packet.projection);
+  {
+    LIZUAL_PROFILE_SCOPE("Draw objects");
+    GpuTimerScope gpuScope(*state.gpuTimer, "Scene");
+    glClearColor(0.75f, 0.75f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // One instanced draw per run of sorted commands, all from a single
+    // upload. Sorting put draws with the same program and texture next to
+    // each other, so GLState drops most of their binds.
+    state.instanceBuffer->Upload(
+      packet.modelMatrices, packet.instanceTextureLayers
+    );
+    GLState::ActiveTexture(GL_TEXTURE1);
+    GLState::BindTexture(
+      GL_TEXTURE_2D_ARRAY, textureLoader.GetTexture(state.awesomeFaceTexture)
+    );
+    GLState::ActiveTexture(GL_TEXTURE0);
+    for (const DrawCall& draw : packet.drawCalls) {
+      // The default shader is program 0, and the only one so far
+      state.shader->Use();
+      GLState::BindTexture(
+        GL_TEXTURE_2D_ARRAY,
+        textureLoader.GetTexture(state.textureArrays[draw.texture])
+      );
+      const Mesh& mesh = *state.meshes[draw.mesh];
+      state.instanceBuffer->SetFirstInstance(
+        mesh.GetVertexArray(), draw.firstInstance
+      );
+      mesh.DrawInstanced(static_cast<GLsizei>(draw.instanceCount));
+    }
+  }
+
+  {
+    LIZUAL_PROFILE_SCOPE("Render UI");
+    GpuTimerScope gpuScope(*state.gpuTimer, "ImGui");
+    packet.ui.Render();
+    // The backend sets GL state directly, restoring most but not all of it
+    GLState::Invalidate();
+  }
+
+  {
+    LIZUAL_PROFILE_SCOPE("Swap");
+    SDL_GL_SwapWindow(state.window);
+  }
+
+  RenderFeedback& feedback = packet.feedback;
+  feedback.gpu = state.gpuTimer->GetResults();
+  feedback.textureResidentBytes = textureLoader.GetResidentBytes();
+  feedback.textureResidencyBudget = textureLoader.GetResidencyBudget();
+  feedback.texturesLoading = textureLoader.GetPendingCount();
+  feedback.renderCpuMs =
+    static_cast<double>(Profiler::Now() - startNs) / SDL_NS_PER_MS;
+  feedback.glStats = GLStats::GetFrame();
+}
+}  // namespace
+
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
+  Profiler::SetThreadName("Main");
+  LIZUAL_PROFILE_SCOPE("SDL_AppInit");
+  const uint64_t initStartNs = Profiler::Now();
+
+  // Map the asset archive, which serves the assets below without opening each
+  // file
+  std::unique_ptr<AssetArchive> assetArchive;
+  {
+    std::string error;
+    std::optional<AssetArchive> archive =
+      AssetArchive::Open(kAssetArchivePath, error);
+    if (archive) {
+      assetArchive = std::make_unique<AssetArchive>(std::move(*archive));
+      SDL_Log(
+        "Reading assets from %s (%zu files)",
+        kAssetArchivePath.string().c_str(),
+        assetArchive->GetEntryCount()
+      );
+    } else {
+      SDL_Log("Reading loose asset files: %s", error.c_str());
+    }
+  }
+
+  // Load config. Command line arguments override the file. Loaded before SDL
+  // is initialized because benchmark mode picks the video driver.
+  std::vector<uint8_t> configBuffer;
+  if (const std::optional<std::string_view> configText =
+        ReadArchivedText(assetArchive.get(), kConfigName, configBuffer)) {
+    load_config_from_memory(*configText, kConfigName);
+  } else {
+    load_config_from_file(kAssetsDir / kConfigName);
+  }
+  load_config_from_args(argc, argv);
+
+  // Start the workers before anything that spreads work over them
+  std::unique_ptr jobSystem = std::make_unique<JobSystem>(JobSystemSettings{
+    config::job_worker_count, config::job_pin_threads, config::job_first_core
+  });
+  if (config::job_pin_threads) {
+    SDL_Log(
+      "Job system: %zu threads, pinned from core %u",
+      jobSystem->GetThreadCount(),
+      config::job_first_core
+    );
+  } else {
+    SDL_Log("Job system: %zu threads", jobSystem->GetThreadCount());
+  }
+
+  // Benchmarks render into an offscreen EGL context, which needs no display
+  // and works with Mesa's surfaceless platform and llvmpipe
+  if (config::benchmark) { SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen"); }
+
   // Initialize SDL
   if (!SDL_Init(SDL_INIT_VIDEO)) {
     SDL_LogCritical(
@@ -119,13 +453,13 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
     return SDL_APP_FAILURE;
   }
   SDL_Log("SDL initialized successfully");
+  SDL_Log("  Video driver: %s", SDL_GetCurrentVideoDriver());
 
-  // Load config
-  load_config_from_file(kConfigPath);
-
-  // Limit FPS temporarily so my laptop doesn't burn my legs
+  // Limit FPS temporarily so my laptop doesn't burn my legs. Benchmarks run
+  // uncapped (a rate of 0).
   SDL_SetHint(
-    SDL_HINT_MAIN_CALLBACK_RATE, std::to_string(config::update_rate).c_str()
+    SDL_HINT_MAIN_CALLBACK_RATE,
+    config::benchmark ? "0" : std::to_string(config::update_rate).c_str()
   );
 
   // Set OpenGL version attributes, necessary for MacOSX, otherwise it will
@@ -134,12 +468,20 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-  SDL_Window* window = SDL_CreateWindow(
-    "Lizual",
-    kDefaultWindowWidth,
-    kDefaultWindowHeight,
-    SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE
-  );
+  SDL_Window* window =
+    config::benchmark
+      ? SDL_CreateWindow(
+          "Lizual",
+          static_cast<int>(config::benchmark_width),
+          static_cast<int>(config::benchmark_height),
+          SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+        )
+      : SDL_CreateWindow(
+          "Lizual",
+          kDefaultWindowWidth,
+          kDefaultWindowHeight,
+          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE
+        );
   if (window == nullptr) {
     SDL_LogCritical(
       SDL_LOG_CATEGORY_ERROR,
@@ -166,6 +508,12 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   const int minor = GLAD_VERSION_MINOR(version);
   SDL_Log("OpenGL version: %d.%d", major, minor);
   SDL_Log("  Full version string: %s", glGetString(GL_VERSION));
+  SDL_Log("  Renderer: %s", glGetString(GL_RENDERER));
+
+  // Don't wait for vertical sync when benchmarking
+  if (config::benchmark && !SDL_GL_SetSwapInterval(0)) {
+    SDL_Log("SDL_GL_SetSwapInterval(0) failed: %s", SDL_GetError());
+  }
 
   // Set the default viewport size
   int widthInPixels;
@@ -178,14 +526,14 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
     );
     return SDL_APP_FAILURE;
   }
-  glViewport(0, 0, widthInPixels, heightInPixels);
+  GLState::Viewport(0, 0, widthInPixels, heightInPixels);
 
   // Enable blending so I can test transparency
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GLState::SetEnabled(GL_BLEND, true);
+  GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   // Enable Depth testing so we don't get behind fragments drawn in front
-  glEnable(GL_DEPTH_TEST);
+  GLState::SetEnabled(GL_DEPTH_TEST, true);
 
   // Set up imgui
   IMGUI_CHECKVERSION();
@@ -204,23 +552,104 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   // Setup Platform/Renderer backends
   ImGui_ImplSDL3_InitForOpenGL(window, glContext);
   ImGui_ImplOpenGL3_Init();
+  // Creates the backend's device objects while this thread has the context.
+  // Frames after this only draw with them, on the render thread.
+  ImGui_ImplOpenGL3_NewFrame();
 
-  // Create a vertex array object (VAO) for the rectangle
-  GLuint vao;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+  // Generate the scene
+  SceneDistribution distribution = SceneDistribution::kClassic;
+  if (const std::optional<SceneDistribution> parsed =
+        ParseSceneDistribution(config::scene_distribution)) {
+    distribution = *parsed;
+  } else {
+    SDL_Log(
+      "Unknown scene distribution (%s), using classic",
+      config::scene_distribution.c_str()
+    );
+  }
+  uint64_t stepStartNs = Profiler::Now();
+  Scene scene = Scene::Generate({
+    distribution,
+    config::scene_object_count,
+    config::scene_animated_fraction,
+    config::scene_mesh_count,
+    config::scene_texture_count,
+    config::scene_seed,
+  });
+  const double sceneGenerateMs =
+    static_cast<double>(Profiler::Now() - stepStartNs) / SDL_NS_PER_MS;
+  stepStartNs = Profiler::Now();
+  BVH sceneBVH;
+  sceneBVH.Build(scene.GetBounds(), jobSystem.get());
+  const double sceneBVHBuildMs =
+    static_cast<double>(Profiler::Now() - stepStartNs) / SDL_NS_PER_MS;
+  const SceneSettings& sceneSettings = scene.GetSettings();
+  SDL_Log(
+    "Scene (%s): %zu objects, %zu animated, %u meshes, %u textures, %.1f MB",
+    GetSceneDistributionName(sceneSettings.distribution),
+    scene.Size(),
+    scene.GetAnimatedCount(),
+    sceneSettings.meshCount,
+    sceneSettings.textureCount,
+    static_cast<double>(scene.GetMemoryUsage()) / (1024.0 * 1024.0)
+  );
+  SDL_Log(
+    "  Generated in %.2f ms, BVH of %zu nodes built in %.2f ms",
+    sceneGenerateMs,
+    sceneBVH.GetNodeCount(),
+    sceneBVHBuildMs
+  );
 
-  // Create a vertex buffer object (VBO) for the rectangle
-  GLuint vbo;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(kVertices), kVertices, GL_STATIC_DRAW);
+  // Build the meshes into deduplicated, cache-optimized indexed meshes. The
+  // first is the cube.
+  std::vector<std::unique_ptr<Mesh>> meshes;
+  for (uint32_t i = 0; i < sceneSettings.meshCount; ++i) {
+    const MeshData meshData = BuildMeshVariant(i);
+    if (i == 0) {
+      SDL_Log(
+        "Built cube mesh: %zu vertices -> %zu unique, ACMR %.2f",
+        std::size(kCubeVertices),
+        meshData.vertices.size(),
+        ComputeAverageCacheMissRatio(
+          meshData.indices, meshData.vertices.size()
+        )
+      );
+    }
+    meshes.push_back(std::make_unique<Mesh>(meshData));
+  }
 
   // Create the shader
   // remember to have a try catch block for handling file read exceptions
   Shader* shader;
+  DefaultShaderUniforms uniforms;
   try {
-    shader = new Shader(kVertexShaderPath, kFragmentShaderPath);
+    const ProgramBinaryCache binaryCache(
+      std::filesystem::path(SDL_GetBasePath()) / "shader_cache"
+    );
+    std::vector<uint8_t> vertexBuffer;
+    std::vector<uint8_t> fragmentBuffer;
+    const std::optional<std::string_view> vertexSource =
+      ReadArchivedText(assetArchive.get(), kVertexShaderName, vertexBuffer);
+    const std::optional<std::string_view> fragmentSource = ReadArchivedText(
+      assetArchive.get(), kFragmentShaderName, fragmentBuffer
+    );
+    if (vertexSource && fragmentSource) {
+      shader = new Shader(
+        ShaderSources{*vertexSource, *fragmentSource}, {}, &binaryCache
+      );
+    } else {
+      shader = new Shader(
+        kAssetsDir / kVertexShaderName,
+        kAssetsDir / kFragmentShaderName,
+        {},
+        &binaryCache
+      );
+    }
+    uniforms = {
+      shader->GetUniform<float>("uTime"),
+      shader->GetUniform<glm::mat4>("uView"),
+      shader->GetUniform<glm::mat4>("uProjection"),
+    };
   } catch (const std::ifstream::failure& e) {
     SDL_LogCritical(
       SDL_LOG_CATEGORY_ERROR, "Failed to read shader file: %s", e.what()
@@ -234,95 +663,128 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   }
   shader->Use();
 
-  // Set the vertex attribute pointers
-  int stride = 5 * sizeof(float);
-  // position
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-  glEnableVertexAttribArray(0);
-  // texture coords
-  glVertexAttribPointer(
-    1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))
-  );
-  glEnableVertexAttribArray(1);
-
-  // Load the container texture
-  SDL_Log("Loading container texture");
-  int width, height, numChannels;
-  unsigned char* data = stbi_load(
-    kContainerTexturePath.string().c_str(), &width, &height, &numChannels, 0
-  );
-  if (data == nullptr) {
-    SDL_LogCritical(
-      SDL_LOG_CATEGORY_APPLICATION,
-      "[stb_image] Failed to load texture from path %s",
-      kContainerTexturePath.c_str()
-    );
-    return SDL_APP_FAILURE;
+  // Model matrices are streamed per instance
+  std::unique_ptr instanceBuffer = std::make_unique<InstanceBuffer>();
+  for (const std::unique_ptr<Mesh>& mesh : meshes) {
+    instanceBuffer->AttachToVertexArray(mesh->GetVertexArray());
   }
-  SDL_Log("  Loaded container texture: %d x %d", width, height);
 
-  // Create an OpenGL texture
-  GLuint textureId;
-  glGenTextures(1, &textureId);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, textureId);
-  glTexImage2D(
-    GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
+  // Decode the textures in background jobs. Until they are uploaded, draws
+  // sample the loader's placeholder.
+  std::unique_ptr textureLoader =
+    std::make_unique<TextureLoader>(
+      *jobSystem, static_cast<size_t>(config::texture_budget_mb) << 20
+    );
+  SDL_Log(
+    "Loading textures, %u MB resident at most", config::texture_budget_mb
   );
-  glGenerateMipmap(GL_TEXTURE_2D);
-  shader->SetInt("uTexture", 0);
-
-  // Free the image
-  stbi_image_free(data);
-
-  // Load the awesome face texture
-  SDL_Log("Loading awesome face texture");
+  // The scene's first texture is the container, the rest are generated. The
+  // generated ones all have one size, so they are packed into texture arrays
+  // and objects with different textures share draws. Arrays are bound to unit
+  // 0 per draw group, and each instance picks its layer.
+  std::vector<TextureLoader::Handle> textureArrays{
+    LoadTexture(*textureLoader, assetArchive.get(), kContainerTextureName)
+  };
+  std::vector<uint16_t> textureBatches{0};
+  std::vector<uint32_t> textureLayers{0};
+  {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    TextureArrayAllocator allocator(static_cast<uint32_t>(maxLayers));
+    const size_t firstArray = textureArrays.size();
+    for (uint32_t i = 1; i < sceneSettings.textureCount; ++i) {
+      const std::optional<TextureArrayAllocator::Slot> slot = allocator.Add(
+        kCheckerTextureSize, kCheckerTextureSize, BuildCheckerPixels(i)
+      );
+      if (!slot) {
+        // Draw with the container instead
+        textureBatches.push_back(0);
+        textureLayers.push_back(0);
+        continue;
+      }
+      textureBatches.push_back(static_cast<uint16_t>(firstArray + slot->array));
+      textureLayers.push_back(slot->layer);
+    }
+    const std::vector<TextureLoader::Handle> arrays =
+      allocator.Load(*textureLoader);
+    textureArrays.insert(textureArrays.end(), arrays.begin(), arrays.end());
+  }
   // Flip vertically because it's inversed by default
-  stbi_set_flip_vertically_on_load(true);
-  unsigned char* data2 = stbi_load(
-    kAwesomeFaceTexturePath.string().c_str(), &width, &height, &numChannels, 0
-  );
-  stbi_set_flip_vertically_on_load(false);
-  if (data == nullptr) {
-    SDL_LogCritical(
-      SDL_LOG_CATEGORY_APPLICATION,
-      "[stb_image] Failed to load texture from path %s",
-      kContainerTexturePath.string().c_str()
+  const TextureLoader::Handle awesomeFaceTexture =
+    LoadTexture(
+      *textureLoader, assetArchive.get(), kAwesomeFaceTextureName, true
     );
-    return SDL_APP_FAILURE;
-  }
-  SDL_Log("  Loaded awesome face texture: %d x %d", width, height);
-
-  // Create an OpenGL texture
-  GLuint textureId2;
-  glGenTextures(1, &textureId2);
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, textureId2);
-  glTexImage2D(
-    GL_TEXTURE_2D,
-    0,
-    GL_RGBA,
-    width,
-    height,
-    0,
-    GL_RGBA,
-    GL_UNSIGNED_BYTE,
-    data2
-  );
-  glGenerateMipmap(GL_TEXTURE_2D);
+  shader->SetInt("uTexture", 0);
   shader->SetInt("uTexture2", 1);
 
-  // Free the image
-  stbi_image_free(data2);
-
   // learnopengl/textures/exercises/4: use a uniform to mix
   // Initialize the mix uniform
   shader->SetFloat("uMix", 0.2f);
 
+  // Checking every transform would double the memory of large scenes
+  std::vector<uint32_t> kernelSample(
+    std::min(scene.Size(), kKernelErrorSampleCount)
+  );
+  std::iota(kernelSample.begin(), kernelSample.end(), 0u);
+  TransformBatch kernelSampleTransforms;
+  kernelSampleTransforms.Gather(scene.GetTransforms(), kernelSample);
+  const SimdLevel simdLevel = GetSupportedSimdLevel();
+  SDL_Log(
+    "Transform kernel: %s (max error vs. glm: %g)",
+    GetSimdLevelName(simdLevel),
+    MeasureModelMatrixError(kernelSampleTransforms, simdLevel)
+  );
+  // Resized transforms are documented to be the identity
+  TransformBatch defaultTransforms;
+  defaultTransforms.Resize(kDefaultTransformCheckCount);
+  std::vector<glm::mat4> defaultMatrices(kDefaultTransformCheckCount);
+  BuildModelMatrices(
+    defaultTransforms,
+    0,
+    kDefaultTransformCheckCount,
+    defaultMatrices.data(),
+    simdLevel
+  );
+  for (const glm::mat4& matrix : defaultMatrices) {
+    if (matrix != glm::mat4(1.0f)) {
+      SDL_Log("Transform kernel: Default transforms aren't the identity");
+      break;
+    }
+  }
+
   // Configure Camera
   std::unique_ptr camera =
     std::make_unique<Camera>(glm::vec3(0.0f, 0.0f, 3.0f));
 
+  // Benchmarks measure the fully loaded scene, so include the texture loads in
+  // the startup time
+  if (config::benchmark) { textureLoader->Finish(); }
+
+  const double startupMs =
+    static_cast<double>(Profiler::Now() - initStartNs) / SDL_NS_PER_MS;
+  SDL_Log("Startup took %.2f ms", startupMs);
+
+  std::unique_ptr<Benchmark> benchmark;
+  if (config::benchmark) {
+    benchmark = std::make_unique<Benchmark>(Benchmark::Settings{
+      config::benchmark_warmup_frames,
+      config::benchmark_frames,
+      config::frame_budget_ms,
+      config::benchmark_width,
+      config::benchmark_height,
+      scene.GetCenter(),
+      sceneSettings,
+      scene.GetMemoryUsage(),
+      startupMs,
+      config::render_frames_in_flight,
+    });
+    SDL_Log(
+      "Benchmarking %u frames after %u warmup frames",
+      config::benchmark_frames,
+      config::benchmark_warmup_frames
+    );
+  }
+
   uint64_t lastTick = SDL_GetTicksNS();
   *appstate = new AppState{
     window,
@@ -330,34 +792,86 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
     static_cast<uint64_t>(0),
     glContext,
     shader,
-    std::move(camera)
+    uniforms,
+    std::move(camera),
+    std::move(meshes),
+    std::move(textureArrays),
+    std::move(textureBatches),
+    std::move(textureLayers),
+    std::move(instanceBuffer),
+    std::make_unique<GpuTimer>(),
+    std::move(scene),
+    std::move(sceneBVH),
+    {},
+    DrawCommandList(jobSystem->GetThreadCount()),
+    {},
+    {},
+    {},
+    {},
+    std::nullopt,
+    {},
+    FrameStats(config::frame_budget_ms),
+    {},
+    std::move(benchmark),
+    std::move(assetArchive),
+    std::move(jobSystem),
+    std::move(textureLoader),
+    awesomeFaceTexture,
+    nullptr
   };
+  AppState* state = static_cast<AppState*>(*appstate);
+  state->renderThread = std::make_unique<RenderThread>(
+    window,
+    glContext,
+    config::render_frames_in_flight,
+    [state](RenderPacket& packet) { RenderFrame(*state, packet); }
+  );
+  SDL_Log(
+    "Rendering %s, %u frames in flight",
+    config::render_frames_in_flight > 0 ? "on a render thread"
+                                        : "on the main thread",
+    config::render_frames_in_flight
+  );
   SDL_Log("App initialization complete");
 
   return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppIterate(void* appstate) {
+  Profiler::BeginFrame();
+  LIZUAL_PROFILE_SCOPE("SDL_AppIterate");
   const uint64_t perfCounterStart = SDL_GetPerformanceCounter();
   AppState* state = static_cast<AppState*>(appstate);
+  if (state->renderThread->HasFailed()) { return SDL_APP_FAILURE; }
+  // Waits while all packets are in flight. Its feedback is the latest the
+  // render thread has sent, copied as the packet is refilled below.
+  RenderPacket& packet = state->renderThread->BeginPacket();
+  const RenderFeedback feedback = packet.feedback;
   const uint64_t currentTickNs = SDL_GetTicksNS();
+  // Benchmarks animate with a fixed time step so every run is the same
   const float currentTickSeconds =
-    static_cast<float>(currentTickNs) / static_cast<float>(SDL_NS_PER_SECOND);
+    state->benchmark != nullptr
+      ? state->benchmark->GetTime()
+      : static_cast<float>(currentTickNs) /
+          static_cast<float>(SDL_NS_PER_SECOND);
   const uint64_t deltaTicksNs = currentTickNs - state->previousTickNs;
+  state->frameStats.Record(deltaTicksNs);
+  const FrameStats::Summary frameSummary = state->frameStats.ComputeSummary();
   const float deltaTimeSeconds =
     static_cast<float>(deltaTicksNs) / static_cast<float>(SDL_NS_PER_SECOND);
 
   // -- Get Input
   const bool* keys = SDL_GetKeyboardState(nullptr);
 
-  // Start the Dear ImGui frame
-  ImGui_ImplOpenGL3_NewFrame();
+  // Start the Dear ImGui frame. The OpenGL backend's device objects were
+  // created at startup, and it only draws on the render thread.
   ImGui_ImplSDL3_NewFrame();
   ImGui::NewFrame();
 
   // Show a simple window that we create ourselves. We use a Begin/End pair
   // to create a named window.
   {
+    LIZUAL_PROFILE_SCOPE("Build overlay");
     ImGui::SetNextWindowPos(ImVec2(0, 0));
     ImGui::SetNextWindowSize(ImVec2(0, 0));
     ImGui::Begin(
@@ -373,9 +887,71 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
       io.Framerate,
       state->previousFrameTimeNs / static_cast<float>(SDL_NS_PER_MS)
     );
+    ImGui::Text(
+      "p99 %.2f ms, max %.2f ms, %zu over budget",
+      frameSummary.p99Ms,
+      frameSummary.maxMs,
+      frameSummary.overBudgetCount
+    );
+    ImGui::Text(
+      "Render %.3f ms/f, %u frames in flight",
+      feedback.renderCpuMs,
+      state->renderThread->GetFramesInFlight()
+    );
+    // GPU results lag a few frames behind, and come with the CPU times of the
+    // same frame
+    ImGui::Text("GPU %.3f ms/f", feedback.gpu.frameGpuMs);
+    for (const GpuTimer::PassTime& pass : feedback.gpu.passTimes) {
+      ImGui::Text(
+        "  %-6s cpu %.3f ms, gpu %.3f ms", pass.name, pass.cpuMs, pass.gpuMs
+      );
+    }
+    // GL work of the frame the feedback is from, not counting the UI
+    const GLStats::Frame& gl = feedback.glStats;
+    ImGui::Text(
+      "%llu draw calls, %llu instances, %llu triangles",
+      static_cast<unsigned long long>(gl.drawCalls),
+      static_cast<unsigned long long>(gl.instances),
+      static_cast<unsigned long long>(gl.triangles)
+    );
+    ImGui::Text(
+      "State changes %llu (%llu elided), uniforms %llu (%llu elided)",
+      static_cast<unsigned long long>(gl.stateChanges),
+      static_cast<unsigned long long>(gl.stateChangesElided),
+      static_cast<unsigned long long>(gl.uniformUpdates),
+      static_cast<unsigned long long>(gl.uniformUpdatesElided)
+    );
+    ImGui::Text(
+      "Uploaded %.1f KB buffers, %.1f KB textures",
+      static_cast<double>(gl.bufferBytesUploaded) / 1024.0,
+      static_cast<double>(gl.textureBytesUploaded) / 1024.0
+    );
+    // Culling results of the previous frame
+    ImGui::Text(
+      "%zu / %zu visible, %zu draws",
+      state->visibleObjects.size(),
+      state->scene.Size(),
+      state->drawCalls.size()
+    );
+    ImGui::Text(
+      "Textures %.1f / %.1f MB, %zu loading",
+      static_cast<double>(feedback.textureResidentBytes) / (1024.0 * 1024.0),
+      static_cast<double>(feedback.textureResidencyBudget) / (1024.0 * 1024.0),
+      feedback.texturesLoading
+    );
+    if (state->pickedObject) {
+      ImGui::Text(
+        "Picked object %u at %.2f",
+        state->pickedObject->object,
+        state->pickedObject->distance
+      );
+    }
+    ImGui::TextDisabled("F1: profiler, F2: save trace, F3: frame times");
 
     ImGui::End();
   }
+  state->profilerWindow.Draw();
+  state->frameStatsWindow.Draw(state->frameStats, frameSummary);
 
   // -- Update state
   // Update Camera based on input
@@ -406,46 +982,136 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
     (-1 * keys[SDL_SCANCODE_W]) + keys[SDL_SCANCODE_S],
   };
   camera.Move(positionDelta * speed * deltaTimeSeconds);
-
-  // Time is seconds since the start of the program
-  state->shader->SetFloat("uTime", currentTickSeconds);
+  if (state->benchmark != nullptr) {
+    state->benchmark->ApplyCameraPath(camera);
+  }
 
   // Create Model-View-Projection (MVP) matrices
-  glm::mat4 model = glm::mat4(1.0f);
   glm::mat4 view = state->camera->GetViewMatrix();
 
   int windowWidth, windowHeight;
   SDL_GetWindowSizeInPixels(state->window, &windowWidth, &windowHeight);
   float windowAspectRatio = (float)windowWidth / windowHeight;
-  glm::mat4 projection =
-    glm::perspective(glm::radians(45.0f), windowAspectRatio, 0.1f, 100.0f);
-
-  state->shader->SetUniformMatrix4fv("uView", view);
-  state->shader->SetUniformMatrix4fv("uProjection", projection);
-
-  // -- Render
-  glClearColor(0.75f, 0.75f, 1.0f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  // Draw a bunch of cubes
-  uint32_t numCubes = sizeof(kCubePositions) / sizeof(kCubePositions[0]);
-  for (uint32_t i = 0; i < numCubes; i++) {
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, kCubePositions[i]);
-    float angle = 20.0f * i;
-    model = glm::rotate(
-      model,
-      glm::radians(angle + (currentTickSeconds * 50.0f)),
-      glm::vec3(1.0f, 0.3f, 0.5f)
-    );
-    state->shader->SetUniformMatrix4fv("uModel", model);
-
-    glDrawArrays(GL_TRIANGLES, 0, sizeof(kVertices) / sizeof(kVertices[0]));
+  glm::mat4 projection = camera.GetProjectionMatrix(windowAspectRatio);
+
+  // -- Build the render packet
+  packet.timeSeconds = currentTickSeconds;
+  packet.view = view;
+  packet.projection = projection;
+  packet.viewportWidth = windowWidth;
+  packet.viewportHeight = windowHeight;
+  JobSystem& jobs = *state->jobSystem;
+  if (state->scene.Animate(currentTickSeconds, &jobs)) {
+    LIZUAL_PROFILE_SCOPE("Refit BVH");
+    state->sceneBVH.Refit(state->scene.GetBounds());
   }
 
-  ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  // Cull against the view frustum, then record a draw command per visible
+  // object and sort them, so objects that need the same state are drawn
+  // together
+  {
+    LIZUAL_PROFILE_SCOPE("Cull");
+    state->visibleObjects.clear();
+    state->sceneBVH.QueryFrustum(
+      camera.GetFrustum(windowAspectRatio), state->visibleObjects
+    );
+  }
+  const size_t numVisible = state->visibleObjects.size();
+  std::span<const DrawCommand> sortedCommands;
+  {
+    LIZUAL_PROFILE_SCOPE("Record draw commands");
+    const std::span<const uint16_t> meshIds = state->scene.GetMeshIds();
+    const std::span<const uint16_t> textureIds = state->scene.GetTextureIds();
+    const std::span<const AABB> bounds = state->scene.GetBounds();
+    DrawCommandList& drawCommands = state->drawCommands;
+    drawCommands.Clear();
+    jobs.ParallelFor(
+      numVisible, kInstanceRangeSize, [&](size_t begin, size_t end) {
+        std::vector<DrawCommand>& buffer =
+          drawCommands.GetBuffer(static_cast<size_t>(jobs.GetThreadIndex()));
+        for (size_t i = begin; i < end; ++i) {
+          const uint32_t object = state->visibleObjects[i];
+          const glm::vec4 viewCenter =
+            view * glm::vec4(bounds[object].GetCenter(), 1.0f);
+          const DrawKey key{
+            kScenePass,
+            false,
+            kDefaultProgram,
+            state->textureBatches[textureIds[object]],
+            meshIds[object],
+            -viewCenter.z / camera.farPlane,
+          };
+          buffer.push_back({EncodeSortKey(key), object});
+        }
+      }
+    );
+    sortedCommands = drawCommands.Sort(&jobs);
+    BuildDrawCalls(sortedCommands, state->drawCalls);
+  }
+  // Build the per-instance data in ranges spread over the job system: model
+  // matrices, texture layers and the size on screen, in sorted command order.
+  // Every range writes its own slice of the packet, which is only submitted
+  // once all are done.
+  {
+    LIZUAL_PROFILE_SCOPE("Build instance data");
+    const std::span<const AABB> bounds = state->scene.GetBounds();
+    const std::span<const uint16_t> textureIds = state->scene.GetTextureIds();
+    const float pixelsPerUnitAtOne =
+      static_cast<float>(windowHeight) /
+      (2.0f * std::tan(glm::radians(camera.fieldOfView) * 0.5f));
+    state->sortedVisibleObjects.resize(numVisible);
+    state->visibleTransforms.Resize(numVisible);
+    packet.modelMatrices.resize(numVisible);
+    packet.instanceTextureLayers.resize(numVisible);
+    state->instanceScreenSizes.resize(numVisible);
+    jobs.ParallelFor(
+      numVisible, kInstanceRangeSize, [&](size_t begin, size_t end) {
+        LIZUAL_PROFILE_SCOPE("Build instance range");
+        const std::span<uint32_t> objects = state->sortedVisibleObjects;
+        for (size_t i = begin; i < end; ++i) {
+          objects[i] = sortedCommands[i].object;
+        }
+        state->visibleTransforms.Gather(
+          state->scene.GetTransforms(), objects, begin, end
+        );
+        BuildModelMatrices(
+          state->visibleTransforms,
+          begin,
+          end,
+          packet.modelMatrices.data() + begin
+        );
+        for (size_t i = begin; i < end; ++i) {
+          packet.instanceTextureLayers[i] =
+            state->textureLayers[textureIds[objects[i]]];
+          state->instanceScreenSizes[i] =
+            GetScreenSize(bounds[objects[i]], camera, pixelsPerUnitAtOne);
+        }
+      }
+    );
+  }
+  // The render thread asks for the texture detail each draw call needs: the
+  // closest object decides
+  packet.drawCalls = state->drawCalls;
+  packet.drawScreenSizes.clear();
+  for (const DrawCall& draw : state->drawCalls) {
+    const auto drawSizes =
+      std::span(state->instanceScreenSizes)
+        .subspan(draw.firstInstance, draw.instanceCount);
+    packet.drawScreenSizes.push_back(
+      *std::max_element(drawSizes.begin(), drawSizes.end())
+    );
+  }
 
-  SDL_GL_SwapWindow(state->window);
+  {
+    LIZUAL_PROFILE_SCOPE("Build UI draw data");
+    ImGui::Render();
+    packet.ui.Copy(*ImGui::GetDrawData());
+  }
+  const bool uiTexturesChanged = packet.ui.HasTextureUpdates();
+  state->renderThread->Submit();
+  // The UI's textures are updated as they are drawn, and the next frame's UI
+  // must not touch them until then
+  if (uiTexturesChanged) { state->renderThread->Finish(); }
 
   const uint64_t perfCounterEnd = SDL_GetPerformanceCounter();
   state->previousFrameTimeNs = static_cast<uint64_t>(
@@ -454,6 +1120,15 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
   );
 
   state->previousTickNs = currentTickNs;
+
+  if (state->benchmark != nullptr &&
+      state->benchmark->EndFrame(
+        state->previousFrameTimeNs, feedback.gpu, feedback.glStats
+      )) {
+    return state->benchmark->WriteReport(config::benchmark_output)
+             ? SDL_APP_SUCCESS
+             : SDL_APP_FAILURE;
+  }
   return SDL_APP_CONTINUE;
 }
 
@@ -467,20 +1142,27 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
     return SDL_APP_SUCCESS;
   }
 
-  if (event->type == SDL_EVENT_WINDOW_RESIZED) {
-    int widthInPixels;
-    int heightInPixels;
-    if (!SDL_GetWindowSizeInPixels(
-          state->window, &widthInPixels, &heightInPixels
-        )) {
-      SDL_LogCritical(
-        SDL_LOG_CATEGORY_ERROR,
-        "SDL_GetWindowSizeInPixels failed: %s",
-        SDL_GetError()
-      );
-      return SDL_APP_FAILURE;
-    }
-    glViewport(0, 0, widthInPixels, heightInPixels);
+  // Resizes need no handling here: every render packet carries the viewport
+  // size of its frame
+
+  // Pick the object under the cursor
+  if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN &&
+      event->button.button == SDL_BUTTON_LEFT &&
+      !ImGui::GetIO().WantCaptureMouse) {
+    int windowWidth;
+    int windowHeight;
+    SDL_GetWindowSize(state->window, &windowWidth, &windowHeight);
+    const glm::vec2 ndc{
+      2.0f * event->button.x / windowWidth - 1.0f,
+      1.0f - 2.0f * event->button.y / windowHeight
+    };
+    const Camera& camera = *state->camera;
+    const float aspectRatio = static_cast<float>(windowWidth) / windowHeight;
+    state->pickedObject = state->sceneBVH.Raycast(
+      camera.position,
+      camera.GetRayDirection(ndc, aspectRatio),
+      camera.farPlane
+    );
   }
 
   if (event->type == SDL_EVENT_KEY_DOWN &&
@@ -489,6 +1171,19 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
       case SDL_SCANCODE_ESCAPE:
         SDL_Log("Escape key pressed, quitting.");
         return SDL_APP_SUCCESS;
+      case SDL_SCANCODE_F1:
+        state->profilerWindow.open = !state->profilerWindow.open;
+        break;
+      case SDL_SCANCODE_F2:
+        // Dump whatever the profiler rings still hold
+        Profiler::WriteChromeTrace(
+          std::filesystem::path(SDL_GetBasePath()) /
+          ("trace_" + std::to_string(SDL_GetTicksNS()) + ".json")
+        );
+        break;
+      case SDL_SCANCODE_F3:
+        state->frameStatsWindow.open = !state->frameStatsWindow.open;
+        break;
       default:
         break;
     }
@@ -500,12 +1195,36 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
   AppState* state = static_cast<AppState*>(appstate);
 
-  delete state->shader;
+  state->frameStats.WriteReport(
+    std::filesystem::path(SDL_GetBasePath()) / "frame_stats.json"
+  );
+
+  // Renders what is in flight and hands the context back to this thread.
+  // Without the context, GL objects can't be deleted, so they are left to the
+  // OS along with the UI.
+  const bool hasContext = state->renderThread->Stop();
+  state->renderThread.reset();
+  if (hasContext) {
+    delete state->shader;
+    state->instanceBuffer.reset();
+    state->gpuTimer.reset();
+    state->meshes.clear();
+    state->textureLoader.reset();
+  } else {
+    (void)state->instanceBuffer.release();
+    (void)state->gpuTimer.release();
+    for (std::unique_ptr<Mesh>& mesh : state->meshes) { (void)mesh.release(); }
+    (void)state->textureLoader.release();
+  }
+  state->jobSystem.reset();
+  state->assetArchive.reset();
 
   SDL_Log("Exiting with result: %d", result);
-  ImGui_ImplOpenGL3_Shutdown();
-  ImGui_ImplSDL3_Shutdown();
-  ImGui::DestroyContext();
+  if (hasContext) {
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplSDL3_Shutdown();
+    ImGui::DestroyContext();
+  }
 
   SDL_GL_DestroyContext(state->glContext);
   SDL_DestroyWindow(state->window);
@@ -0,0 +1,149 @@
+// Packs directories of assets into a .lpak archive (see AssetArchive.h), which
+// the app maps at startup instead of opening every file. CMake runs it on the
+// assets directory and the cooked textures at build time.
+//
+// Usage:
+//   lizual_pack <output.lpak> <directory>[=prefix]... [--store]
+// Every file under each directory is packed, named by its path relative to
+// the directory, behind prefix/ if given: assets/shaders/default.vert is
+// "shaders/default.vert", and cooked=cooked makes cooked/container.ltex
+// "cooked/container.ltex". Files that shrink by an eighth or more are LZ4
+// compressed, unless --store keeps every file as it is.
+//
+// Exit code: 0 on success, 1 on errors.
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "AssetArchive.h"
+
+namespace {
+struct Arguments {
+  std::vector<std::string> positional;
+  bool compress = true;
+};
+
+struct PackedFile {
+  std::string name;
+  std::vector<uint8_t> data;
+};
+
+void PrintUsage() {
+  std::fprintf(
+    stderr,
+    "Usage: lizual_pack <output.lpak> <directory>[=prefix]... [--store]\n"
+  );
+}
+
+bool ParseArguments(int argc, char** argv, Arguments& arguments) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument = argv[i];
+    if (!argument.starts_with("--")) {
+      arguments.positional.emplace_back(argument);
+    } else if (argument == "--store") {
+      arguments.compress = false;
+    } else {
+      std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      return false;
+    }
+  }
+  return arguments.positional.size() >= 2;
+}
+
+// Reads every file under the directory named by source ("dir" or
+// "dir=prefix") into files
+bool CollectFiles(std::string_view source, std::vector<PackedFile>& files) {
+  std::filesystem::path directory(source);
+  std::string prefix;
+  if (const size_t equals = source.rfind('='); equals != source.npos) {
+    directory = source.substr(0, equals);
+    prefix = std::string(source.substr(equals + 1)) + "/";
+  }
+  // Listing errors are reported through error, as ++ would throw on an
+  // unreadable subdirectory
+  std::error_code error;
+  std::filesystem::recursive_directory_iterator it(directory, error);
+  const std::filesystem::recursive_directory_iterator end;
+  while (!error && it != end) {
+    if (it->is_regular_file()) {
+      std::ifstream file(it->path(), std::ios::binary);
+      if (!file.is_open()) {
+        std::fprintf(
+          stderr, "Failed to open %s\n", it->path().string().c_str()
+        );
+        return false;
+      }
+      files.push_back(
+        {prefix +
+           std::filesystem::relative(it->path(), directory).generic_string(),
+         {std::istreambuf_iterator<char>(file), {}}}
+      );
+    }
+    it.increment(error);
+  }
+  if (error) {
+    std::fprintf(
+      stderr,
+      "Failed to list %s: %s\n",
+      directory.string().c_str(),
+      error.message().c_str()
+    );
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Arguments arguments;
+  if (!ParseArguments(argc, argv, arguments)) {
+    PrintUsage();
+    return 1;
+  }
+  const std::filesystem::path output = arguments.positional[0];
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<PackedFile> files;
+  for (size_t i = 1; i < arguments.positional.size(); ++i) {
+    if (!CollectFiles(arguments.positional[i], files)) { return 1; }
+  }
+  std::vector<AssetArchiveInput> inputs;
+  size_t totalBytes = 0;
+  for (const PackedFile& file : files) {
+    inputs.push_back({file.name, file.data});
+    totalBytes += file.data.size();
+  }
+
+  std::error_code directoryError;
+  if (output.has_parent_path()) {
+    std::filesystem::create_directories(output.parent_path(), directoryError);
+  }
+  std::string error;
+  if (!AssetArchive::Write(output, inputs, arguments.compress, error)) {
+    std::fprintf(
+      stderr, "Failed to pack %s: %s\n", output.string().c_str(), error.c_str()
+    );
+    return 1;
+  }
+
+  const std::chrono::duration<double, std::milli> elapsed =
+    std::chrono::steady_clock::now() - start;
+  // The archive is written, so a failure to read its size only loses the size
+  std::error_code sizeError;
+  const uintmax_t packedBytes = std::filesystem::file_size(output, sizeError);
+  std::printf(
+    "Packed %zu files, %.1f KB -> %s",
+    files.size(),
+    totalBytes / 1024.0,
+    output.string().c_str()
+  );
+  if (!sizeError) { std::printf(", %.1f KB", packedBytes / 1024.0); }
+  std::printf(" in %.1f ms\n", elapsed.count());
+  return 0;
+}
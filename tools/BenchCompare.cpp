@@ -0,0 +1,448 @@
+// Keeps a history of benchmark reports and compares two of them.
+//
+// Works with both the app's --benchmark reports (per-frame CPU/GPU samples)
+// and lizual_bench reports (per-sample times of each microbenchmark). Each
+// metric present in both runs is compared with a two-sided Mann-Whitney U
+// test, which makes no assumption about the shape of the distributions; frame
+// times are skewed and have long tails, so a t-test would be misled. A metric
+// regresses when the difference is significant and its median got slower by
+// more than the threshold.
+//
+// Usage:
+//   lizual_compare store <report.json> [--label name]
+//   lizual_compare list
+//   lizual_compare compare <baseline> <candidate> [--threshold percent]
+//                                                 [--alpha p]
+// Every command takes [--results-dir dir] (default "bench_results"). Runs are
+// given as report paths, stored run names, or "latest" and "previous".
+//
+// Exit code: 0 when no metric regressed, 1 when one did, 2 on errors.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "JsonReader.h"
+
+namespace {
+constexpr int kExitOk = 0;
+constexpr int kExitRegression = 1;
+constexpr int kExitError = 2;
+
+constexpr double kDefaultThresholdPercent = 5.0;
+constexpr double kDefaultAlpha = 0.01;
+// Below this many samples per run the normal approximation of U is too rough
+// to flag anything
+constexpr size_t kMinSamples = 8;
+
+struct Arguments {
+  std::vector<std::string> positional;
+  std::filesystem::path resultsDir = "bench_results";
+  std::string label;
+  double thresholdPercent = kDefaultThresholdPercent;
+  double alpha = kDefaultAlpha;
+};
+
+// A series of measurements where lower is better
+struct Metric {
+  std::string name;
+  std::vector<double> samples;
+};
+
+struct Run {
+  std::filesystem::path path;
+  JsonValue report;
+};
+
+void PrintUsage() {
+  std::fprintf(
+    stderr,
+    "Usage:\n"
+    "  lizual_compare store <report.json> [--label name]\n"
+    "  lizual_compare list\n"
+    "  lizual_compare compare <baseline> <candidate> [--threshold percent] "
+    "[--alpha p]\n"
+    "Options: --results-dir dir (default bench_results)\n"
+  );
+}
+
+bool ParseArguments(int argc, char** argv, Arguments& arguments) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument = argv[i];
+    if (!argument.starts_with("--")) {
+      arguments.positional.emplace_back(argument);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+      return false;
+    }
+    const char* value = argv[++i];
+    if (argument == "--results-dir") {
+      arguments.resultsDir = value;
+    } else if (argument == "--label") {
+      arguments.label = value;
+    } else if (argument == "--threshold") {
+      arguments.thresholdPercent = std::strtod(value, nullptr);
+    } else if (argument == "--alpha") {
+      arguments.alpha = std::strtod(value, nullptr);
+    } else {
+      std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+      return false;
+    }
+  }
+  return !arguments.positional.empty();
+}
+
+std::optional<JsonValue> LoadReport(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::fprintf(stderr, "Failed to open %s\n", path.string().c_str());
+    return std::nullopt;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  std::string error;
+  std::optional<JsonValue> report = JsonValue::Parse(contents.str(), error);
+  if (!report) {
+    std::fprintf(
+      stderr, "Failed to parse %s: %s\n", path.string().c_str(), error.c_str()
+    );
+  }
+  return report;
+}
+
+std::vector<double> ToSamples(const JsonValue& array) {
+  std::vector<double> samples;
+  for (const JsonValue& element : array.GetElements()) {
+    if (element.IsNumber()) { samples.push_back(element.AsNumber()); }
+  }
+  return samples;
+}
+
+std::vector<Metric> ExtractMetrics(const JsonValue& report) {
+  std::vector<Metric> metrics;
+  // App benchmark: {"samples": {"cpu_frame_ms": [...], ...}}
+  if (const JsonValue* samples = report.Find("samples")) {
+    const std::vector<std::string>& keys = samples->GetKeys();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      metrics.push_back({keys[i], ToSamples(samples->GetValues()[i])});
+    }
+  }
+  // lizual_bench: {"benchmarks": [{"name": ..., "samples_ns": [...]}, ...]}
+  if (const JsonValue* benchmarks = report.Find("benchmarks")) {
+    for (const JsonValue& benchmark : benchmarks->GetElements()) {
+      const JsonValue* name = benchmark.Find("name");
+      const JsonValue* samples = benchmark.Find("samples_ns");
+      if (name == nullptr || samples == nullptr) { continue; }
+      metrics.push_back({name->AsString(), ToSamples(*samples)});
+    }
+  }
+  // Runs without GPU timer results have empty series
+  std::erase_if(metrics, [](const Metric& metric) {
+    return metric.samples.empty();
+  });
+  return metrics;
+}
+
+// The field from the top level or the microbenchmark context, for telling
+// runs on different drivers apart
+std::string GetContextString(const JsonValue& report, std::string_view key) {
+  if (const JsonValue* value = report.Find(key)) { return value->AsString(); }
+  if (const JsonValue* context = report.Find("context")) {
+    if (const JsonValue* value = context->Find(key)) {
+      return value->AsString();
+    }
+  }
+  return "";
+}
+
+double Median(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  const size_t count = samples.size();
+  return count % 2 == 1 ? samples[count / 2]
+                        : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+}
+
+// Two-sided p-value of the Mann-Whitney U test, from the normal approximation
+// with tie and continuity corrections
+double MannWhitneyPValue(
+  const std::vector<double>& a, const std::vector<double>& b
+) {
+  struct Sample {
+    double value;
+    bool fromA;
+  };
+  std::vector<Sample> pooled;
+  pooled.reserve(a.size() + b.size());
+  for (const double value : a) { pooled.push_back({value, true}); }
+  for (const double value : b) { pooled.push_back({value, false}); }
+  std::sort(pooled.begin(), pooled.end(), [](const Sample& l, const Sample& r) {
+    return l.value < r.value;
+  });
+
+  // Rank sum of a, with tied values sharing their average rank
+  const double n = static_cast<double>(pooled.size());
+  double rankSumA = 0.0;
+  double tieCorrection = 0.0;
+  for (size_t first = 0; first < pooled.size();) {
+    size_t last = first + 1;
+    while (last < pooled.size() && pooled[last].value == pooled[first].value) {
+      ++last;
+    }
+    const double averageRank = 0.5 * static_cast<double>(first + 1 + last);
+    for (size_t i = first; i < last; ++i) {
+      if (pooled[i].fromA) { rankSumA += averageRank; }
+    }
+    const double ties = static_cast<double>(last - first);
+    tieCorrection += ties * ties * ties - ties;
+    first = last;
+  }
+
+  const double na = static_cast<double>(a.size());
+  const double nb = static_cast<double>(b.size());
+  const double u = rankSumA - na * (na + 1.0) / 2.0;
+  const double mean = na * nb / 2.0;
+  const double variance =
+    na * nb / 12.0 * ((n + 1.0) - tieCorrection / (n * (n - 1.0)));
+  // Every sample equal
+  if (variance <= 0.0) { return 1.0; }
+  const double distance = std::max(std::abs(u - mean) - 0.5, 0.0);
+  const double z = distance / std::sqrt(variance);
+  return std::erfc(z / std::sqrt(2.0));
+}
+
+// Stored runs, oldest first. Names start with a UTC timestamp, so name order
+// is time order.
+std::vector<std::filesystem::path> ListStoredRuns(
+  const std::filesystem::path& resultsDir
+) {
+  std::vector<std::filesystem::path> runs;
+  std::error_code error;
+  for (const std::filesystem::directory_entry& entry :
+       std::filesystem::directory_iterator(resultsDir, error)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".json") {
+      runs.push_back(entry.path());
+    }
+  }
+  std::sort(runs.begin(), runs.end());
+  return runs;
+}
+
+std::optional<std::filesystem::path> ResolveRun(
+  std::string_view reference, const std::filesystem::path& resultsDir
+) {
+  if (reference == "latest" || reference == "previous") {
+    const std::vector<std::filesystem::path> runs = ListStoredRuns(resultsDir);
+    const size_t back = reference == "latest" ? 1 : 2;
+    if (runs.size() >= back) { return runs[runs.size() - back]; }
+    std::fprintf(
+      stderr,
+      "Not enough stored runs in %s for \"%s\"\n",
+      resultsDir.string().c_str(),
+      std::string(reference).c_str()
+    );
+    return std::nullopt;
+  }
+  const std::filesystem::path candidates[] = {
+    std::filesystem::path(reference),
+    resultsDir / reference,
+    resultsDir / (std::string(reference) + ".json"),
+  };
+  for (const std::filesystem::path& candidate : candidates) {
+    if (std::filesystem::is_regular_file(candidate)) { return candidate; }
+  }
+  std::fprintf(
+    stderr, "No report or stored run named %s\n", std::string(reference).c_str()
+  );
+  return std::nullopt;
+}
+
+std::optional<Run> LoadRun(
+  std::string_view reference, const std::filesystem::path& resultsDir
+) {
+  const std::optional<std::filesystem::path> path =
+    ResolveRun(reference, resultsDir);
+  if (!path) { return std::nullopt; }
+  std::optional<JsonValue> report = LoadReport(*path);
+  if (!report) { return std::nullopt; }
+  return Run{*path, std::move(*report)};
+}
+
+std::string MakeRunName(std::string_view label) {
+  const std::time_t now = std::time(nullptr);
+  char timestamp[32];
+  std::strftime(
+    timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::gmtime(&now)
+  );
+  std::string name = timestamp;
+  if (!label.empty()) {
+    name += '_';
+    for (const char c : label) {
+      const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                        (c >= '0' && c <= '9') || c == '-' || c == '.';
+      name += safe ? c : '_';
+    }
+  }
+  return name + ".json";
+}
+
+int Store(const Arguments& arguments) {
+  if (arguments.positional.size() != 2) {
+    PrintUsage();
+    return kExitError;
+  }
+  const std::filesystem::path source = arguments.positional[1];
+  const std::optional<JsonValue> report = LoadReport(source);
+  if (!report) { return kExitError; }
+  if (ExtractMetrics(*report).empty()) {
+    std::fprintf(
+      stderr, "%s has no samples to compare\n", source.string().c_str()
+    );
+    return kExitError;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(arguments.resultsDir, error);
+  const std::filesystem::path destination =
+    arguments.resultsDir / MakeRunName(arguments.label);
+  if (!std::filesystem::copy_file(source, destination, error)) {
+    std::fprintf(
+      stderr,
+      "Failed to copy %s to %s: %s\n",
+      source.string().c_str(),
+      destination.string().c_str(),
+      error.message().c_str()
+    );
+    return kExitError;
+  }
+  std::printf("Stored %s\n", destination.string().c_str());
+  return kExitOk;
+}
+
+int List(const Arguments& arguments) {
+  for (const std::filesystem::path& path :
+       ListStoredRuns(arguments.resultsDir)) {
+    const std::optional<JsonValue> report = LoadReport(path);
+    if (!report) { continue; }
+    std::printf(
+      "%-40s %s | %s\n",
+      path.stem().string().c_str(),
+      GetContextString(*report, "renderer").c_str(),
+      GetContextString(*report, "gl_version").c_str()
+    );
+  }
+  return kExitOk;
+}
+
+int Compare(const Arguments& arguments) {
+  if (arguments.positional.size() != 3) {
+    PrintUsage();
+    return kExitError;
+  }
+  const std::optional<Run> baseline =
+    LoadRun(arguments.positional[1], arguments.resultsDir);
+  const std::optional<Run> candidate =
+    LoadRun(arguments.positional[2], arguments.resultsDir);
+  if (!baseline || !candidate) { return kExitError; }
+
+  std::printf(
+    "baseline:  %s (%s)\ncandidate: %s (%s)\n",
+    baseline->path.string().c_str(),
+    GetContextString(baseline->report, "renderer").c_str(),
+    candidate->path.string().c_str(),
+    GetContextString(candidate->report, "renderer").c_str()
+  );
+  std::printf(
+    "Regression: slower by more than %.1f%% with p < %g\n\n",
+    arguments.thresholdPercent,
+    arguments.alpha
+  );
+  std::printf(
+    "%-44s %14s %14s %9s %10s\n",
+    "metric",
+    "baseline",
+    "candidate",
+    "change",
+    "p"
+  );
+
+  const std::vector<Metric> baselineMetrics = ExtractMetrics(baseline->report);
+  const std::vector<Metric> candidateMetrics =
+    ExtractMetrics(candidate->report);
+  size_t compared = 0;
+  size_t regressions = 0;
+  for (const Metric& before : baselineMetrics) {
+    const auto after = std::find_if(
+      candidateMetrics.begin(),
+      candidateMetrics.end(),
+      [&](const Metric& metric) { return metric.name == before.name; }
+    );
+    if (after == candidateMetrics.end()) { continue; }
+    ++compared;
+
+    const double beforeMedian = Median(before.samples);
+    const double afterMedian = Median(after->samples);
+    const double changePercent =
+      beforeMedian != 0.0
+        ? 100.0 * (afterMedian - beforeMedian) / beforeMedian
+        : 0.0;
+    const double p = MannWhitneyPValue(before.samples, after->samples);
+    const bool enoughSamples = before.samples.size() >= kMinSamples &&
+                               after->samples.size() >= kMinSamples;
+    const bool significant = enoughSamples && p < arguments.alpha;
+
+    const char* verdict = "";
+    if (!enoughSamples) {
+      verdict = "too few samples";
+    } else if (significant && changePercent > arguments.thresholdPercent) {
+      verdict = "REGRESSION";
+      ++regressions;
+    } else if (significant && changePercent < -arguments.thresholdPercent) {
+      verdict = "improvement";
+    }
+    std::printf(
+      "%-44s %14.4f %14.4f %+8.2f%% %10.2g%s%s\n",
+      before.name.c_str(),
+      beforeMedian,
+      afterMedian,
+      changePercent,
+      p,
+      verdict[0] != '\0' ? "  " : "",
+      verdict
+    );
+  }
+
+  if (compared == 0) {
+    std::fprintf(stderr, "The runs have no metrics in common\n");
+    return kExitError;
+  }
+  std::printf("\n%zu of %zu metrics regressed\n", regressions, compared);
+  return regressions > 0 ? kExitRegression : kExitOk;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Arguments arguments;
+  if (!ParseArguments(argc, argv, arguments)) {
+    PrintUsage();
+    return kExitError;
+  }
+
+  const std::string& command = arguments.positional[0];
+  if (command == "store") { return Store(arguments); }
+  if (command == "list") { return List(arguments); }
+  if (command == "compare") { return Compare(arguments); }
+  std::fprintf(stderr, "Unknown command: %s\n", command.c_str());
+  PrintUsage();
+  return kExitError;
+}
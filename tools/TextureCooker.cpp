@@ -0,0 +1,216 @@
+// Cooks an image (anything stb_image reads) into a .ltex texture: a full mip
+// chain filtered by GenerateMipChain, in RGBA8 or block compressed, ready for
+// the app to map and upload without decoding. CMake runs it on the app's
+// textures at build time.
+//
+// Usage:
+//   lizual_cook <input image> <output.ltex> [--flip-vertically] [--linear]
+//               [--clamp] [--format rgba8|bc1|bc3|bc7]
+//               [--quality fast|normal|high] [--threads count]
+// --flip-vertically stores the image bottom row first, as GL expects, for
+// images authored top row first. --linear filters the values as they are, for
+// data textures that aren't sRGB color. --clamp filters edges as
+// GL_CLAMP_TO_EDGE instead of GL_REPEAT. --format picks the stored format
+// (default rgba8), and --quality and --threads the block encoder's speed
+// tier and thread count (default the core count). Compressed
+// textures are reported with the PSNR of their base level and the encoder's
+// throughput.
+//
+// Exit code: 0 on success, 1 on errors.
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "TextureFile.h"
+
+namespace {
+struct Arguments {
+  std::vector<std::string> positional;
+  bool flipVertically = false;
+  MipSettings mipSettings;
+  TextureFormat format = TextureFormat::kRGBA8;
+  BlockSettings blockSettings;
+  unsigned threadCount = 0;
+};
+
+void PrintUsage() {
+  std::fprintf(
+    stderr,
+    "Usage: lizual_cook <input image> <output.ltex> [--flip-vertically] "
+    "[--linear] [--clamp] [--format rgba8|bc1|bc3|bc7] "
+    "[--quality fast|normal|high] [--threads count]\n"
+  );
+}
+
+bool ParseArguments(int argc, char** argv, Arguments& arguments) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument = argv[i];
+    if (!argument.starts_with("--")) {
+      arguments.positional.emplace_back(argument);
+    } else if (argument == "--flip-vertically") {
+      arguments.flipVertically = true;
+    } else if (argument == "--linear") {
+      arguments.mipSettings.srgb = false;
+    } else if (argument == "--clamp") {
+      arguments.mipSettings.wrap = false;
+    } else {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+        return false;
+      }
+      const char* value = argv[++i];
+      if (argument == "--format") {
+        const std::optional<TextureFormat> format = ParseTextureFormat(value);
+        if (!format) {
+          std::fprintf(stderr, "Unknown format: %s\n", value);
+          return false;
+        }
+        arguments.format = *format;
+      } else if (argument == "--quality") {
+        const std::optional<BlockQuality> quality = ParseBlockQuality(value);
+        if (!quality) {
+          std::fprintf(stderr, "Unknown quality: %s\n", value);
+          return false;
+        }
+        arguments.blockSettings.quality = *quality;
+      } else if (argument == "--threads") {
+        arguments.threadCount =
+          static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+      } else {
+        std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+        return false;
+      }
+    }
+  }
+  return arguments.positional.size() == 2;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Arguments arguments;
+  if (!ParseArguments(argc, argv, arguments)) {
+    PrintUsage();
+    return 1;
+  }
+  const std::filesystem::path input = arguments.positional[0];
+  const std::filesystem::path output = arguments.positional[1];
+  const auto start = std::chrono::steady_clock::now();
+
+  stbi_set_flip_vertically_on_load(arguments.flipVertically);
+  int width;
+  int height;
+  int channels;
+  unsigned char* data =
+    stbi_load(input.string().c_str(), &width, &height, &channels, 4);
+  if (data == nullptr) {
+    std::fprintf(
+      stderr,
+      "Failed to load %s: %s\n",
+      input.string().c_str(),
+      stbi_failure_reason()
+    );
+    return 1;
+  }
+  const std::vector<MipLevel> mips = GenerateMipChain(
+    {data, static_cast<size_t>(width) * height * 4},
+    width,
+    height,
+    arguments.mipSettings
+  );
+  stbi_image_free(data);
+
+  // Block compressed levels, if any, encoded one after another with the
+  // blocks of each spread over the job system
+  std::vector<std::vector<uint8_t>> compressed;
+  double encodeMs = 0.0;
+  size_t encodedPixels = 0;
+  unsigned threadCount = 0;
+  if (IsBlockCompressed(arguments.format)) {
+    // The cooker's own thread encodes too, so it counts as one of them
+    std::optional<JobSystem> jobs;
+    if (arguments.threadCount != 1) {
+      jobs.emplace(JobSystemSettings{
+        arguments.threadCount == 0 ? 0 : arguments.threadCount - 1
+      });
+    }
+    threadCount = jobs ? static_cast<unsigned>(jobs->GetThreadCount()) : 1;
+    const auto encodeStart = std::chrono::steady_clock::now();
+    for (const MipLevel& mip : mips) {
+      compressed.push_back(CompressImage(
+        mip.pixels,
+        mip.width,
+        mip.height,
+        arguments.format,
+        arguments.blockSettings,
+        jobs ? &*jobs : nullptr
+      ));
+      encodedPixels += static_cast<size_t>(mip.width) * mip.height;
+    }
+    const std::chrono::duration<double, std::milli> encodeElapsed =
+      std::chrono::steady_clock::now() - encodeStart;
+    encodeMs = encodeElapsed.count();
+  }
+
+  std::vector<TextureLevel> levels;
+  size_t totalBytes = 0;
+  for (size_t i = 0; i < mips.size(); ++i) {
+    const MipLevel& mip = mips[i];
+    const std::span<const uint8_t> levelData =
+      compressed.empty() ? std::span(mip.pixels) : std::span(compressed[i]);
+    levels.push_back({mip.width, mip.height, levelData});
+    totalBytes += levelData.size();
+  }
+  std::error_code directoryError;
+  if (output.has_parent_path()) {
+    std::filesystem::create_directories(output.parent_path(), directoryError);
+  }
+  std::string error;
+  if (!TextureFile::Write(output, arguments.format, levels, error)) {
+    std::fprintf(
+      stderr, "Failed to cook %s: %s\n", input.string().c_str(), error.c_str()
+    );
+    return 1;
+  }
+
+  const std::chrono::duration<double, std::milli> elapsed =
+    std::chrono::steady_clock::now() - start;
+  std::printf(
+    "Cooked %s -> %s: %dx%d, %zu levels, %s, %.1f KB in %.1f ms\n",
+    input.filename().string().c_str(),
+    output.string().c_str(),
+    width,
+    height,
+    levels.size(),
+    GetTextureFormatName(arguments.format),
+    totalBytes / 1024.0,
+    elapsed.count()
+  );
+  if (!compressed.empty()) {
+    const std::vector<uint8_t> decoded = DecompressImage(
+      compressed[0], mips[0].width, mips[0].height, arguments.format
+    );
+    // BC1 drops alpha, so only its color is compared
+    const bool hasAlpha = arguments.format != TextureFormat::kBC1;
+    std::printf(
+      "  %s quality: PSNR %.2f dB %s, encoded %.1f MPix/s on %u threads\n",
+      GetBlockQualityName(arguments.blockSettings.quality),
+      ComputePsnr(mips[0].pixels, decoded, hasAlpha),
+      hasAlpha ? "RGBA" : "RGB",
+      encodedPixels / (encodeMs * 1000.0),
+      threadCount
+    );
+  }
+  return 0;
+}